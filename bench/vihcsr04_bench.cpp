@@ -0,0 +1,411 @@
+/**
+ * @file vihcsr04_bench.cpp
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Benchmarks of HC-SR04 ultrasonic distance sensor control driver (c and c++ realisation).
+ *   Every result is printed as csv line: library,benchmark,sensors,iterations,ns_per_op,ops_per_s.
+ *   Costs of simulator callbacks are included in runtime and end-to-end benchmarks
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <array>
+#include <vector>
+
+#include "vihcsr04.h"
+#include "vihcsr04.hpp"
+#include "vihcsr04_array.hpp"
+#include "vihcsr04_batch.h"
+#include "vihcsr04_sim.h"
+
+namespace {
+
+  constexpr uint32_t SENSOR_COUNTS[] = {1, 4, 16, 64, 256};
+  constexpr uint16_t ECHO_PIN_OFFSET = 1000;
+
+  uint32_t iterations = 100000;
+  volatile uint64_t sink;
+
+  /**
+   * @brief Measure average time of one call and print csv line
+   * 
+   * @param library "c", "cpp" or "array"
+   * @param name Benchmark name
+   * @param sensors Number of created sensors
+   * @param count Number of calls
+   * @param func Called function, gets call index
+   */
+  template<typename F>
+  void Bench(const char* library, const char* name, uint32_t sensors, 
+      uint32_t count, F&& func) {
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < count; i++)
+      func(i);
+
+    std::chrono::duration<double, std::nano> elapsed = 
+      std::chrono::steady_clock::now() - start;
+    double nsPerOp = elapsed.count() / count;
+
+    printf("%s,%s,%u,%u,%.1f,%.0f\n", library, name, sensors, count, 
+      nsPerOp, 1e9 / nsPerOp);
+  }
+
+  int NoPrintf(const char*, ...) {
+    return 0;
+  }
+
+  void NoDistance(float distance, const void*) {
+    sink = sink + (uint64_t)distance;
+  }
+
+  void NoDistanceMm(uint32_t distanceMm, const void*) {
+    sink = sink + distanceMm;
+  }
+
+  std::string Name(uint32_t index) {
+    return "HC-SR04 " + std::to_string(index);
+  }
+
+  /**
+   * @brief Reset simulator with sensors at different distances, 
+   *   trigger pin is the sensor index, echo pin index + ECHO_PIN_OFFSET
+   * 
+   * @param sensors Number of sensors
+   */
+  void SimSetup(uint32_t sensors) {
+    VIHCSR04_SimInit(1);
+    VIHCSR04_SimSetEdgeCb(nullptr);
+    for (uint32_t i = 0; i < sensors; i++) {
+      VIHCSR04_SimAddSensor(nullptr, i, nullptr, ECHO_PIN_OFFSET + i);
+      VIHCSR04_SimSetDistance(i, 300 + 10 * i);
+    }
+  }
+
+  void CSetup(uint32_t sensors, bool edgeDriven, 
+      std::vector<VIHCSR04_Handle_t>& handles) {
+    SimSetup(sensors);
+    if (edgeDriven) {
+      VIHCSR04_SimSetEdgeCb(VIHCSR04_EchoEdge);
+      VIHCSR04_InitEdgeDriven(VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs);
+    } else {
+      VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger);
+    }
+    handles.clear();
+    for (uint32_t i = 0; i < sensors; i++)
+      handles.push_back(VIHCSR04_Create(Name(i).c_str(), 
+        nullptr, i, nullptr, ECHO_PIN_OFFSET + i));
+  }
+
+  void BenchC(void) {
+    std::vector<VIHCSR04_Handle_t> handles;
+
+    for (uint32_t sensors : SENSOR_COUNTS) {
+      if (sensors > VIHCSR04_MAX_SENSORS)
+        break;
+
+      CSetup(sensors, false, handles);
+      std::string last = Name(sensors - 1);
+
+      Bench("c", "GetHandle", sensors, iterations, [&](uint32_t) {
+        sink = VIHCSR04_GetHandle(last.c_str());
+      });
+      Bench("c", "MeasureDistanceAsync", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_MeasureDistanceAsync(last.c_str(), VIHCSR04_CONTINUOUS_MEASURE, 
+          20, 400, NoDistance, nullptr);
+      });
+      Bench("c", "MeasureDistanceAsyncByHandle", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_MeasureDistanceAsyncByHandle(handles.back(), VIHCSR04_CONTINUOUS_MEASURE, 
+          20, 400, NoDistance, nullptr);
+      });
+      Bench("c", "MeasureDistanceMmAsyncByHandle", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_MeasureDistanceMmAsyncByHandle(handles.back(), VIHCSR04_CONTINUOUS_MEASURE, 
+          20, 400, NoDistanceMm, nullptr);
+      });
+      Bench("c", "StopContinuousMeasure", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_StopContinuousMeasure(last.c_str());
+      });
+      Bench("c", "StopContinuousMeasureByHandle", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_StopContinuousMeasureByHandle(handles.back());
+      });
+      Bench("c", "SetFiringGroupByHandle", sensors, iterations, [&](uint32_t i) {
+        VIHCSR04_SetFiringGroupByHandle(handles.back(), (uint16_t)i);
+      });
+      Bench("c", "MeasureDistance", sensors, iterations, [&](uint32_t) {
+        sink = sink + (uint64_t)VIHCSR04_MeasureDistance(last.c_str(), 20, 400);
+      });
+      Bench("c", "MeasureDistanceMmByHandle", sensors, iterations, [&](uint32_t) {
+        sink = sink + VIHCSR04_MeasureDistanceMmByHandle(handles.back(), 20, 400);
+      });
+
+      for (auto handle : handles)
+        VIHCSR04_MeasureDistanceMmAsyncByHandle(handle, VIHCSR04_CONTINUOUS_MEASURE, 
+          20, 400, NoDistanceMm, nullptr);
+
+      Bench("c", "Runtime", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_Runtime();
+      });
+
+      VIHCSR04_SetPrintfCb(NoPrintf);
+      VIHCSR04_SetDebugLvl(VIHCSR04_DEBUG_INFO);
+      Bench("c", "RuntimeDebugInfo", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_Runtime();
+      });
+      VIHCSR04_SetPrintfCb(nullptr);
+
+      // records are drained in every call to keep buffer from overflow
+      static VIHCSR04_LogRecord_t log[16];
+      VIHCSR04_LogRecord_t records[16];
+      VIHCSR04_SetLogBuffer(log, 16);
+      Bench("c", "RuntimeDeferredLog", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_Runtime();
+        VIHCSR04_DrainLog(records, 16);
+      });
+      VIHCSR04_SetLogBuffer(nullptr, 0);
+      VIHCSR04_SetDebugLvl(VIHCSR04_DEBUG_DISABLED);
+
+      Bench("c", "CreateDelete", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_Handle_t handle = VIHCSR04_Create("tmp", nullptr, 0, nullptr, 0);
+        VIHCSR04_DeleteByHandle(handle);
+      });
+
+      // edge driven runtime scans all sensors, every sensor has its own firing group
+      CSetup(sensors, true, handles);
+      for (auto handle : handles)
+        VIHCSR04_MeasureDistanceMmAsyncByHandle(handle, VIHCSR04_CONTINUOUS_MEASURE, 
+          20, 400, NoDistanceMm, nullptr);
+
+      Bench("c", "RuntimeEdgeDriven", sensors, iterations, [&](uint32_t) {
+        VIHCSR04_Runtime();
+      });
+      Bench("c", "EchoEdgeByHandle", sensors, iterations, [&](uint32_t i) {
+        VIHCSR04_EchoEdgeByHandle(handles.back(), i & 1, i);
+      });
+      Bench("c", "EchoEdge", sensors, iterations, [&](uint32_t i) {
+        VIHCSR04_EchoEdge(nullptr, ECHO_PIN_OFFSET + sensors - 1, i & 1, i);
+      });
+
+      // end-to-end: simulated samples per second of wall time
+      static VIHCSR04_Sample_t buffer[1024];
+      VIHCSR04_SetSampleBuffer(buffer, 1024);
+      uint64_t samples = 0;
+      uint64_t startUs = VIHCSR04_SimGetTimeUs();
+      auto start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < iterations * 10; i++) {
+        VIHCSR04_Runtime();
+        VIHCSR04_SimAdvance(10);
+        samples += VIHCSR04_DrainSamples(buffer, 1024);
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      printf("c,EndToEndSamples,%u,%llu,%.1f,%.0f\n", sensors, (unsigned long long)samples, 
+        samples ? elapsed.count() * 1e9 / samples : 0.0, samples / elapsed.count());
+      printf("c,EndToEndVirtualSamples,%u,%llu,0,%.0f\n", sensors, (unsigned long long)samples, 
+        samples * 1e6 / (VIHCSR04_SimGetTimeUs() - startUs));
+      VIHCSR04_SetSampleBuffer(nullptr, 0);
+    }
+
+    VIHCSR04_Conversion_t conv;
+    VIHCSR04_ConversionInit(&conv, 20, 400);
+    Bench("c", "ToCm", 1, iterations, [&](uint32_t i) {
+      sink = sink + (uint64_t)VIHCSR04_ToCm(&conv, i & 0x3FFF);
+    });
+    Bench("c", "ToMm", 1, iterations, [&](uint32_t i) {
+      sink = sink + VIHCSR04_ToMm(&conv, i & 0x3FFF);
+    });
+
+    VIHCSR04_FilterCfg_t cfg = {VIHCSR04_FILTER_MEDIAN | VIHCSR04_FILTER_EMA | 
+      VIHCSR04_FILTER_KALMAN, 5, 2, 1.0f, 100.0f};
+    VIHCSR04_Filter_t filter;
+    VIHCSR04_FilterInit(&filter, &cfg);
+    Bench("c", "FilterApply", 1, iterations, [&](uint32_t i) {
+      sink = sink + VIHCSR04_FilterApply(&filter, 1000 + (i & 0x3F));
+    });
+
+    // batch conversion, one operation converts BATCH samples
+    constexpr uint32_t BATCH = 4096;
+    static uint32_t durations[BATCH], distances[BATCH];
+    static uint16_t convIndex[BATCH];
+    VIHCSR04_Conversion_t convs[4];
+    for (uint32_t i = 0; i < 4; i++)
+      VIHCSR04_ConversionInit(&convs[i], 5.0f * i, 400);
+    for (uint32_t i = 0; i < BATCH; i++) {
+      durations[i] = (i * 7919) % 30000;
+      convIndex[i] = i & 3;
+    }
+
+    std::string kernel = VIHCSR04_BatchKernel();
+    Bench("c", "ToMm4096", 1, iterations / 256 + 1, [&](uint32_t) {
+      for (uint32_t i = 0; i < BATCH; i++)
+        distances[i] = VIHCSR04_ToMm(&convs[0], durations[i]);
+      sink = sink + distances[BATCH - 1];
+    });
+    Bench("c", ("ToMmBatch4096_" + kernel).c_str(), 1, iterations / 256 + 1, [&](uint32_t) {
+      VIHCSR04_ToMmBatch(&convs[0], durations, distances, BATCH);
+      sink = sink + distances[BATCH - 1];
+    });
+    Bench("c", ("ToMmBatchIndexed4096_" + kernel).c_str(), 1, iterations / 256 + 1, [&](uint32_t) {
+      VIHCSR04_ToMmBatchIndexed(convs, convIndex, durations, distances, BATCH);
+      sink = sink + distances[BATCH - 1];
+    });
+  }
+
+  /**
+   * @brief Simulator gpio interface of Hcsr04Array
+   * 
+   */
+  struct SimIo {
+    static void Trigger(uintptr_t port, uint16_t pin) {
+      VIHCSR04_SimTrigger((const void*)port, pin, 1, 10, nullptr);
+    }
+    static uint32_t PulseIn(uintptr_t port, uint16_t pin, uint32_t timeoutUs) {
+      return (uint32_t)VIHCSR04_SimPulseIn((const void*)port, pin, 1, (uint64_t)timeoutUs * 1000, nullptr);
+    }
+    static uint64_t NowUs(void) {
+      return VIHCSR04_SimGetTimeUs();
+    }
+    static void Distance(size_t, uint32_t distanceMm) {
+      sink = sink + distanceMm;
+    }
+  };
+
+  template<size_t N>
+  void BenchArray(void) {
+    std::array<vihcsr04::ArrayPins_t, N> pins{};
+    for (uint32_t i = 0; i < N; i++)
+      pins[i] = {0, (uint16_t)i, 0, (uint16_t)(ECHO_PIN_OFFSET + i)};
+
+    SimSetup(N);
+    static vihcsr04::Hcsr04Array<N, SimIo> array{pins};
+
+    Bench("array", "MeasureDistanceAsyncByHandle", N, iterations, [&](uint32_t) {
+      array.MeasureDistanceMmAsync(N - 1, array.CONTINUOUS_MEASURE, 20, 400);
+    });
+    Bench("array", "MeasureDistanceMmByHandle", N, iterations, [&](uint32_t) {
+      sink = sink + array.MeasureDistanceMm(N - 1, 20, 400);
+    });
+    for (uint32_t i = 0; i < N; i++)
+      array.MeasureDistanceMmAsync(i, array.CONTINUOUS_MEASURE, 20, 400);
+    Bench("array", "Runtime", N, iterations, [&](uint32_t) {
+      array.Runtime();
+    });
+
+    SimSetup(N);
+    static vihcsr04::Hcsr04Array<N, SimIo, true> edgeArray{pins};
+    for (uint32_t i = 0; i < N; i++)
+      edgeArray.MeasureDistanceMmAsync(i, edgeArray.CONTINUOUS_MEASURE, 20, 400);
+    Bench("array", "RuntimeEdgeDriven", N, iterations, [&](uint32_t) {
+      edgeArray.Runtime();
+    });
+  }
+
+  void BenchCpp(void) {
+    for (uint32_t sensors : SENSOR_COUNTS) {
+      SimSetup(sensors);
+
+      vihcsr04::Hcsr04Sensor driver{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+      std::vector<vihcsr04::Handle_t> handles;
+      for (uint32_t i = 0; i < sensors; i++)
+        handles.push_back(driver.AddSensor(Name(i), nullptr, i, nullptr, ECHO_PIN_OFFSET + i));
+      std::string last = Name(sensors - 1);
+
+      Bench("cpp", "GetHandle", sensors, iterations, [&](uint32_t) {
+        sink = driver.GetHandle(last);
+      });
+      Bench("cpp", "MeasureDistanceAsync", sensors, iterations, [&](uint32_t) {
+        driver.MeasureDistanceAsync(last, vihcsr04::CONTINUOUS_MEASURE, 
+          20, 400, NoDistance, nullptr);
+      });
+      Bench("cpp", "MeasureDistanceAsyncByHandle", sensors, iterations, [&](uint32_t) {
+        driver.MeasureDistanceAsync(handles.back(), vihcsr04::CONTINUOUS_MEASURE, 
+          20, 400, NoDistance, nullptr);
+      });
+      Bench("cpp", "StopContinuousMeasure", sensors, iterations, [&](uint32_t) {
+        driver.StopContinuousMeasure(last);
+      });
+      Bench("cpp", "MeasureDistance", sensors, iterations, [&](uint32_t) {
+        sink = sink + (uint64_t)driver.MeasureDistance(last, 20, 400);
+      });
+      Bench("cpp", "MeasureDistanceMmByHandle", sensors, iterations, [&](uint32_t) {
+        sink = sink + driver.MeasureDistanceMm(handles.back(), 20, 400);
+      });
+
+      for (auto handle : handles)
+        driver.MeasureDistanceMmAsync(handle, vihcsr04::CONTINUOUS_MEASURE, 
+          20, 400, NoDistanceMm, nullptr);
+
+      Bench("cpp", "Runtime", sensors, iterations, [&](uint32_t) {
+        driver.Runtime();
+      });
+
+      driver.SetPrintfCb(NoPrintf);
+      driver.SetDebugLvl(vihcsr04::DEBUG_INFO);
+      Bench("cpp", "RuntimeDebugInfo", sensors, iterations, [&](uint32_t) {
+        driver.Runtime();
+      });
+
+      vihcsr04::LogRecord_t records[16];
+      driver.SetLogBuffer(16);
+      Bench("cpp", "RuntimeDeferredLog", sensors, iterations, [&](uint32_t) {
+        driver.Runtime();
+        driver.DrainLog(records, 16);
+      });
+      driver.SetLogBuffer(0);
+      driver.SetDebugLvl(vihcsr04::DEBUG_DISABLED);
+
+      Bench("cpp", "AddDeleteSensor", sensors, iterations, [&](uint32_t) {
+        driver.DeleteSensor(driver.AddSensor("tmp", nullptr, 0, nullptr, 0));
+      });
+
+      SimSetup(sensors);
+      VIHCSR04_SimSetEdgeCb(nullptr);
+      vihcsr04::Hcsr04Sensor edgeDriver{VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs, sensors};
+      for (uint32_t i = 0; i < sensors; i++)
+        edgeDriver.MeasureDistanceMmAsync(
+          edgeDriver.AddSensor(Name(i), nullptr, i, nullptr, ECHO_PIN_OFFSET + i), 
+          vihcsr04::CONTINUOUS_MEASURE, 20, 400, NoDistanceMm, nullptr);
+
+      Bench("cpp", "RuntimeEdgeDriven", sensors, iterations, [&](uint32_t) {
+        edgeDriver.Runtime();
+      });
+    }
+  }
+}
+
+int main(int argc, const char* argv[]) {
+
+  if (argc > 1)
+    iterations = (uint32_t)strtoul(argv[1], nullptr, 0);
+
+  if (0 == iterations)
+    iterations = 1;
+
+  printf("library,benchmark,sensors,iterations,ns_per_op,ops_per_s\n");
+
+  BenchC();
+  BenchCpp();
+  BenchArray<1>();
+  BenchArray<4>();
+  BenchArray<16>();
+  BenchArray<64>();
+  BenchArray<256>();
+
+  return 0;
+}
@@ -22,6 +22,10 @@
 #ifndef VIHCSR04_H
 #define VIHCSR04_H
 
+#ifdef __cplusplus
+  #include <atomic>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,9 +34,18 @@ extern "C" {
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "vihcsr04_math.h"
+#include "vihcsr04_filter.h"
+#include "vihcsr04_event.h"
+#include "vihcsr04_sched.h"
+#include "vihcsr04_trigger.h"
+#include "vihcsr04_stats.h"
+#include "vihcsr04_log.h"
+#include "vihcsr04_core.h"
+
 /** 
- * @brief Maximal length of a sensor name.
- *   All names longer this limit will be cutted until this limit
+ * @brief Size of sensor name buffer including terminating zero.
+ *   All names longer VIHCSR04_NAME_LEN - 1 will be cutted until this limit
  * */ 
 #if !defined(VIHCSR04_NAME_LEN)
   #define VIHCSR04_NAME_LEN 15     
@@ -46,31 +59,104 @@ extern "C" {
   #define VIHCSR04_MAX_SENSORS 1   
 #endif
 
+#if VIHCSR04_MAX_SENSORS > 0xFFFF
+  #error "VIHCSR04_MAX_SENSORS is limited by 16 bit sensor index of VIHCSR04_Handle_t"
+#endif
+
 /**
- * @brief Debug level
+ * @brief Invalid sensor handle, returned if sensor can not be created or found
  * 
  */
-typedef enum {
-  VIHCSR04_DEBUG_DISABLED = 0,  
-  VIHCSR04_DEBUG_INFO
-} VIHCSR04_DebugLvl_t;
+#define VIHCSR04_INVALID_HANDLE 0
+
+/**
+ * @brief Atomic counter of lock-free queues and word of shared memory. 
+ *   Structures with these members are shared by c and c++ code, 
+ *   so both atomic types must have the layout of a plain uint32_t
+ * 
+ */
+#if defined(__cplusplus)
+  #define VIHCSR04_ATOMIC_U32 std::atomic<uint32_t>
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && 
+    alignof(std::atomic<uint32_t>) == alignof(uint32_t) && 
+    std::atomic<uint32_t>::is_always_lock_free, 
+    "std::atomic<uint32_t> must have the layout of uint32_t");
+#else
+  #define VIHCSR04_ATOMIC_U32 _Atomic uint32_t
+  _Static_assert(sizeof(_Atomic uint32_t) == sizeof(uint32_t) && 
+    _Alignof(_Atomic uint32_t) == _Alignof(uint32_t), 
+    "_Atomic uint32_t must have the layout of uint32_t");
+#endif
+
+/**
+ * @brief Sensor handle: slot index in lower 16 bits and slot generation in upper 16 bits.
+ *   Handle becomes stale after sensor is deleted, all calls with stale handle fail
+ * 
+ */
+typedef uint32_t VIHCSR04_Handle_t;
+
+/**
+ * @brief Measurement record stored in sample buffer
+ * 
+ */
+typedef struct {
+  VIHCSR04_Handle_t handle;     /*!< handle of measured sensor */
+  uint32_t durationUs;          /*!< echo duration in microseconds, 0 if timeout */
+  uint32_t distanceMm;          /*!< distance in mm or VIHCSR04_INVALID_DISTANCE_MM */
+  uint64_t timestampUs;         /*!< time of measurement completion, 0 if no time source is set */
+} VIHCSR04_Sample_t;
 
 typedef enum {
   VIHCSR04_ONESHOT_MEASURE = 0,  
   VIHCSR04_CONTINUOUS_MEASURE
 } VIHCSR04_MeasureMode_t;
 
-typedef uint64_t (*VIHCSR04_PulseIn_t)(
-  const void* gpio, uint16_t port, uint8_t state, 
-  uint64_t maxDurationTreshold, const void* context);
+typedef void (*VIHCSR04_Created_t) (VIHCSR04_Handle_t handle, const void* context);
 
-typedef void (*VIHCSR04_TriggerPort_t) (
-  const void* gpio, uint16_t port, uint8_t state, 
-  uint64_t pulseDuration, const void* context);
+/**
+ * @brief Type of command posted to command queue
+ * 
+ */
+typedef enum {
+  VIHCSR04_CMD_CREATE = 0,      /*!< create sensor, see VIHCSR04_Create */
+  VIHCSR04_CMD_DELETE,          /*!< delete sensor, see VIHCSR04_DeleteByHandle */
+  VIHCSR04_CMD_MEASURE,         /*!< start measurement, see VIHCSR04_MeasureDistanceMmAsyncByHandle */
+  VIHCSR04_CMD_STOP,            /*!< stop measurement, see VIHCSR04_StopContinuousMeasureByHandle */
+  VIHCSR04_CMD_CONFIGURE        /*!< change temperature and range of running measurement */
+} VIHCSR04_CommandType_t;
 
-typedef void (*VIHCSR04_Distance_t) (float distance, const void* context);
+/**
+ * @brief Cell of command queue, filled by VIHCSR04_Post... functions
+ * 
+ */
+typedef struct {
+  VIHCSR04_ATOMIC_U32 sequence; /*!< private, position of cell in queue */
+  VIHCSR04_CommandType_t type;  /*!< type of command */
+  VIHCSR04_Handle_t handle;     /*!< handle of sensor, except VIHCSR04_CMD_CREATE */
+  VIHCSR04_MeasureMode_t mode;  /*!< measurement mode of VIHCSR04_CMD_MEASURE */
+  float temperature;            /*!< environment temperature */
+  uint16_t maxDistanceCm;       /*!< maximal measured distance */
+  char name[VIHCSR04_NAME_LEN]; /*!< name of created sensor */
+  const void* triggerPort;      /*!< trigger port of created sensor */
+  uint16_t triggerPin;          /*!< trigger pin of created sensor */
+  const void* echoPort;         /*!< echo port of created sensor */
+  uint16_t echoPin;             /*!< echo pin of created sensor */
+  VIHCSR04_DistanceMm_t distMmCb; /*!< distance callback of VIHCSR04_CMD_MEASURE */
+  VIHCSR04_Created_t createdCb; /*!< result callback of VIHCSR04_CMD_CREATE */
+  const void* context;          /*!< user context of callback */
+} VIHCSR04_Command_t;
+
+/**
+ * @brief Recorder of raw measurement stream, see vihcsr04_rec.h
+ * 
+ */
+typedef struct VIHCSR04_Recorder VIHCSR04_Recorder_t;
 
-typedef int (*VIHCSR04_Printf_t) (const char *__format, ...);
+/**
+ * @brief Shared memory segment of latest readings, see vihcsr04_shm.h
+ * 
+ */
+typedef struct VIHCSR04_ShmSegment VIHCSR04_ShmSegment_t;
 
 /**
  * @brief Initialization of HC-SR04 sensors control driver
@@ -86,6 +172,45 @@ bool VIHCSR04_Init(
   VIHCSR04_TriggerPort_t triggerPortCb
 );
 
+/**
+ * @brief Initialization of HC-SR04 sensors control driver in edge driven mode.
+ *   In this mode the runtime never waits for an echo: it only triggers sensors
+ *   and advances the measurement state machine. Edges of the echo signal have 
+ *   to be reported by VIHCSR04_EchoEdge (for example from a gpio interrupt)
+ * 
+ * @param triggerPortCb Call-back funktion to trigger a pulse on port
+ * @param getTimeUsCb Call-back funktion returning current time in microseconds
+ * @return true if driver initialized successfull
+ * @return false if any error occurred while initialization
+ */
+bool VIHCSR04_InitEdgeDriven(
+  VIHCSR04_TriggerPort_t triggerPortCb,
+  VIHCSR04_GetTimeUs_t getTimeUsCb
+);
+
+/**
+ * @brief Report an edge of the echo signal (edge driven mode only).
+ *   Can be called from interrupt context
+ * 
+ * @param echoPort Pointer to GPIO structur of echo pin
+ * @param echoPin A pin number, on which the edge is detected
+ * @param level Signal level after the edge: 1 - rising edge, 0 - falling edge
+ * @param timeUs Time stamp of the edge in microseconds (same time base as getTimeUsCb)
+ */
+void VIHCSR04_EchoEdge(const void* echoPort, uint16_t echoPin, 
+  uint8_t level, uint64_t timeUs);
+
+/**
+ * @brief Report an edge of the echo signal (edge driven mode only), 
+ *   sensor is addressed by handle without searching by echo pin
+ * 
+ * @param handle Sensor handle
+ * @param level Signal level after the edge: 1 - rising edge, 0 - falling edge
+ * @param timeUs Time stamp of the edge in microseconds (same time base as getTimeUsCb)
+ */
+void VIHCSR04_EchoEdgeByHandle(VIHCSR04_Handle_t handle, 
+  uint8_t level, uint64_t timeUs);
+
 /**
  * @brief Create/register a new sensor handler
  * 
@@ -94,13 +219,55 @@ bool VIHCSR04_Init(
  * @param triggerPin A pin number, to which is trigger pin connected
  * @param echoPort Pointer to GPIO structur for trigger pin
  * @param echoPin A pin number, to which is trigger pin connected
- * @return true if sensor created successfull
- * @return false if any error occurred through creation
+ * @return handle of created sensor 
+ * @return VIHCSR04_INVALID_HANDLE if any error occurred through creation
  */
-bool VIHCSR04_Create(const char* name, 
+VIHCSR04_Handle_t VIHCSR04_Create(const char* name, 
   const void* triggerPort, uint16_t triggerPin, 
   const void* echoPort, uint16_t echoPin);
 
+/**
+ * @brief Create/register a new sensor handler with filter. 
+ *   Filter is applied to every measured distance before it is reported, 
+ *   out of range results are reported unfiltered and don't change filter state.
+ *   Filter history is cleared by every VIHCSR04_MeasureDistanceAsync
+ * 
+ * @param filterCfg Filter configuration, NULL if no filter is used
+ * @return handle of created sensor 
+ * @return VIHCSR04_INVALID_HANDLE if any error occurred through creation or filter configuration is invalid
+ */
+VIHCSR04_Handle_t VIHCSR04_CreateFiltered(const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_FilterCfg_t* filterCfg);
+
+/**
+ * @brief Delete sensor handler. The slot can be reused by next created sensor
+ * 
+ * @param name Unique name of sensor.
+ * @return true if sensor deleted
+ * @return false if sensor is not found
+ */
+bool VIHCSR04_Delete(const char* name);
+
+/**
+ * @brief Delete sensor handler by handle
+ * 
+ * @param handle Sensor handle
+ * @return true if sensor deleted
+ * @return false if handle is invalid or stale
+ */
+bool VIHCSR04_DeleteByHandle(VIHCSR04_Handle_t handle);
+
+/**
+ * @brief Get handle of sensor by name
+ * 
+ * @param name Unique name of sensor.
+ * @return handle of sensor
+ * @return VIHCSR04_INVALID_HANDLE if sensor is not found
+ */
+VIHCSR04_Handle_t VIHCSR04_GetHandle(const char* name);
+
 /**
  * @brief Start async distance mesurement
  * 
@@ -116,6 +283,28 @@ bool VIHCSR04_MeasureDistanceAsync(const char* name,
   const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
   const VIHCSR04_Distance_t distanceMesuredCb, const void* context);
 
+/**
+ * @brief Start async distance mesurement, see VIHCSR04_MeasureDistanceAsync
+ * 
+ * @param handle Sensor handle
+ */
+bool VIHCSR04_MeasureDistanceAsyncByHandle(VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_Distance_t distanceMesuredCb, const void* context);
+
+/**
+ * @brief Start async distance mesurement with distance in mm.
+ *   Distance is computed by integer arithmetic only, without float and 64 bit division, 
+ *   it differs from distance in cm by not more than 1 mm
+ * 
+ * @param handle Sensor handle
+ * @param distanceMesuredCb Call-back funktion with distance in mm 
+ *   or VIHCSR04_INVALID_DISTANCE_MM if out of range
+ */
+bool VIHCSR04_MeasureDistanceMmAsyncByHandle(VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context);
+
 /**
  * @brief Stop continuous distance mesurement
  * 
@@ -124,7 +313,136 @@ bool VIHCSR04_MeasureDistanceAsync(const char* name,
 void VIHCSR04_StopContinuousMeasure(const char* name);
 
 /**
- * @brief Sync distance mesurement
+ * @brief Stop continuous distance mesurement
+ * 
+ * @param handle Sensor handle
+ */
+void VIHCSR04_StopContinuousMeasureByHandle(VIHCSR04_Handle_t handle);
+
+/**
+ * @brief Assign sensor to a firing group (edge driven mode only).
+ *   All enabled sensors of one group are triggered simultaneously, 
+ *   so a group should contain only sensors which don't hear each other.
+ *   Groups are handled one after another. By default every sensor 
+ *   has its own group equal to its creation index
+ * 
+ * @param name Unique name of sensor.
+ * @param group Firing group
+ * @return true if group is assigned
+ * @return false if sensor is not found
+ */
+bool VIHCSR04_SetFiringGroup(const char* name, uint16_t group);
+
+/**
+ * @brief Assign sensor to a firing group, see VIHCSR04_SetFiringGroup
+ * 
+ * @param handle Sensor handle
+ */
+bool VIHCSR04_SetFiringGroupByHandle(VIHCSR04_Handle_t handle, uint16_t group);
+
+/**
+ * @brief Enable/disable adaptive mode of sensor. 
+ *   Echo timeout is narrowed around the last measured distance, 
+ *   if no echo is received within narrowed timeout the result is not reported, 
+ *   the measurement is repeated with full range in the next turn. 
+ *   In continuous mode the sensor is skipped for up to VIHCSR04_ADAPTIVE_MAX_SKIP 
+ *   scheduler turns while the distance is stable, so changing sensors are measured more often
+ * 
+ * @param name Unique sensor name
+ * @param enable Enable adaptive mode
+ * @return true if sensor is found
+ * @return false if sensor is not found
+ */
+bool VIHCSR04_SetAdaptive(const char* name, bool enable);
+
+/**
+ * @brief Enable/disable adaptive mode of sensor, see VIHCSR04_SetAdaptive
+ * 
+ * @param handle Sensor handle
+ * @param enable Enable adaptive mode
+ * @return true if sensor is found
+ * @return false if handle is invalid or stale
+ */
+bool VIHCSR04_SetAdaptiveByHandle(VIHCSR04_Handle_t handle, bool enable);
+
+/**
+ * @brief Set target period of measurements. Released sensors with period are measured 
+ *   earliest deadline first, before sensors without period, which share the rest 
+ *   of runtime turns round robin. A measurement started after the end of its period 
+ *   is counted as deadline miss. Needs time source (VIHCSR04_SetTimeCb in blocking mode), 
+ *   without it the period is ignored
+ * 
+ * @param name Unique name of sensor
+ * @param periodUs Period in microseconds, 0 - as often as possible (default)
+ * @return true if sensor is found
+ * @return false if sensor is not found
+ */
+bool VIHCSR04_SetPeriod(const char* name, uint32_t periodUs);
+
+/**
+ * @brief Set target period of measurements, see VIHCSR04_SetPeriod
+ * 
+ * @param handle Sensor handle
+ * @param periodUs Period in microseconds, 0 - as often as possible (default)
+ * @return true if sensor is found
+ * @return false if handle is invalid or stale
+ */
+bool VIHCSR04_SetPeriodByHandle(VIHCSR04_Handle_t handle, uint32_t periodUs);
+
+/**
+ * @brief Set event delivery mode. Measurements keep running as configured, 
+ *   but the distance callback is called only for the first result, 
+ *   when the distance moves into another zone (thresholds with hysteresis), 
+ *   when it changes by more than delta since the last reported result 
+ *   or when heartbeat has elapsed (needs time source). Samples, log and statistics 
+ *   still get every result. Reported state is cleared by every VIHCSR04_MeasureDistanceAsync
+ * 
+ * @param name Unique name of sensor
+ * @param eventCfg Event configuration, NULL to report every result (default)
+ * @return true if sensor is found and configuration is valid
+ * @return false if sensor is not found or thresholds are not ascending
+ */
+bool VIHCSR04_SetEvents(const char* name, const VIHCSR04_EventCfg_t* eventCfg);
+
+/**
+ * @brief Set event delivery mode, see VIHCSR04_SetEvents
+ * 
+ * @param handle Sensor handle
+ * @param eventCfg Event configuration, NULL to report every result (default)
+ * @return true if sensor is found and configuration is valid
+ * @return false if handle is invalid or stale or thresholds are not ascending
+ */
+bool VIHCSR04_SetEventsByHandle(VIHCSR04_Handle_t handle, const VIHCSR04_EventCfg_t* eventCfg);
+
+/**
+ * @brief Get number of measurements started after the end of their period
+ * 
+ * @param name Unique name of sensor
+ * @return uint32_t number of deadline misses, 0 if sensor is not found
+ */
+uint32_t VIHCSR04_GetDeadlineMisses(const char* name);
+
+/**
+ * @brief Get number of deadline misses, see VIHCSR04_GetDeadlineMisses
+ * 
+ * @param handle Sensor handle
+ */
+uint32_t VIHCSR04_GetDeadlineMissesByHandle(VIHCSR04_Handle_t handle);
+
+/**
+ * @brief Set guard interval between firing groups in edge driven mode 
+ *   and between measurements in blocking mode with time source.
+ *   The next group is triggered not earlier than guard interval after 
+ *   all sensors of the previous group have finished, so the echoes can decay
+ * 
+ * @param guardIntervalUs Guard interval in microseconds
+ */
+void VIHCSR04_SetGuardInterval(uint32_t guardIntervalUs);
+
+/**
+ * @brief Sync distance mesurement with settings of this call. 
+ *   Settings of async measurement are kept, the result is only returned, 
+ *   it is not reported to call-back, sample buffer, statistics and shared memory
  * 
  * @param name Unique name of sensor. Care about VIHCSR04_NAME_LEN
  * @param temperature Current environment temperature
@@ -134,11 +452,229 @@ float VIHCSR04_MeasureDistance(const char* name,
   float temperature, uint16_t maxDistanceCm);
 
 /**
- * @brief Driver runtime, should be placed in main loop or in a task loop
+ * @brief Sync distance mesurement, see VIHCSR04_MeasureDistance
+ * 
+ * @param handle Sensor handle
+ */
+float VIHCSR04_MeasureDistanceByHandle(VIHCSR04_Handle_t handle,
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief Sync distance mesurement with distance in mm (integer arithmetic only)
+ * 
+ * @param handle Sensor handle
+ * @param temperature Current environment temperature
+ * @return distance to the object in mm or VIHCSR04_INVALID_DISTANCE_MM
+ */
+uint32_t VIHCSR04_MeasureDistanceMmByHandle(VIHCSR04_Handle_t handle,
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief Driver runtime, should be placed in main loop or in a task loop.
+ *   In edge driven mode the call returns immediately, 
+ *   the next firing group is handled after the current one has finished
  * 
  */
 void VIHCSR04_Runtime(void);
 
+/**
+ * @brief Tickless driver runtime. Runtime steps are done as long as work is ready 
+ *   and the budget is not exhausted, a started blocking measurement is not interrupted. 
+ *   Returns the time of the next required action (trigger, echo timeout, end of guard 
+ *   interval or period), so the host can sleep until then. In edge driven mode 
+ *   the host should also wake up after a falling echo edge, otherwise the result 
+ *   is reported at the echo timeout. Posted commands are work, which is ready immediately, 
+ *   posting threads should wake up the host. Needs time source (VIHCSR04_SetTimeCb 
+ *   in blocking mode), without it one runtime step is done and 0 is returned 
+ *   (VIHCSR04_NO_DEADLINE if no sensor is measured)
+ * 
+ * @param budgetUs Maximal time spent in runtime steps, 0 - only get next action
+ * @return uint64_t time of the next action (same time base as getTimeUsCb), 
+ *   the current time if work is still ready, VIHCSR04_NO_DEADLINE if no sensor is measured
+ */
+uint64_t VIHCSR04_RuntimeUntil(uint32_t budgetUs);
+
+/**
+ * @brief Set sample buffer. Every completed measurement is stored in the buffer 
+ *   additionally to calling distance callback. The buffer is a lock-free 
+ *   single-producer/single-consumer queue: runtime (task, capture thread or isr) 
+ *   writes and VIHCSR04_DrainSamples can be called from another context.
+ *   Must not be called while runtime is running
+ * 
+ * @param buffer Caller provided storage, NULL to disable buffering
+ * @param capacity Number of samples in buffer, has to be a power of 2
+ * @return true if buffer is set
+ * @return false if capacity is not a power of 2
+ */
+bool VIHCSR04_SetSampleBuffer(VIHCSR04_Sample_t* buffer, uint32_t capacity);
+
+/**
+ * @brief Take stored samples out of sample buffer (consumer side)
+ * 
+ * @param samples Destination array
+ * @param maxSamples Size of destination array
+ * @return uint32_t number of copied samples
+ */
+uint32_t VIHCSR04_DrainSamples(VIHCSR04_Sample_t* samples, uint32_t maxSamples);
+
+/**
+ * @brief Get number of samples dropped because sample buffer was full
+ * 
+ * @return uint32_t number of dropped samples
+ */
+uint32_t VIHCSR04_GetSampleOverflows(void);
+
+/**
+ * @brief Set command queue. Commands are posted by VIHCSR04_Post... functions 
+ *   from any thread or isr and executed by the runtime at the start of the next cycle, 
+ *   so sensors are controlled from other threads without locking the measurement loop. 
+ *   The queue is a lock-free multi-producer/single-consumer queue, posting needs 
+ *   atomic compare-and-swap. Must not be called while runtime is running or commands are posted
+ * 
+ * @param buffer Caller provided storage, NULL to disable the queue
+ * @param capacity Number of commands in buffer, has to be a power of 2
+ * @return true if buffer is set
+ * @return false if capacity is not a power of 2
+ */
+bool VIHCSR04_SetCommandBuffer(VIHCSR04_Command_t* buffer, uint32_t capacity);
+
+/**
+ * @brief Post creation of sensor, see VIHCSR04_Create
+ * 
+ * @param createdCb Call-back funktion with handle of created sensor 
+ *   or VIHCSR04_INVALID_HANDLE, called by runtime, can be NULL
+ * @param context user context that will be returned by calling createdCb
+ * @return true if command is posted
+ * @return false if queue is not set or full
+ */
+bool VIHCSR04_PostCreate(const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_Created_t createdCb, const void* context);
+
+/**
+ * @brief Post deletion of sensor, see VIHCSR04_DeleteByHandle
+ * 
+ * @param handle Sensor handle
+ * @return true if command is posted
+ * @return false if queue is not set or full
+ */
+bool VIHCSR04_PostDelete(VIHCSR04_Handle_t handle);
+
+/**
+ * @brief Post start of measurement, see VIHCSR04_MeasureDistanceMmAsyncByHandle
+ * 
+ * @param handle Sensor handle
+ * @return true if command is posted
+ * @return false if queue is not set or full
+ */
+bool VIHCSR04_PostMeasureMm(VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context);
+
+/**
+ * @brief Post stop of measurement, see VIHCSR04_StopContinuousMeasureByHandle
+ * 
+ * @param handle Sensor handle
+ * @return true if command is posted
+ * @return false if queue is not set or full
+ */
+bool VIHCSR04_PostStop(VIHCSR04_Handle_t handle);
+
+/**
+ * @brief Post change of temperature and range of sensor, 
+ *   measurement continues with the same mode, callback and filter state
+ * 
+ * @param handle Sensor handle
+ * @param temperature Current environment temperature
+ * @param maxDistanceCm Maximal measured distance
+ * @return true if command is posted
+ * @return false if queue is not set or full
+ */
+bool VIHCSR04_PostConfigure(VIHCSR04_Handle_t handle, 
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief Get number of commands rejected because command queue was full
+ * 
+ * @return uint32_t number of rejected commands
+ */
+uint32_t VIHCSR04_GetCommandOverflows(void);
+
+/**
+ * @brief Set recorder (vihcsr04_rec.h). Creation and configuration of sensors 
+ *   and every raw echo duration are stored in the recorder, so the run can be 
+ *   replayed through the driver later. Creation and configuration of existing sensors 
+ *   are recorded immediately. Must not be called while runtime is running
+ * 
+ * @param recorder Initialized recorder, NULL to stop recording
+ */
+void VIHCSR04_SetRecorder(VIHCSR04_Recorder_t* recorder);
+
+/**
+ * @brief Set publisher of latest readings (vihcsr04_shm.h). Every result is written 
+ *   into the slot of its sensor, creation and deletion assign and free slots, 
+ *   so other processes can read current distances from shared memory at any rate. 
+ *   Sensors with handle index beyond the segment are not published. 
+ *   Existing sensors are assigned immediately. Must not be called while runtime is running
+ * 
+ * @param segment Initialized segment, NULL to stop publishing
+ */
+void VIHCSR04_SetPublisher(VIHCSR04_ShmSegment_t* segment);
+
+/**
+ * @brief Set time source in blocking mode. It is used for sample time stamps 
+ *   and time based statistics. In edge driven mode it replaces getTimeUsCb
+ * 
+ * @param getTimeUsCb Call-back funktion returning current time in microseconds, NULL - no time source
+ * @return true if time source is set
+ * @return false if NULL is set in edge driven mode
+ */
+bool VIHCSR04_SetTimeCb(VIHCSR04_GetTimeUs_t getTimeUsCb);
+
+/**
+ * @brief Set batched trigger (vihcsr04_trigger.h) in edge driven mode. Sensors of 
+ *   a firing group sharing a GPIO port are triggered together with one call per port, 
+ *   so a group costs one trigger pulse instead of one pulse per sensor. 
+ *   Pins from 32 and ports beyond VIHCSR04_TRIGGER_MAX_PORTS are triggered by triggerPortCb
+ * 
+ * @param triggerMaskCb Call-back funktion to trigger pins of one port, NULL - trigger one by one
+ */
+void VIHCSR04_SetTriggerMaskCb(VIHCSR04_TriggerMask_t triggerMaskCb);
+
+/**
+ * @brief Get snapshot of sensor statistics (only if VIHCSR04_STATS is enabled)
+ * 
+ * @param name Unique name of sensor
+ * @param stats Destination of snapshot
+ * @return true if snapshot is made
+ * @return false if sensor is not found or statistics is disabled
+ */
+bool VIHCSR04_GetStats(const char* name, VIHCSR04_Stats_t* stats);
+
+/**
+ * @brief Get snapshot of sensor statistics, see VIHCSR04_GetStats
+ * 
+ * @param handle Sensor handle
+ */
+bool VIHCSR04_GetStatsByHandle(VIHCSR04_Handle_t handle, VIHCSR04_Stats_t* stats);
+
+/**
+ * @brief Clear sensor statistics (only if VIHCSR04_STATS is enabled)
+ * 
+ * @param name Unique name of sensor
+ * @return true if statistics is cleared
+ * @return false if sensor is not found or statistics is disabled
+ */
+bool VIHCSR04_ResetStats(const char* name);
+
+/**
+ * @brief Clear sensor statistics, see VIHCSR04_ResetStats
+ * 
+ * @param handle Sensor handle
+ */
+bool VIHCSR04_ResetStatsByHandle(VIHCSR04_Handle_t handle);
+
 /**
  * @brief Set printf callback.
  *   This callback can be used to get debug info from driver
@@ -147,6 +683,47 @@ void VIHCSR04_Runtime(void);
  */
 void VIHCSR04_SetPrintfCb(const VIHCSR04_Printf_t printfCb);
 
+/**
+ * @brief Set log buffer. If set, debug events are stored as binary records 
+ *   instead of calling printf callback in runtime, so logging doesn't disturb timing.
+ *   The buffer is a lock-free single-producer/single-consumer queue like sample buffer:
+ *   runtime writes and VIHCSR04_DrainLog or VIHCSR04_PrintLog can be called from another context.
+ *   Must not be called while runtime is running
+ * 
+ * @param buffer Caller provided storage, NULL to disable deferred logging
+ * @param capacity Number of records in buffer, has to be a power of 2
+ * @return true if buffer is set
+ * @return false if capacity is not a power of 2
+ */
+bool VIHCSR04_SetLogBuffer(VIHCSR04_LogRecord_t* buffer, uint32_t capacity);
+
+/**
+ * @brief Take stored records out of log buffer (consumer side), 
+ *   records can be formatted by VIHCSR04_FormatLog
+ * 
+ * @param records Destination array
+ * @param maxRecords Size of destination array
+ * @return uint32_t number of copied records
+ */
+uint32_t VIHCSR04_DrainLog(VIHCSR04_LogRecord_t* records, uint32_t maxRecords);
+
+/**
+ * @brief Take stored records out of log buffer and print them by printf callback.
+ *   Names of sensors are looked up while printing, 
+ *   records of deleted sensors are printed without name
+ * 
+ * @param maxRecords Max number of printed records
+ * @return uint32_t number of printed records
+ */
+uint32_t VIHCSR04_PrintLog(uint32_t maxRecords);
+
+/**
+ * @brief Get number of records dropped because log buffer was full
+ * 
+ * @return uint32_t number of dropped records
+ */
+uint32_t VIHCSR04_GetLogOverflows(void);
+
 /**
  * @brief Set debug info level
  * 
@@ -25,28 +25,124 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <climits>
 
+#include "vihcsr04_math.h"
+#include "vihcsr04_filter.h"
+#include "vihcsr04_event.h"
+#include "vihcsr04_adaptive.h"
+#include "vihcsr04_core.h"
+#include "vihcsr04_sched.h"
+#include "vihcsr04_trigger.h"
+#include "vihcsr04_stats.h"
+#include "vihcsr04_log.h"
+#include "vihcsr04_shm.h"
+#include "vihcsr04_ring.hpp"
+
 namespace vihcsr04 {
 
+  /**
+   * @brief Debug level. Printf callback gets only info messages, 
+   *   debug and trace events are stored only in log buffer (SetLogBuffer)
+   * 
+   */
   typedef enum {
     DEBUG_DISABLED = 0,  
-    DEBUG_INFO
+    DEBUG_INFO,                              /*!< sensor creation, measurement start and result */
+    DEBUG_DEBUG,                             /*!< additionally misses of adaptive timeout and deadlines */
+    DEBUG_TRACE                              /*!< additionally echo edge timing and skipped turns */
   } DebugLvl_t;
 
+  /**
+   * @brief Binary log record, see VIHCSR04_LogRecord_t and VIHCSR04_LogEvent_t.
+   *   Records are formatted by VIHCSR04_FormatLog
+   * 
+   */
+  typedef VIHCSR04_LogRecord_t LogRecord_t;
+
+  /**
+   * @brief Filter configuration, see VIHCSR04_FilterCfg_t. 
+   *   Stages are combination of FILTER_MEDIAN, FILTER_EMA and FILTER_KALMAN
+   * 
+   */
+  typedef VIHCSR04_FilterCfg_t FilterCfg_t;
+
+  /**
+   * @brief Event delivery configuration, see VIHCSR04_EventCfg_t
+   * 
+   */
+  typedef VIHCSR04_EventCfg_t EventCfg_t;
+
+  /**
+   * @brief Sensor statistics, see VIHCSR04_Stats_t. 
+   *   Kept only if VIHCSR04_STATS is enabled
+   * 
+   */
+  typedef VIHCSR04_Stats_t Stats_t;
+
+  constexpr uint8_t FILTER_NONE = VIHCSR04_FILTER_NONE;
+  constexpr uint8_t FILTER_MEDIAN = VIHCSR04_FILTER_MEDIAN;
+  constexpr uint8_t FILTER_EMA = VIHCSR04_FILTER_EMA;
+  constexpr uint8_t FILTER_KALMAN = VIHCSR04_FILTER_KALMAN;
+
   typedef enum {
     ONESHOT_MEASURE = 0,  
     CONTINUOUS_MEASURE
   } MeasureMode_t;
 
-  typedef uint64_t (*PulseIn_t)(const void* gpio, uint16_t port, 
-    uint8_t state, uint64_t maxDurationTreshold, const void* context);
-  typedef void (*TriggerPort_t) (const void* gpio, uint16_t port, 
-    uint8_t state, uint64_t pulseDuration, const void* context);
-  typedef void (*Distance_t) (float distance, const void* context);
-  typedef int (*Printf_t) (const char *__format, ...);
+  typedef VIHCSR04_PulseIn_t PulseIn_t;
+  typedef VIHCSR04_TriggerPort_t TriggerPort_t;
+  typedef VIHCSR04_TriggerMask_t TriggerMask_t;
+  typedef VIHCSR04_Distance_t Distance_t;
+  typedef VIHCSR04_DistanceMm_t DistanceMm_t;
+  typedef VIHCSR04_Printf_t Printf_t;
+  typedef VIHCSR04_GetTimeUs_t GetTimeUs_t;
+
+  /**
+   * @brief Sensor handle: slot index in lower 16 bits and slot generation in upper 16 bits.
+   *   Handle becomes stale after sensor is deleted, all calls with stale handle fail
+   * 
+   */
+  typedef uint32_t Handle_t;
+
+  /**
+   * @brief Invalid sensor handle, returned if sensor can not be created or found
+   * 
+   */
+  constexpr Handle_t INVALID_HANDLE = 0;
+
+  /**
+   * @brief Distance in mm reported if echo is out of range
+   * 
+   */
+  constexpr uint32_t INVALID_DISTANCE_MM = VIHCSR04_INVALID_DISTANCE_MM;
+
+  /**
+   * @brief Time of next action returned by RuntimeUntil if no sensor is measured
+   * 
+   */
+  constexpr uint64_t NO_DEADLINE = VIHCSR04_NO_DEADLINE;
+
+  /**
+   * @brief Default number of sensor slots reserved in edge driven mode
+   * 
+   */
+  constexpr size_t EDGE_DRIVEN_MAX_SENSORS = 16;
+
+  /**
+   * @brief Measurement record stored in sample buffer
+   * 
+   */
+  typedef struct {
+    Handle_t handle;                         /*!< handle of measured sensor */
+    uint32_t durationUs;                     /*!< echo duration in microseconds, 0 if timeout */
+    uint32_t distanceMm;                     /*!< distance in mm or INVALID_DISTANCE_MM */
+    uint64_t timestampUs;                    /*!< time of measurement completion, 0 if no time source is set */
+  } Sample_t;
 
   class Hcsr04Sensor 
   {
@@ -61,6 +157,30 @@ namespace vihcsr04 {
      */
     Hcsr04Sensor(PulseIn_t pulseInCb, TriggerPort_t triggerPortCb);
 
+    /**
+     * @brief Construct a new Hcsr04 Sensor object working in edge driven mode.
+     *   Runtime never waits for an echo, edges of echo signal have to be 
+     *   reported by EchoEdge (for example from a gpio interrupt). 
+     *   Storage of maxSensors sensors is reserved here and never reallocated, 
+     *   so sensors can be added while EchoEdge is called, but not more than maxSensors
+     * 
+     * @param triggerPortCb  Call-back funktion to trigger a pulse on port
+     * @param getTimeUsCb    Call-back funktion returning current time in microseconds
+     * @param maxSensors     Number of sensor slots, 1..65536
+     */
+    Hcsr04Sensor(TriggerPort_t triggerPortCb, GetTimeUs_t getTimeUsCb, 
+      size_t maxSensors = EDGE_DRIVEN_MAX_SENSORS);
+
+    /**
+     * @brief Runtime of bus refers to this object and its storage, 
+     *   so the driver can be neither copied nor moved
+     * 
+     */
+    Hcsr04Sensor(const Hcsr04Sensor&) = delete;
+    Hcsr04Sensor(Hcsr04Sensor&&) = delete;
+    Hcsr04Sensor& operator=(const Hcsr04Sensor&) = delete;
+    Hcsr04Sensor& operator=(Hcsr04Sensor&&) = delete;
+
     ~Hcsr04Sensor();
 
     /**
@@ -71,13 +191,29 @@ namespace vihcsr04 {
      * @param triggerPin A pin number, to which is trigger pin connected
      * @param echoPort Pointer to GPIO structur for trigger pin
      * @param echoPin A pin number, to which is trigger pin connected
-     * @return true if sensor created successfull
-     * @return false if any error occurred through creation
+     * @return handle of created sensor
+     * @return INVALID_HANDLE if any error occurred through creation 
+     *   or all reserved slots are used in edge driven mode
      */
-    bool AddSensor(const std::string& name, 
+    Handle_t AddSensor(std::string_view name, 
       const void* triggerPort, uint16_t triggerPin, 
       const void* echoPort, uint16_t echoPin);
 
+    /**
+     * @brief Create/register a new sensor handler with filter. 
+     *   Filter is applied to every measured distance before it is reported, 
+     *   out of range results are reported unfiltered and don't change filter state.
+     *   Filter history is cleared by every MeasureDistanceAsync
+     * 
+     * @param filterCfg Filter configuration
+     * @return handle of created sensor
+     * @return INVALID_HANDLE if any error occurred through creation or filter configuration is invalid
+     */
+    Handle_t AddSensor(std::string_view name, 
+      const void* triggerPort, uint16_t triggerPin, 
+      const void* echoPort, uint16_t echoPin,
+      const FilterCfg_t& filterCfg);
+
     /**
      * @brief Delete a sensor if exist from container
      * 
@@ -85,7 +221,17 @@ namespace vihcsr04 {
      * @return true 
      * @return false 
      */
-    bool DeleteSensor(const std::string& name);
+    bool DeleteSensor(std::string_view name);
+    bool DeleteSensor(Handle_t handle);
+
+    /**
+     * @brief Get handle of sensor by name
+     * 
+     * @param name Unique name of sensor
+     * @return handle of sensor
+     * @return INVALID_HANDLE if sensor is not found
+     */
+    Handle_t GetHandle(std::string_view name);
 
     /**
      * @brief Start async distance mesurement
@@ -98,26 +244,262 @@ namespace vihcsr04 {
      * @return true if measurement started successfull
      * @return false if any error occurred while starting
      */
-    bool MeasureDistanceAsync(const std::string& name, 
+    bool MeasureDistanceAsync(std::string_view name, 
       const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
       const Distance_t distanceMesuredCb, const void* context);
+    bool MeasureDistanceAsync(Handle_t handle, 
+      const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+      const Distance_t distanceMesuredCb, const void* context);
+
+    /**
+     * @brief Start async distance mesurement with distance in mm.
+     *   Distance is computed by integer arithmetic only, without float and 64 bit division, 
+     *   it differs from distance in cm by not more than 1 mm
+     * 
+     * @param handle Sensor handle
+     * @param distanceMesuredCb Call-back funktion with distance in mm 
+     *   or INVALID_DISTANCE_MM if out of range
+     */
+    bool MeasureDistanceMmAsync(Handle_t handle, 
+      const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+      const DistanceMm_t distanceMesuredCb, const void* context);
 
     /**
      * @brief Stop continuous distance mesurement
      * 
      * @param name Unique name of sensor.
      */
-    void StopContinuousMeasure(const std::string& name);
+    void StopContinuousMeasure(std::string_view name);
+    void StopContinuousMeasure(Handle_t handle);
+
+    /**
+     * @brief Assign sensor to a firing group (edge driven mode only).
+     *   All enabled sensors of one group are triggered simultaneously, 
+     *   so a group should contain only sensors which don't hear each other.
+     *   Groups are handled one after another. By default every sensor 
+     *   has its own group equal to its slot index
+     * 
+     * @param name Unique name of sensor.
+     * @param group Firing group
+     * @return true if group is assigned
+     * @return false if sensor is not found
+     */
+    bool SetFiringGroup(std::string_view name, uint32_t group);
+    bool SetFiringGroup(Handle_t handle, uint32_t group);
+
+    /**
+     * @brief Set guard interval between firing groups in edge driven mode 
+     *   and between measurements in blocking mode with time source.
+     *   The next group is triggered not earlier than guard interval after 
+     *   all sensors of the previous group have finished, so the echoes can decay
+     * 
+     * @param guardIntervalUs Guard interval in microseconds
+     */
+    void SetGuardInterval(uint32_t guardIntervalUs);
+
+    /**
+     * @brief Enable/disable adaptive mode of sensor. 
+     *   Echo timeout is narrowed around the last measured distance, 
+     *   if no echo is received within narrowed timeout the result is not reported, 
+     *   the measurement is repeated with full range in the next turn. 
+     *   In continuous mode the sensor is skipped for up to VIHCSR04_ADAPTIVE_MAX_SKIP 
+     *   scheduler turns while the distance is stable
+     * 
+     * @param name Unique name of sensor.
+     * @param enable Enable adaptive mode
+     * @return true if sensor is found
+     * @return false if sensor is not found
+     */
+    bool SetAdaptive(std::string_view name, bool enable);
+    bool SetAdaptive(Handle_t handle, bool enable);
+
+    /**
+     * @brief Set target period of measurements. Released sensors with period are measured 
+     *   earliest deadline first, before sensors without period, which share the rest 
+     *   of runtime turns round robin. A measurement started after the end of its period 
+     *   is counted as deadline miss. Needs time source (SetTimeCb in blocking mode), 
+     *   without it the period is ignored
+     * 
+     * @param name Unique name of sensor.
+     * @param periodUs Period in microseconds, 0 - as often as possible (default)
+     * @return true if sensor is found
+     * @return false if sensor is not found
+     */
+    bool SetPeriod(std::string_view name, uint32_t periodUs);
+    bool SetPeriod(Handle_t handle, uint32_t periodUs);
+
+    /**
+     * @brief Set event delivery mode. Measurements keep running as configured, 
+     *   but the distance callback is called only for the first result, 
+     *   when the distance moves into another zone (thresholds with hysteresis), 
+     *   when it changes by more than delta since the last reported result 
+     *   or when heartbeat has elapsed (needs time source). Samples, log and statistics 
+     *   still get every result. Reported state is cleared by every MeasureDistanceAsync
+     * 
+     * @param name Unique name of sensor.
+     * @param eventCfg Event configuration, nullptr to report every result (default)
+     * @return true if sensor is found and configuration is valid
+     * @return false if sensor is not found or thresholds are not ascending
+     */
+    bool SetEvents(std::string_view name, const EventCfg_t* eventCfg);
+    bool SetEvents(Handle_t handle, const EventCfg_t* eventCfg);
 
-    float MeasureDistance(const std::string& name, 
+    /**
+     * @brief Get number of measurements started after the end of their period
+     * 
+     * @param name Unique name of sensor.
+     * @return uint32_t number of deadline misses, 0 if sensor is not found
+     */
+    uint32_t GetDeadlineMisses(std::string_view name);
+    uint32_t GetDeadlineMisses(Handle_t handle);
+
+    /**
+     * @brief Sync distance mesurement with settings of this call. 
+     *   Settings of async measurement are kept, the result is only returned, 
+     *   it is not reported to call-back, sample buffer, statistics and shared memory
+     * 
+     * @param name Unique name of sensor.
+     * @param temperature Current environment temperature
+     * @return distance to the object in cm, -1 if sensor is not found or busy
+     */
+    float MeasureDistance(std::string_view name, 
+      float temperature, uint16_t maxDistanceCm);
+    float MeasureDistance(Handle_t handle, 
+      float temperature, uint16_t maxDistanceCm);
+
+    /**
+     * @brief Sync distance mesurement with distance in mm (integer arithmetic only)
+     * 
+     * @param handle Sensor handle
+     * @param temperature Current environment temperature
+     * @return distance to the object in mm or INVALID_DISTANCE_MM
+     */
+    uint32_t MeasureDistanceMm(Handle_t handle, 
       float temperature, uint16_t maxDistanceCm);
 
     /**
-     * @brief Driver runtime, should be placed in main loop or in a task loop
+     * @brief Driver runtime, should be placed in main loop or in a task loop.
+     *   In edge driven mode the call returns immediately, 
+     *   the next firing group is handled after the current one has finished
      * 
      */
     void Runtime(void);
 
+    /**
+     * @brief Tickless driver runtime. Runtime steps are done as long as work is ready 
+     *   and the budget is not exhausted, a started blocking measurement is not interrupted. 
+     *   Returns the time of the next required action (trigger, echo timeout, end of guard 
+     *   interval or period), so the host can sleep until then. In edge driven mode 
+     *   the host should also wake up after a falling echo edge, otherwise the result 
+     *   is reported at the echo timeout. Needs time source (SetTimeCb in blocking mode), 
+     *   without it one runtime step is done and 0 is returned 
+     *   (NO_DEADLINE if no sensor is measured)
+     * 
+     * @param budgetUs Maximal time spent in runtime steps, 0 - only get next action
+     * @return uint64_t time of the next action (same time base as getTimeUsCb), 
+     *   the current time if work is still ready, NO_DEADLINE if no sensor is measured
+     */
+    uint64_t RuntimeUntil(uint32_t budgetUs);
+
+    /**
+     * @brief Report an edge of the echo signal (edge driven mode only).
+     *   Can be called from interrupt context
+     * 
+     * @param echoPort Pointer to GPIO structur of echo pin
+     * @param echoPin A pin number, on which the edge is detected
+     * @param level Signal level after the edge: 1 - rising edge, 0 - falling edge
+     * @param timeUs Time stamp of the edge in microseconds (same time base as getTimeUsCb)
+     */
+    void EchoEdge(const void* echoPort, uint16_t echoPin, 
+      uint8_t level, uint64_t timeUs);
+
+    /**
+     * @brief Report an edge of the echo signal (edge driven mode only), 
+     *   sensor is addressed by handle without searching by echo pin
+     * 
+     * @param handle Sensor handle
+     * @param level Signal level after the edge: 1 - rising edge, 0 - falling edge
+     * @param timeUs Time stamp of the edge in microseconds (same time base as getTimeUsCb)
+     */
+    void EchoEdge(Handle_t handle, uint8_t level, uint64_t timeUs);
+
+    /**
+     * @brief Enable sample buffer. Every completed measurement is stored in the buffer 
+     *   additionally to calling distance callback. The buffer is a lock-free 
+     *   single-producer/single-consumer queue: Runtime (task, capture thread or isr) 
+     *   writes and DrainSamples can be called from another thread.
+     *   Must not be called while runtime is running
+     * 
+     * @param capacity Number of samples in buffer, has to be a power of 2 (0 disables buffer)
+     * @return true if buffer is allocated
+     * @return false if capacity is not a power of 2
+     */
+    bool SetSampleBuffer(size_t capacity);
+
+    /**
+     * @brief Take stored samples out of sample buffer (consumer side)
+     * 
+     * @param samples Destination array
+     * @param maxSamples Size of destination array
+     * @return size_t number of copied samples
+     */
+    size_t DrainSamples(Sample_t* samples, size_t maxSamples);
+
+    /**
+     * @brief Get number of samples dropped because sample buffer was full
+     * 
+     * @return uint32_t number of dropped samples
+     */
+    uint32_t GetSampleOverflows(void) const;
+
+    /**
+     * @brief Set time source in blocking mode. It is used for sample time stamps 
+     *   and time based statistics. In edge driven mode it replaces getTimeUsCb
+     * 
+     * @param getTimeUsCb Call-back funktion returning current time in microseconds, nullptr - no time source
+     * @return true if time source is set
+     * @return false if nullptr is set in edge driven mode
+     */
+    bool SetTimeCb(GetTimeUs_t getTimeUsCb);
+
+    /**
+     * @brief Get time source set by constructor or SetTimeCb
+     * 
+     * @return GetTimeUs_t time source, nullptr if no time source is set
+     */
+    GetTimeUs_t GetTimeCb(void) const;
+
+    /**
+     * @brief Set batched trigger (vihcsr04_trigger.h) in edge driven mode. Sensors of 
+     *   a firing group sharing a GPIO port are triggered together with one call per port, 
+     *   so a group costs one trigger pulse instead of one pulse per sensor. 
+     *   Pins from 32 and ports beyond VIHCSR04_TRIGGER_MAX_PORTS are triggered by triggerPortCb
+     * 
+     * @param triggerMaskCb Call-back funktion to trigger pins of one port, nullptr - trigger one by one
+     */
+    void SetTriggerMaskCb(TriggerMask_t triggerMaskCb);
+
+    /**
+     * @brief Get snapshot of sensor statistics (only if VIHCSR04_STATS is enabled)
+     * 
+     * @param name Unique name of sensor
+     * @param stats Destination of snapshot
+     * @return true if snapshot is made
+     * @return false if sensor is not found or statistics is disabled
+     */
+    bool GetStats(std::string_view name, Stats_t& stats);
+    bool GetStats(Handle_t handle, Stats_t& stats);
+
+    /**
+     * @brief Clear sensor statistics (only if VIHCSR04_STATS is enabled)
+     * 
+     * @param name Unique name of sensor
+     * @return true if statistics is cleared
+     * @return false if sensor is not found or statistics is disabled
+     */
+    bool ResetStats(std::string_view name);
+    bool ResetStats(Handle_t handle);
+
     /**
      * @brief Set printf callback.
      *   This callback can be used to get debug info from driver
@@ -126,6 +508,44 @@ namespace vihcsr04 {
      */
     void SetPrintfCb(const Printf_t printfCb);
 
+    /**
+     * @brief Enable log buffer. If enabled, debug events are stored as binary records 
+     *   instead of calling printf callback in runtime, so logging doesn't disturb timing.
+     *   The buffer is a lock-free single-producer/single-consumer queue like sample buffer.
+     *   Must not be called while runtime is running
+     * 
+     * @param capacity Number of records in buffer, has to be a power of 2 (0 disables buffer)
+     * @return true if buffer is allocated
+     * @return false if capacity is not a power of 2
+     */
+    bool SetLogBuffer(size_t capacity);
+
+    /**
+     * @brief Take stored records out of log buffer (consumer side)
+     * 
+     * @param records Destination array
+     * @param maxRecords Size of destination array
+     * @return size_t number of copied records
+     */
+    size_t DrainLog(LogRecord_t* records, size_t maxRecords);
+
+    /**
+     * @brief Take stored records out of log buffer and print them by printf callback.
+     *   Names of sensors are looked up while printing, so it has to be called 
+     *   in the thread of runtime or while no sensors are added or deleted
+     * 
+     * @param maxRecords Max number of printed records
+     * @return size_t number of printed records
+     */
+    size_t PrintLog(size_t maxRecords);
+
+    /**
+     * @brief Get number of records dropped because log buffer was full
+     * 
+     * @return uint32_t number of dropped records
+     */
+    uint32_t GetLogOverflows(void) const;
+
     /**
      * @brief Set debug info level
      * 
@@ -133,74 +553,88 @@ namespace vihcsr04 {
      */
     void SetDebugLvl(const DebugLvl_t lvl);
 
+    /**
+     * @brief Set publisher of latest readings (vihcsr04_shm.h). Every result is written 
+     *   into the slot of its sensor, adding and deleting assign and free slots, 
+     *   so other processes can read current distances from shared memory at any rate. 
+     *   Sensors with handle index beyond the segment are not published. 
+     *   Existing sensors are assigned immediately. Must not be called while runtime is running
+     * 
+     * @param segment Initialized segment, nullptr to stop publishing
+     */
+    void SetPublisher(VIHCSR04_ShmSegment_t* segment);
+
   private:
     typedef struct
     {
+      bool used{false};                      /*!< slot is used by a registered sensor */
+      uint16_t generation{};                 /*!< slot generation, incremented if sensor is deleted */
       std::string name;                      /*!< unique name of sensor */
-      const void* triggerPort{nullptr};      /*!< pointer to the physical port, to witch the trigger pin of sensor is connected*/
-      uint16_t triggerPin{USHRT_MAX};        /*!< pin number, to witch the the trigger pin of sensor is connected*/
-      const void* echoPort{nullptr};         /*!< pointer to the physical port, to witch the echo pin of sensor is connected*/
-      uint16_t echoPin{USHRT_MAX};           /*!< pin number, to witch the echo pin of sensor is connected*/
-      bool enabled{false};                   /*!< flag to enabled/disable if messurement */
-      MeasureMode_t mode{};                  /*!< messurement mode */
       float temperature{};                   /*!< current environment temperature */
       uint16_t maxDistanceCm{};              /*!< maximal measured distance */
-      const void* userContext{nullptr};      /*!< user context that is returned by calling distCb */
-      Distance_t distCb{nullptr};            /*!< call-back funktion will be called if meassurement is done */
-
-      float Runtime(const PulseIn_t pulseInCb, 
-        const TriggerPort_t triggerPortCb, const Printf_t printfCb, DebugLvl_t debugLvl) 
-      {
-        if(!enabled)
-          return -1;
-
-        if(DEBUG_INFO <= debugLvl && nullptr != printfCb)
-          printfCb("Sensor \"%s\": measurement startet\r\n", name.c_str());
-
-        //float speedOfSoundInCmPerMicroSec = 0.03313 + 0.0000606 * sensor->temperature; // Cair ≈ (331.3 + 0.606 ⋅ ϑ) m/s
-        uint64_t speadOfSound = 33130000000 + 60600000 * temperature;
-
-        // Compute max delay based on max distance with 25% margin in microseconds
-        //unsigned long maxDistanceDurationMicroSec = 2.5 * sensor->maxDistanceCm / speedOfSoundInCmPerMicroSec;
-        uint64_t maxDistance = 2500000000000 / speadOfSound * maxDistanceCm;
-
-        // Hold trigger for 10 microseconds, which is signal for sensor to measure distance.
-        triggerPortCb(triggerPort, triggerPin, 1, 10, userContext);
-
-        // Measure the length of echo signal, which is equal to the time needed for sound to go there and back.
-        uint64_t durationMicroSec = pulseInCb(echoPort, echoPin, 1, maxDistance*1000, userContext); // can't measure beyond max distance
-
-        //float distanceCm = durationMicroSec / 2.0 * speedOfSoundInCmPerMicroSec;
-        float distanceCm = (float)speadOfSound / 2000000000000 * durationMicroSec ;
-
-        //float distanceCm = durationMicroSec / 
+    } Sensor_t;
 
-        if (distanceCm == 0 || distanceCm > maxDistanceCm) {
-            distanceCm = -1.0 ;
-        } 
+    /**
+     * @brief Make handle of sensor in slot
+     * 
+     * @param index Slot index
+     * @return Handle_t handle of sensor
+     */
+    Handle_t MakeHandle(uint32_t index);
 
-        if(DEBUG_INFO <= debugLvl && nullptr != printfCb)
-          printfCb("Sensor \"%s\": measured distance %f\r\n", name.c_str(), distanceCm);
+    /**
+     * @brief Get core of sensor, it is kept in m_cores at the slot index of sensor
+     * 
+     * @param sensor Sensor in m_sensors
+     * @return VIHCSR04_Core_t& pins, callbacks, schedule and measurement state of sensor
+     */
+    VIHCSR04_Core_t& CoreOf(const Sensor_t* sensor);
 
-        if (distCb)
-          distCb(distanceCm, userContext);
+    /**
+     * @brief Get sensor by handle
+     * 
+     * @param handle Sensor handle
+     * @return Sensor_t* pointer to sensor, nullptr if handle is invalid or stale
+     */
+    Sensor_t* GetSensor(Handle_t handle);
 
-        if (mode == ONESHOT_MEASURE)
-          enabled = false;
+    /**
+     * @brief Sync measurement, see VIHCSR04_CoreMeasureSync
+     * 
+     * @param handle Sensor handle
+     * @param conv Precomputed conversion for temperature and max distance
+     * @param durationMicroSec Measured echo duration, 0 if timeout
+     * @return true if measurement is done
+     * @return false if sensor is not found or busy
+     */
+    bool MeasureSync(Handle_t handle, 
+      const VIHCSR04_Conversion_t& conv, uint32_t& durationMicroSec);
 
-        return distanceCm;
-      }
+    /**
+     * @brief Get time of the next action required from runtime
+     * 
+     * @param now Current time
+     * @return uint64_t time of next action, now if work is ready, 
+     *   NO_DEADLINE if no sensor is measured
+     */
+    uint64_t NextAction(uint64_t now) const;
 
-    } Sensor_t;
+    /**
+     * @brief Hooks of core runtime, defined by the source of realisation
+     * 
+     */
+    friend struct CoreHooks;
 
     bool m_isInitialized{false};
-    uint32_t m_currentSnsr{};
-    PulseIn_t m_pulseInCb{nullptr};
-    TriggerPort_t m_triggerPortCb{nullptr};
-    std::map<std::string, Sensor_t> m_sensors{};
-    std::vector<Sensor_t*> m_sensorsPtr{};
-    DebugLvl_t m_debugLvl{};
-    Printf_t m_printfCb{};
+    size_t m_maxSensors{0x10000};            /*!< number of slots, limited by 16 bit slot index of handle */
+    VIHCSR04_CoreBus_t m_bus{};                /*!< callbacks and scheduler shared with c realisation */
+    std::vector<Sensor_t> m_sensors{};
+    std::vector<VIHCSR04_Core_t> m_cores{};    /*!< cores of sensors by slot, array of bus shared with c realisation */
+    std::map<std::string, uint32_t, std::less<>> m_names{};
+    std::vector<uint32_t> m_freeSlots{};
+    SpscRing<Sample_t> m_samples{};
+    SpscRing<LogRecord_t> m_log{};
+    VIHCSR04_ShmSegment_t* m_publisher{nullptr};
   };
 }
 
@@ -0,0 +1,179 @@
+/**
+ * @file vihcsr04_adaptive.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Adaptive echo timeout and ping rate of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_ADAPTIVE_H
+#define VIHCSR04_ADAPTIVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "vihcsr04_math.h"
+
+/** 
+ * @brief Margin of adaptive echo timeout over the last distance: distance / 2^shift
+ * */
+#if !defined(VIHCSR04_ADAPTIVE_MARGIN_SHIFT)
+  #define VIHCSR04_ADAPTIVE_MARGIN_SHIFT 1
+#endif
+
+/** 
+ * @brief Constant part of adaptive echo timeout, covers delay between trigger and echo
+ * */
+#if !defined(VIHCSR04_ADAPTIVE_SLACK_US)
+  #define VIHCSR04_ADAPTIVE_SLACK_US 1000
+#endif
+
+/** 
+ * @brief Max change of distance between two pings for which the sensor is stable
+ * */
+#if !defined(VIHCSR04_ADAPTIVE_STABLE_MM)
+  #define VIHCSR04_ADAPTIVE_STABLE_MM 20
+#endif
+
+/** 
+ * @brief Max number of scheduler turns a stable sensor is skipped
+ * */
+#if !defined(VIHCSR04_ADAPTIVE_MAX_SKIP)
+  #define VIHCSR04_ADAPTIVE_MAX_SKIP 8
+#endif
+
+/**
+ * @brief Adaptive measurement state. 
+ *   Echo timeout is narrowed around the last distance, a miss is not reported 
+ *   but repeated with full range. Every stable result doubles the number of 
+ *   scheduler turns the sensor is skipped (up to VIHCSR04_ADAPTIVE_MAX_SKIP), 
+ *   a changed result resets it
+ * 
+ */
+typedef struct {
+  bool enabled;                 /*!< adaptive mode is enabled */
+  uint32_t lastMm;              /*!< last valid distance, VIHCSR04_INVALID_DISTANCE_MM if unknown */
+  uint32_t timeoutUs;           /*!< echo timeout of the current measurement */
+  uint8_t skip;                 /*!< number of turns to skip after a measurement */
+  uint8_t skipLeft;             /*!< remaining turns to skip */
+} VIHCSR04_Adaptive_t;
+
+/**
+ * @brief Initialize adaptive state, the next measurement uses full range
+ * 
+ * @param adaptive Adaptive state
+ * @param enabled Enable adaptive mode
+ */
+static inline void VIHCSR04_AdaptiveInit(VIHCSR04_Adaptive_t* adaptive, bool enabled) {
+  adaptive->enabled = enabled;
+  adaptive->lastMm = VIHCSR04_INVALID_DISTANCE_MM;
+  adaptive->timeoutUs = 0;
+  adaptive->skip = 0;
+  adaptive->skipLeft = 0;
+}
+
+/**
+ * @brief Check if the sensor skips current scheduler turn
+ * 
+ * @param adaptive Adaptive state
+ * @return true if the turn is skipped
+ */
+static inline bool VIHCSR04_AdaptiveSkip(VIHCSR04_Adaptive_t* adaptive) {
+
+  if (!adaptive->enabled || 0 == adaptive->skipLeft)
+    return false;
+
+  adaptive->skipLeft--;
+  return true;
+}
+
+/**
+ * @brief Compute and store echo timeout of a new measurement
+ * 
+ * @param adaptive Adaptive state
+ * @param conv Conversion of the sensor
+ * @return uint32_t echo timeout in microseconds
+ */
+static inline uint32_t VIHCSR04_AdaptiveTimeout(VIHCSR04_Adaptive_t* adaptive, 
+  const VIHCSR04_Conversion_t* conv) {
+
+  adaptive->timeoutUs = conv->maxEchoUs;
+
+  if (adaptive->enabled && VIHCSR04_INVALID_DISTANCE_MM != adaptive->lastMm) {
+    uint32_t expectedMm = adaptive->lastMm + (adaptive->lastMm >> VIHCSR04_ADAPTIVE_MARGIN_SHIFT);
+    uint32_t timeoutUs = ((expectedMm * conv->usPerMmQ8) >> 8) + VIHCSR04_ADAPTIVE_SLACK_US;
+
+    if (timeoutUs < adaptive->timeoutUs)
+      adaptive->timeoutUs = timeoutUs;
+  }
+
+  return adaptive->timeoutUs;
+}
+
+/**
+ * @brief Handle echo timeout
+ * 
+ * @param adaptive Adaptive state
+ * @param conv Conversion of the sensor
+ * @return true if timeout was narrowed, the miss has to be repeated with full range and not reported
+ * @return false if the miss is a real out of range result
+ */
+static inline bool VIHCSR04_AdaptiveMiss(VIHCSR04_Adaptive_t* adaptive, 
+  const VIHCSR04_Conversion_t* conv) {
+
+  if (!adaptive->enabled || adaptive->timeoutUs >= conv->maxEchoUs)
+    return false;
+
+  VIHCSR04_AdaptiveInit(adaptive, true);
+  return true;
+}
+
+/**
+ * @brief Update history with a reported result
+ * 
+ * @param adaptive Adaptive state
+ * @param distanceMm Measured distance in mm or VIHCSR04_INVALID_DISTANCE_MM
+ */
+static inline void VIHCSR04_AdaptiveUpdate(VIHCSR04_Adaptive_t* adaptive, uint32_t distanceMm) {
+
+  if (!adaptive->enabled)
+    return;
+
+  bool stable = VIHCSR04_INVALID_DISTANCE_MM != distanceMm && 
+    VIHCSR04_INVALID_DISTANCE_MM != adaptive->lastMm &&
+    ((distanceMm > adaptive->lastMm) ? distanceMm - adaptive->lastMm : 
+      adaptive->lastMm - distanceMm) <= VIHCSR04_ADAPTIVE_STABLE_MM;
+
+  if (!stable)
+    adaptive->skip = 0;
+  else if (0 == adaptive->skip)
+    adaptive->skip = 1;
+  else if (VIHCSR04_ADAPTIVE_MAX_SKIP > adaptive->skip)
+    adaptive->skip = (2 * adaptive->skip < VIHCSR04_ADAPTIVE_MAX_SKIP) ? 
+      2 * adaptive->skip : VIHCSR04_ADAPTIVE_MAX_SKIP;
+
+  adaptive->skipLeft = adaptive->skip;
+  adaptive->lastMm = distanceMm;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_ADAPTIVE_H
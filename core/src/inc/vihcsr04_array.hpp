@@ -0,0 +1,317 @@
+/**
+ * @file vihcsr04_array.hpp
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Heap-free sensor array of HC-SR04 ultrasonic distance sensor control driver (c++ realisation)
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+#include "vihcsr04_math.h"
+#include "vihcsr04_filter.h"
+
+namespace vihcsr04 {
+
+  /**
+   * @brief Pins of one sensor of Hcsr04Array. Ports are addresses, 
+   *   so the configuration can be a constant expression (e.g. GPIOA_BASE)
+   * 
+   */
+  typedef struct {
+    uintptr_t triggerPort;                   /*!< address of GPIO structur of trigger pin */
+    uint16_t triggerPin;                     /*!< trigger pin number */
+    uintptr_t echoPort;                      /*!< address of GPIO structur of echo pin */
+    uint16_t echoPin;                        /*!< echo pin number */
+  } ArrayPins_t;
+
+  /**
+   * @brief Fixed size array of sensors without heap allocation and without indirect calls.
+   *   Sensors are addressed by index, pins are given at construction (can be constinit).
+   *   Gpio access and result delivery are static functions of Io, resolved at compile time:
+   *   - static void Trigger(uintptr_t port, uint16_t pin) - send 10 us trigger pulse
+   *   - static uint32_t PulseIn(uintptr_t port, uint16_t pin, uint32_t timeoutUs) - 
+   *     measure high pulse in microseconds, 0 if timeout (blocking mode only)
+   *   - static uint64_t NowUs(void) - current time in microseconds (edge driven mode only)
+   *   - static void Distance(size_t index, uint32_t distanceMm) - measurement result, 
+   *     INVALID_DISTANCE_MM if out of range
+   *   In edge driven mode sensors are measured one after another, 
+   *   edges of echo signal are reported by EchoEdge
+   * 
+   * @tparam N Number of sensors
+   * @tparam Io Static gpio and result interface
+   * @tparam EdgeDriven Edge driven mode
+   */
+  template<size_t N, typename Io, bool EdgeDriven = false>
+  class Hcsr04Array
+  {
+    static_assert(N > 0, "Hcsr04Array needs at least one sensor");
+
+  public:
+    static constexpr uint32_t INVALID_DISTANCE_MM = VIHCSR04_INVALID_DISTANCE_MM;
+
+    typedef enum {
+      ONESHOT_MEASURE = 0,  
+      CONTINUOUS_MEASURE
+    } MeasureMode_t;
+
+    /**
+     * @brief Construct sensor array
+     * 
+     * @param pins Pins of all sensors
+     */
+    constexpr explicit Hcsr04Array(const std::array<ArrayPins_t, N>& pins) {
+      for (size_t i = 0; i < N; i++)
+        m_sensors[i].pins = pins[i];
+    }
+
+    /**
+     * @brief Get number of sensors
+     * 
+     * @return size_t number of sensors
+     */
+    static constexpr size_t Size(void) { return N; }
+
+    /**
+     * @brief Set filter of sensor, see VIHCSR04_FilterCfg_t
+     * 
+     * @param index Sensor index
+     * @param cfg Filter configuration
+     * @return true if filter is set
+     * @return false if index or configuration is invalid
+     */
+    bool SetFilter(size_t index, const VIHCSR04_FilterCfg_t& cfg) {
+      if (index >= N || !VIHCSR04_FilterCfgValid(&cfg))
+        return false;
+      VIHCSR04_FilterInit(&m_sensors[index].filter, &cfg);
+      return true;
+    }
+
+    /**
+     * @brief Start async measurement, results are delivered by Io::Distance
+     * 
+     * @param index Sensor index
+     * @param mode Messurement mode
+     * @param temperature Current environment temperature
+     * @param maxDistanceCm Maximal measured distance
+     * @return true if measurement is started
+     * @return false if index is invalid
+     */
+    bool MeasureDistanceMmAsync(size_t index, MeasureMode_t mode, 
+        float temperature, uint16_t maxDistanceCm) {
+      if (index >= N)
+        return false;
+
+      Sensor_t& sensor = m_sensors[index];
+      sensor.mode = mode;
+      VIHCSR04_ConversionInit(&sensor.conv, temperature, maxDistanceCm);
+      VIHCSR04_FilterReset(&sensor.filter);
+      sensor.enabled = true;
+      return true;
+    }
+
+    /**
+     * @brief Stop measurement
+     * 
+     * @param index Sensor index
+     */
+    void StopContinuousMeasure(size_t index) {
+      if (index < N)
+        m_sensors[index].enabled = false;
+    }
+
+    /**
+     * @brief Sync distance measurement (blocking mode only), 
+     *   settings of async measurement are not changed
+     * 
+     * @param index Sensor index
+     * @param temperature Current environment temperature
+     * @param maxDistanceCm Maximal measured distance
+     * @return uint32_t distance in mm or INVALID_DISTANCE_MM
+     */
+    uint32_t MeasureDistanceMm(size_t index, float temperature, uint16_t maxDistanceCm) 
+      requires (!EdgeDriven) {
+      if (index >= N)
+        return INVALID_DISTANCE_MM;
+
+      VIHCSR04_Conversion_t conv;
+      VIHCSR04_ConversionInit(&conv, temperature, maxDistanceCm);
+
+      return VIHCSR04_ToMm(&conv, Ping(m_sensors[index], conv));
+    }
+
+    /**
+     * @brief Runtime, should be placed in main loop or in a task loop
+     * 
+     */
+    void Runtime(void) {
+      if constexpr (EdgeDriven) {
+        // current sensor is kept until its measurement is finished
+        if (!RuntimeEdgeDriven(m_sensors[m_current]))
+          return;
+
+        for (size_t i = 0; i < N; i++) {
+          m_current = (m_current + 1 < N) ? m_current + 1 : 0;
+          if (m_sensors[m_current].enabled) {
+            RuntimeEdgeDriven(m_sensors[m_current]);
+            return;
+          }
+        }
+      } else {
+        for (size_t i = 0; i < N; i++) {
+          Sensor_t& sensor = m_sensors[m_current];
+          m_current = (m_current + 1 < N) ? m_current + 1 : 0;
+          if (sensor.enabled) {
+            Complete(sensor, Ping(sensor, sensor.conv));
+            return;
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Report an edge of the echo signal (edge driven mode only).
+     *   Can be called from interrupt context
+     * 
+     * @param index Sensor index
+     * @param level Signal level after the edge: 1 - rising edge, 0 - falling edge
+     * @param timeUs Time stamp of the edge in microseconds (same time base as Io::NowUs)
+     */
+    void EchoEdge(size_t index, uint8_t level, uint64_t timeUs) requires EdgeDriven {
+      if (index >= N)
+        return;
+
+      Sensor_t& sensor = m_sensors[index];
+      if (level && TRIGGERED == sensor.state) {
+        sensor.echoRiseUs = timeUs;
+        sensor.state = ECHO_HIGH;
+      } else if (!level && ECHO_HIGH == sensor.state) {
+        sensor.echoFallUs = timeUs;
+        sensor.state = DONE;
+      }
+    }
+
+    /**
+     * @brief Find sensor by echo pin, e.g. to map an interrupt to sensor index
+     * 
+     * @param echoPort Address of GPIO structur of echo pin
+     * @param echoPin Echo pin number
+     * @return size_t sensor index, N if not found
+     */
+    constexpr size_t FindByEcho(uintptr_t echoPort, uint16_t echoPin) const {
+      for (size_t i = 0; i < N; i++) {
+        if (m_sensors[i].pins.echoPort == echoPort && m_sensors[i].pins.echoPin == echoPin)
+          return i;
+      }
+      return N;
+    }
+
+  private:
+    typedef enum {
+      IDLE = 0,
+      TRIGGERED,
+      ECHO_HIGH,
+      DONE
+    } State_t;
+
+    typedef struct
+    {
+      ArrayPins_t pins{};                    /*!< pins of sensor */
+      bool enabled{false};                   /*!< flag to enabled/disable if messurement */
+      MeasureMode_t mode{ONESHOT_MEASURE};   /*!< messurement mode */
+      VIHCSR04_Conversion_t conv{};          /*!< precomputed conversion for temperature and maxDistanceCm */
+      VIHCSR04_Filter_t filter{};            /*!< filter of measured distance */
+      volatile State_t state{IDLE};          /*!< state of edge driven measurement */
+      uint64_t triggerTimeUs{};              /*!< time stamp of the last trigger pulse */
+      volatile uint64_t echoRiseUs{};        /*!< time stamp of rising edge of echo */
+      volatile uint64_t echoFallUs{};        /*!< time stamp of falling edge of echo */
+    } Sensor_t;
+
+    /**
+     * @brief Blocking measurement of echo
+     * 
+     * @return uint32_t echo duration in microseconds, 0 if timeout
+     */
+    static uint32_t Ping(const Sensor_t& sensor, const VIHCSR04_Conversion_t& conv) {
+      Io::Trigger(sensor.pins.triggerPort, sensor.pins.triggerPin);
+      return Io::PulseIn(sensor.pins.echoPort, sensor.pins.echoPin, conv.maxEchoUs);
+    }
+
+    /**
+     * @brief Convert, filter and deliver result
+     * 
+     * @param durationUs Echo duration in microseconds, 0 if timeout
+     */
+    void Complete(Sensor_t& sensor, uint32_t durationUs) {
+      uint32_t distanceMm = VIHCSR04_ToMm(&sensor.conv, durationUs);
+
+      if (VIHCSR04_FILTER_NONE != sensor.filter.cfg.stages)
+        distanceMm = VIHCSR04_FilterApply(&sensor.filter, distanceMm);
+
+      if (ONESHOT_MEASURE == sensor.mode)
+        sensor.enabled = false;
+
+      Io::Distance(&sensor - m_sensors.data(), distanceMm);
+    }
+
+    /**
+     * @brief Edge driven runtime of one sensor, never blocks
+     * 
+     * @return true if no measurement is in progress
+     */
+    bool RuntimeEdgeDriven(Sensor_t& sensor) {
+      uint64_t now = Io::NowUs();
+
+      switch (sensor.state) {
+        case IDLE:
+          if (!sensor.enabled)
+            return true;
+          // state has to be changed before trigger, echo edge can come immediately
+          sensor.triggerTimeUs = now;
+          sensor.state = TRIGGERED;
+          Io::Trigger(sensor.pins.triggerPort, sensor.pins.triggerPin);
+          return false;
+
+        case TRIGGERED:
+          if (now - sensor.triggerTimeUs <= sensor.conv.maxEchoUs)
+            return false;
+          break;
+
+        case ECHO_HIGH:
+          if (now - sensor.echoRiseUs <= sensor.conv.maxEchoUs)
+            return false;
+          break;
+
+        case DONE:
+          sensor.state = IDLE;
+          Complete(sensor, (uint32_t)(sensor.echoFallUs - sensor.echoRiseUs));
+          return true;
+      }
+
+      // no echo edge received in time
+      sensor.state = IDLE;
+      Complete(sensor, 0);
+      return true;
+    }
+
+    std::array<Sensor_t, N> m_sensors{};
+    size_t m_current{0};
+  };
+}
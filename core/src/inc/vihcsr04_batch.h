@@ -0,0 +1,80 @@
+/**
+ * @file vihcsr04_batch.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Batch echo duration to distance conversion of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_BATCH_H
+#define VIHCSR04_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vihcsr04_math.h"
+
+/** 
+ * @brief Enable SIMD kernels (SSE4.1/AVX2 selected at runtime on x86, NEON on ARM), 
+ *   0 - only scalar kernel is built
+ * */
+#if !defined(VIHCSR04_BATCH_SIMD)
+  #define VIHCSR04_BATCH_SIMD 1
+#endif
+
+/**
+ * @brief Convert array of echo durations to distances in mm, 
+ *   results are equal to VIHCSR04_ToMm of every element
+ * 
+ * @param conv Pointer to precomputed conversion
+ * @param durationsUs Echo durations in microseconds, 0 if timeout
+ * @param distancesMm Destination, distance in mm or VIHCSR04_INVALID_DISTANCE_MM if out of range.
+ *   Can be the same array as durationsUs
+ * @param count Number of elements
+ */
+void VIHCSR04_ToMmBatch(const VIHCSR04_Conversion_t* conv, 
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count);
+
+/**
+ * @brief Convert array of echo durations to distances in mm with conversion per element,
+ *   e.g. one conversion per sensor or per temperature step. 
+ *   Results are equal to VIHCSR04_ToMm(&convs[convIndex[i]], durationsUs[i])
+ * 
+ * @param convs Table of precomputed conversions
+ * @param convIndex Index of conversion in table for every element
+ * @param durationsUs Echo durations in microseconds, 0 if timeout
+ * @param distancesMm Destination, distance in mm or VIHCSR04_INVALID_DISTANCE_MM if out of range
+ *   Can be the same array as durationsUs
+ * @param count Number of elements
+ */
+void VIHCSR04_ToMmBatchIndexed(const VIHCSR04_Conversion_t* convs, const uint16_t* convIndex,
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count);
+
+/**
+ * @brief Get name of kernel used by batch conversion on this machine
+ * 
+ * @return const char* "avx2", "sse4.1", "neon" or "scalar"
+ */
+const char* VIHCSR04_BatchKernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_BATCH_H
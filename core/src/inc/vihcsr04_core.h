@@ -0,0 +1,260 @@
+/**
+ * @file vihcsr04_core.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Measurement core of HC-SR04 ultrasonic distance sensor control driver, 
+ *   shared by c and c++ realisation
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_CORE_H
+#define VIHCSR04_CORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "vihcsr04_math.h"
+#include "vihcsr04_filter.h"
+#include "vihcsr04_event.h"
+#include "vihcsr04_adaptive.h"
+#include "vihcsr04_sched.h"
+#include "vihcsr04_trigger.h"
+#include "vihcsr04_stats.h"
+#include "vihcsr04_log.h"
+
+/** 
+ * @brief Debug output of runtime (log buffer and printf call-back). 
+ *   With 0 the runtime contains no debug code at all, 
+ *   log buffer and debug level are accepted but nothing is written
+ * */
+#if !defined(VIHCSR04_DEBUG)
+  #define VIHCSR04_DEBUG 1
+#endif
+
+/**
+ * @brief Debug level. Printf callback gets only info messages, 
+ *   debug and trace events are stored only in log buffer (VIHCSR04_SetLogBuffer)
+ * 
+ */
+typedef enum {
+  VIHCSR04_DEBUG_DISABLED = 0,  
+  VIHCSR04_DEBUG_INFO,          /*!< sensor creation, measurement start and result */
+  VIHCSR04_DEBUG_DEBUG,         /*!< additionally misses of adaptive timeout and deadlines */
+  VIHCSR04_DEBUG_TRACE          /*!< additionally echo edge timing and skipped turns */
+} VIHCSR04_DebugLvl_t;
+
+typedef uint64_t (*VIHCSR04_PulseIn_t)(
+  const void* gpio, uint16_t port, uint8_t state, 
+  uint64_t maxDurationTreshold, const void* context);
+
+typedef void (*VIHCSR04_TriggerPort_t) (
+  const void* gpio, uint16_t port, uint8_t state, 
+  uint64_t pulseDuration, const void* context);
+
+typedef void (*VIHCSR04_Distance_t) (float distance, const void* context);
+
+typedef void (*VIHCSR04_DistanceMm_t) (uint32_t distanceMm, const void* context);
+
+typedef int (*VIHCSR04_Printf_t) (const char *__format, ...);
+
+typedef uint64_t (*VIHCSR04_GetTimeUs_t) (void);
+
+/**
+ * @brief State of edge driven measurement
+ * 
+ */
+typedef enum {
+  VIHCSR04_SENSOR_IDLE = 0,     /*!< no measurement in progress */
+  VIHCSR04_SENSOR_TRIGGERED,    /*!< trigger pulse is sent, waiting for rising edge of echo */
+  VIHCSR04_SENSOR_ECHO_HIGH,    /*!< echo is high, waiting for falling edge */
+  VIHCSR04_SENSOR_DONE          /*!< falling edge received, result is ready */
+} VIHCSR04_SensorState_t;
+
+/**
+ * @brief Phase of firing group scheduler in edge driven mode
+ * 
+ */
+typedef enum {
+  VIHCSR04_GROUP_SELECT = 0,    /*!< next group has to be selected and triggered */
+  VIHCSR04_GROUP_MEASURING,     /*!< sensors of current group are measuring */
+  VIHCSR04_GROUP_GUARD          /*!< waiting for echo decay before next group */
+} VIHCSR04_GroupPhase_t;
+
+/**
+ * @brief Runtime state of one sensor: pins, callbacks, schedule, edge state 
+ *   and everything between echo duration and reported distance. 
+ *   Names, handles and buffers are kept by the front end
+ * 
+ */
+typedef struct {
+  const void* triggerPort;      /*!< pointer to the physical port, to witch the trigger pin of sensor is connected*/
+  uint16_t triggerPin;          /*!< pin number, to witch the the trigger pin of sensor is connected*/
+  const void* echoPort;         /*!< pointer to the physical port, to witch the echo pin of sensor is connected*/
+  uint16_t echoPin;             /*!< pin number, to witch the echo pin of sensor is connected*/
+  bool enabled;                 /*!< flag to enabled/disable if messurement */
+  bool continuous;              /*!< continuous measurement, one shot measurement is disabled by its result */
+  const void* userContext;      /*!< user context that is returned by calling distCb */
+  VIHCSR04_Distance_t distCb;   /*!< call-back funktion will be called if meassurement is done */
+  VIHCSR04_DistanceMm_t distMmCb; /*!< call-back funktion with distance in mm, used instead of distCb if set */
+  VIHCSR04_Conversion_t conv;   /*!< precomputed conversion for temperature and maxDistanceCm */
+  uint32_t lastDurationUs;      /*!< echo duration of the last measurement, 0 if timeout */
+  VIHCSR04_Filter_t filter;     /*!< filter of measured distance */
+  VIHCSR04_Event_t event;       /*!< event delivery state */
+  VIHCSR04_Adaptive_t adaptive; /*!< adaptive echo timeout and ping rate */
+#if VIHCSR04_STATS
+  VIHCSR04_Stats_t stats;       /*!< runtime statistics */
+#endif
+  VIHCSR04_Sched_t sched;       /*!< target period and deadline of measurements */
+  uint32_t group;               /*!< firing group, sensors of one group are triggered simultaneously */
+  volatile VIHCSR04_SensorState_t state; /*!< state of edge driven measurement */
+  uint64_t triggerTimeUs;       /*!< time stamp of the last trigger pulse */
+  volatile uint64_t echoRiseUs; /*!< time stamp of rising edge of echo */
+  volatile uint64_t echoFallUs; /*!< time stamp of falling edge of echo */
+} VIHCSR04_Core_t;
+
+/**
+ * @brief Sensors of one bus with pin and time callbacks and scheduler state. 
+ *   Runtime of bus is in vihcsr04_core_run.h, hooks of front end and 
+ *   distance of cores of two slots are chosen there at compile time
+ * 
+ */
+typedef struct {
+  void* drv;                                     /*!< front end owning this bus */
+  VIHCSR04_Core_t* sensors;                      /*!< core of slot 0 */
+  uint32_t number;                               /*!< number of used slots, including slots of deleted sensors */
+  VIHCSR04_PulseIn_t pulseInCb;                  /*!< call-back funktion to measure pulse duration*/
+  VIHCSR04_TriggerPort_t triggerPortCb;          /*!< call-back funktion to trigger a pulse*/
+  VIHCSR04_GetTimeUs_t getTimeUsCb;              /*!< call-back funktion to get current time */
+  VIHCSR04_TriggerMask_t triggerMaskCb;          /*!< optional call-back funktion to trigger pins of one port */
+  bool edgeDriven;                               /*!< echo is reported by edges */
+  uint32_t currentSnsr;                          /*!< current handled sensor of round robin */
+  VIHCSR04_GroupPhase_t groupPhase;              /*!< phase of firing group scheduler */
+  uint32_t currentGroup;                         /*!< currently handled firing group */
+  uint32_t guardIntervalUs;                      /*!< guard interval between measurements or firing groups */
+  uint64_t guardEndUs;                           /*!< end of current guard interval */
+  uint32_t periodicNumber;                       /*!< number of sensors with period */
+  VIHCSR04_Printf_t printfCb;                    /*!< printf callback */
+  VIHCSR04_DebugLvl_t debugLvl;                  /*!< debug level */
+} VIHCSR04_CoreBus_t;
+
+/**
+ * @brief Start of a ping
+ * 
+ * @param core Measurement state of sensor
+ * @param nowUs Current time, 0 if no time source is set
+ * @return uint32_t echo timeout in microseconds
+ */
+static inline uint32_t VIHCSR04_CoreStart(VIHCSR04_Core_t* core, uint64_t nowUs) {
+#if VIHCSR04_STATS
+  VIHCSR04_StatsPing(&core->stats, nowUs);
+#else
+  (void)nowUs;
+#endif
+  return VIHCSR04_AdaptiveTimeout(&core->adaptive, &core->conv);
+}
+
+/**
+ * @brief Check if an echo timeout is a miss of narrowed timeout, 
+ *   which is repeated with full range instead of being reported
+ * 
+ * @param core Measurement state of sensor
+ * @param durationUs Echo duration, 0 if timeout
+ * @return true if ping has to be repeated
+ */
+static inline bool VIHCSR04_CoreMiss(VIHCSR04_Core_t* core, uint64_t durationUs) {
+  return 0 == durationUs && VIHCSR04_AdaptiveMiss(&core->adaptive, &core->conv);
+}
+
+/**
+ * @brief Result of a ping: conversion, adaptive timeout, filter and statistics
+ * 
+ * @param core Measurement state of sensor
+ * @param durationUs Echo duration, 0 if timeout
+ * @param timed true if nowUs is taken from a time source
+ * @param nowUs Current time
+ * @return uint32_t distance in mm after filter, VIHCSR04_INVALID_DISTANCE_MM if out of range
+ */
+static inline uint32_t VIHCSR04_CoreResult(VIHCSR04_Core_t* core, 
+  uint64_t durationUs, bool timed, uint64_t nowUs) {
+
+  core->lastDurationUs = (durationUs > UINT32_MAX) ? UINT32_MAX : (uint32_t)durationUs;
+
+  uint32_t distanceMm = VIHCSR04_ToMm(&core->conv, core->lastDurationUs);
+
+  VIHCSR04_AdaptiveUpdate(&core->adaptive, distanceMm);
+
+  if(VIHCSR04_FILTER_NONE != core->filter.cfg.stages)
+    distanceMm = VIHCSR04_FilterApply(&core->filter, distanceMm);
+
+#if VIHCSR04_STATS
+  VIHCSR04_StatsResult(&core->stats, core->lastDurationUs, distanceMm, timed, nowUs);
+#else
+  (void)timed;
+  (void)nowUs;
+#endif
+
+  return distanceMm;
+}
+
+/**
+ * @brief Distance of the last result in cm for float call-back, 
+ *   filtered distance if filter is set, otherwise exact conversion of echo duration
+ * 
+ * @param core Measurement state of sensor
+ * @param distanceMm Result of VIHCSR04_CoreResult
+ * @return float distance in cm
+ */
+static inline float VIHCSR04_CoreCm(const VIHCSR04_Core_t* core, uint32_t distanceMm) {
+  return (VIHCSR04_FILTER_NONE != core->filter.cfg.stages) ? 
+    VIHCSR04_MmToCm(distanceMm) : VIHCSR04_ToCm(&core->conv, core->lastDurationUs);
+}
+
+/**
+ * @brief Check if result is reported to distance call-back, 
+ *   in event mode only changes are reported
+ * 
+ * @param core Measurement state of sensor
+ * @param distanceMm Result of VIHCSR04_CoreResult
+ * @param timed true if nowUs is taken from a time source
+ * @param nowUs Current time
+ * @return true if call-back has to be called
+ */
+static inline bool VIHCSR04_CoreNotify(VIHCSR04_Core_t* core, 
+  uint32_t distanceMm, bool timed, uint64_t nowUs) {
+  return !core->event.enabled || 
+    VIHCSR04_EventUpdate(&core->event, distanceMm, timed, nowUs);
+}
+
+/**
+ * @brief Current time
+ * 
+ * @param bus Sensors of bus
+ * @return uint64_t time in microseconds, 0 if no time source is set
+ */
+static inline uint64_t VIHCSR04_CoreNow(const VIHCSR04_CoreBus_t* bus) {
+  return (NULL != bus->getTimeUsCb) ? bus->getTimeUsCb() : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_CORE_H
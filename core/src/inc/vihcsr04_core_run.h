@@ -0,0 +1,721 @@
+/**
+ * @file vihcsr04_core_run.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Runtime of measurement core of HC-SR04 ultrasonic distance sensor control driver, 
+ *   shared by c and c++ realisation. Included only by the source of a front end, 
+ *   which defines its hooks before:
+ *   - VIHCSR04_CORE_STRIDE distance of cores of two slots in bytes
+ *   - VIHCSR04_CORE_LOG(bus, lvl, event, index, value0, value1) store log record, 
+ *     false if no log buffer is set and the event has to be printed
+ *   - VIHCSR04_CORE_NAME(bus, index) name of sensor in slot for printf output
+ *   - VIHCSR04_CORE_PUBLISH(bus, index, durationUs, distanceMm, nowUs) result of 
+ *     async measurement for sample buffer and shared memory
+ *   - VIHCSR04_CORE_RECORD(bus, index, durationUs) optional, raw echo duration 
+ *     of every ping for recorder
+ *   Hooks are resolved at compile time, the runtime makes no indirect calls of its own
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_CORE_RUN_H
+#define VIHCSR04_CORE_RUN_H
+
+#include "vihcsr04_core.h"
+
+#if !defined(VIHCSR04_CORE_STRIDE) || !defined(VIHCSR04_CORE_LOG) || \
+  !defined(VIHCSR04_CORE_NAME) || !defined(VIHCSR04_CORE_PUBLISH)
+  #error "hooks of front end have to be defined before vihcsr04_core_run.h is included"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Core of sensor in slot
+ * 
+ * @param bus Sensors of bus
+ * @param index Slot index
+ * @return VIHCSR04_Core_t* core of sensor
+ */
+static inline VIHCSR04_Core_t* VIHCSR04_CoreAt(const VIHCSR04_CoreBus_t* bus, uint32_t index) {
+  return (VIHCSR04_Core_t*)((char*)bus->sensors + (size_t)index * (VIHCSR04_CORE_STRIDE));
+}
+
+/**
+ * @brief Slot index of sensor
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @return uint32_t slot index
+ */
+static inline uint32_t VIHCSR04_CoreIndex(const VIHCSR04_CoreBus_t* bus, const VIHCSR04_Core_t* core) {
+  return (uint32_t)((size_t)((const char*)core - (const char*)bus->sensors) / (VIHCSR04_CORE_STRIDE));
+}
+
+/**
+ * @brief Log event of sensor: store it in log buffer of front end if level is enabled
+ * 
+ * @param bus Sensors of bus
+ * @param lvl Debug level of event
+ * @param event Logged event
+ * @param core Core of sensor
+ * @param value0 First raw value, see VIHCSR04_LogEvent_t
+ * @param value1 Second raw value, see VIHCSR04_LogEvent_t
+ * @return true if event has to be printed by printf callback instead, 
+ *   only info events are printed and only without log buffer
+ */
+static inline bool VIHCSR04_CoreLog(VIHCSR04_CoreBus_t* bus, VIHCSR04_DebugLvl_t lvl, 
+  VIHCSR04_LogEvent_t event, const VIHCSR04_Core_t* core, uint32_t value0, uint32_t value1) {
+#if VIHCSR04_DEBUG
+  if(lvl > bus->debugLvl || 
+    VIHCSR04_CORE_LOG(bus, lvl, event, VIHCSR04_CoreIndex(bus, core), value0, value1))
+    return false;
+
+  return VIHCSR04_DEBUG_INFO == lvl && NULL != bus->printfCb;
+#else
+  (void)bus;
+  (void)lvl;
+  (void)event;
+  (void)core;
+  (void)value0;
+  (void)value1;
+  return false;
+#endif
+}
+
+/**
+ * @brief Log creation of sensor
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of created sensor
+ */
+static inline void VIHCSR04_CoreCreated(VIHCSR04_CoreBus_t* bus, const VIHCSR04_Core_t* core) {
+  if(VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_INFO, VIHCSR04_LOG_CREATED, core, 
+    core->triggerPin, core->echoPin))
+    bus->printfCb("Sensor \"%s\": is initialized\r\n", 
+      VIHCSR04_CORE_NAME(bus, VIHCSR04_CoreIndex(bus, core)));
+}
+
+/**
+ * @brief Log start of ping
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param timeoutUs Echo timeout in microseconds
+ */
+static inline void VIHCSR04_CoreTriggered(VIHCSR04_CoreBus_t* bus, const VIHCSR04_Core_t* core, 
+  uint32_t timeoutUs) {
+  if(VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_INFO, VIHCSR04_LOG_TRIGGER, core, timeoutUs, core->group))
+    bus->printfCb("Sensor \"%s\": measurement startet\r\n", 
+      VIHCSR04_CORE_NAME(bus, VIHCSR04_CoreIndex(bus, core)));
+}
+
+/**
+ * @brief Log result of measurement
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param durationUs Echo duration, 0 if timeout
+ * @param distanceMm Reported distance in mm
+ * @param distanceCm Reported distance in cm for printf output
+ */
+static inline void VIHCSR04_CoreMeasured(VIHCSR04_CoreBus_t* bus, const VIHCSR04_Core_t* core, 
+  uint32_t durationUs, uint32_t distanceMm, float distanceCm) {
+  if(VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_INFO, VIHCSR04_LOG_RESULT, core, durationUs, distanceMm))
+    bus->printfCb("Sensor \"%s\": measured distance %f\r\n", 
+      VIHCSR04_CORE_NAME(bus, VIHCSR04_CoreIndex(bus, core)), distanceCm);
+}
+
+/**
+ * @brief Pass raw echo duration of a ping to recorder of front end, 
+ *   nothing is done if front end has no recorder
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param durationUs Echo duration, 0 if timeout
+ */
+static inline void VIHCSR04_CoreRecord(VIHCSR04_CoreBus_t* bus, const VIHCSR04_Core_t* core, 
+  uint64_t durationUs) {
+#if defined(VIHCSR04_CORE_RECORD)
+  VIHCSR04_CORE_RECORD(bus, VIHCSR04_CoreIndex(bus, core), 
+    (durationUs > UINT32_MAX) ? UINT32_MAX : (uint32_t)durationUs);
+#else
+  (void)bus;
+  (void)core;
+  (void)durationUs;
+#endif
+}
+
+/**
+ * @brief Hold trigger for 10 microseconds, which is signal for sensor to measure distance
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ */
+static inline void VIHCSR04_CoreTrigger(VIHCSR04_CoreBus_t* bus, const VIHCSR04_Core_t* core) {
+  bus->triggerPortCb(core->triggerPort, core->triggerPin, 1, 10, core->userContext);
+}
+
+/**
+ * @brief Start async measurement, callbacks and user context are set by the front end
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param continuous Continuous or one shot measurement
+ * @param temperature Current environment temperature
+ * @param maxDistanceCm Maximal measured distance
+ */
+static inline void VIHCSR04_CoreMeasureAsync(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core, 
+  bool continuous, float temperature, uint16_t maxDistanceCm) {
+
+  core->continuous = continuous;
+  VIHCSR04_ConversionInit(&core->conv, temperature, maxDistanceCm);
+  VIHCSR04_FilterReset(&core->filter);
+  VIHCSR04_EventReset(&core->event);
+  VIHCSR04_AdaptiveInit(&core->adaptive, core->adaptive.enabled);
+  // first period starts now, the time of stopped measurement is not a deadline miss
+  core->sched.releaseUs = VIHCSR04_CoreNow(bus);
+  core->enabled = true;
+}
+
+/**
+ * @brief Set period of sensor, 0 - sensor is scheduled round robin
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param periodUs Target period in microseconds
+ */
+static inline void VIHCSR04_CoreSetPeriod(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core, 
+  uint32_t periodUs) {
+
+  if(0 != core->sched.periodUs)
+    bus->periodicNumber--;
+  if(0 != periodUs)
+    bus->periodicNumber++;
+
+  VIHCSR04_SchedInit(&core->sched, periodUs, VIHCSR04_CoreNow(bus));
+}
+
+/**
+ * @brief Store echo duration, pass result to front end and notify user
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param durationUs Measured echo duration, 0 if timeout
+ */
+static inline void VIHCSR04_CoreComplete(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core, 
+  uint64_t durationUs) {
+
+  bool timed = NULL != bus->getTimeUsCb;
+  uint64_t nowUs = VIHCSR04_CoreNow(bus);
+  uint32_t distanceMm = VIHCSR04_CoreResult(core, durationUs, timed, nowUs);
+
+  VIHCSR04_CORE_PUBLISH(bus, VIHCSR04_CoreIndex(bus, core), core->lastDurationUs, distanceMm, nowUs);
+
+  VIHCSR04_CoreMeasured(bus, core, core->lastDurationUs, distanceMm, 
+    VIHCSR04_CoreCm(core, distanceMm));
+
+  // in event mode only changes are reported, every result is still measured
+  if(VIHCSR04_CoreNotify(core, distanceMm, timed, nowUs)) {
+#if VIHCSR04_STATS
+    if(timed)
+      nowUs = bus->getTimeUsCb();
+#endif
+
+    if(core->distMmCb)
+      core->distMmCb(distanceMm, core->userContext);
+    else if(core->distCb)
+      core->distCb(VIHCSR04_CoreCm(core, distanceMm), core->userContext);
+
+#if VIHCSR04_STATS
+    if(timed)
+      VIHCSR04_HistAdd(&core->stats.callbackUs, (uint32_t)(bus->getTimeUsCb() - nowUs));
+#endif
+  }
+
+  if(!core->continuous)
+    core->enabled = false;
+}
+
+/**
+ * @brief Check if a stable sensor in adaptive mode skips current scheduler turn
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @return true if the turn is skipped
+ */
+static inline bool VIHCSR04_CoreSkipTurn(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core) {
+
+  if(!core->enabled || !core->continuous || !VIHCSR04_AdaptiveSkip(&core->adaptive))
+    return false;
+
+  VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_TRACE, VIHCSR04_LOG_ADAPTIVE_SKIP, core, 
+    core->adaptive.skipLeft, 0);
+  return true;
+}
+
+/**
+ * @brief Check if sensor is scheduled by its period, 
+ *   sensors with period are scheduled round robin if no time source is set
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @return true if sensor has period and time source is set
+ */
+static inline bool VIHCSR04_CorePeriodic(const VIHCSR04_CoreBus_t* bus, const VIHCSR04_Core_t* core) {
+  return 0 != core->sched.periodUs && NULL != bus->getTimeUsCb;
+}
+
+/**
+ * @brief Move sensor with period to the next period, account and log deadline miss
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param nowUs Time of trigger
+ */
+static inline void VIHCSR04_CoreSchedStart(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core, 
+  uint64_t nowUs) {
+
+  uint32_t latenessUs = VIHCSR04_SchedStart(&core->sched, nowUs);
+
+  if(0 < latenessUs)
+    VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_DEBUG, VIHCSR04_LOG_DEADLINE_MISS, core, 
+      latenessUs, core->sched.periodUs);
+}
+
+/**
+ * @brief Select released sensor with period with earliest deadline
+ * 
+ * @param bus Sensors of bus
+ * @param nowUs Current time
+ * @return VIHCSR04_Core_t* core of selected sensor, NULL if no sensor is released
+ */
+static inline VIHCSR04_Core_t* VIHCSR04_CoreSelectPeriodic(VIHCSR04_CoreBus_t* bus, uint64_t nowUs) {
+
+  VIHCSR04_Core_t* selected = NULL;
+
+  if(0 == bus->periodicNumber)
+    return NULL;
+
+  for(uint32_t i = 0; i < bus->number; i++) {
+    VIHCSR04_Core_t* core = VIHCSR04_CoreAt(bus, i);
+
+    if(!core->enabled || 0 == core->sched.periodUs || !VIHCSR04_SchedDue(&core->sched, nowUs))
+      continue;
+
+    if(NULL == selected || (int64_t)(VIHCSR04_SchedDeadline(&core->sched) - 
+      VIHCSR04_SchedDeadline(&selected->sched)) < 0)
+      selected = core;
+  }
+
+  return selected;
+}
+
+/**
+ * @brief Single blocking ping of async measurement
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ */
+static inline void VIHCSR04_CoreRunBlocking(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core) {
+
+  if(!core->enabled)
+    return;
+
+  uint64_t nowUs = VIHCSR04_CoreNow(bus);
+  uint32_t timeoutUs = VIHCSR04_CoreStart(core, nowUs);
+
+  VIHCSR04_CoreTriggered(bus, core, timeoutUs);
+
+  if(VIHCSR04_CorePeriodic(bus, core))
+    VIHCSR04_CoreSchedStart(bus, core, nowUs);
+
+  VIHCSR04_CoreTrigger(bus, core);
+
+  // Measure the length of echo signal, which is equal to the time needed for sound to go there and back.
+  uint64_t durationUs = bus->pulseInCb(core->echoPort, core->echoPin, 1, 
+    (uint64_t)timeoutUs*1000, core->userContext);
+
+  VIHCSR04_CoreRecord(bus, core, durationUs);
+
+  // miss of narrowed timeout is repeated with full range in the next turn
+  if(VIHCSR04_CoreMiss(core, durationUs)) {
+    VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_DEBUG, VIHCSR04_LOG_ADAPTIVE_MISS, core, timeoutUs, 0);
+    return;
+  }
+
+  VIHCSR04_CoreComplete(bus, core, durationUs);
+}
+
+/**
+ * @brief Edge driven state machine of async measurement, never blocks
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param batch Batch collecting trigger pin of started measurement, NULL - trigger immediately
+ * @return true if no measurement is in progress and next sensor can be handled
+ * @return false if measurement is in progress
+ */
+static inline bool VIHCSR04_CoreRunEdgeDriven(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core, 
+  VIHCSR04_TriggerBatch_t* batch) {
+
+  uint64_t nowUs = bus->getTimeUsCb();
+
+  switch(core->state) {
+    case VIHCSR04_SENSOR_IDLE:
+      if(!core->enabled)
+        return true;
+
+      VIHCSR04_CoreStart(core, nowUs);
+      VIHCSR04_CoreTriggered(bus, core, core->adaptive.timeoutUs);
+
+      if(VIHCSR04_CorePeriodic(bus, core))
+        VIHCSR04_CoreSchedStart(bus, core, nowUs);
+
+      // state has to be changed before trigger, echo edge can come immediately
+      core->triggerTimeUs = nowUs;
+      core->state = VIHCSR04_SENSOR_TRIGGERED;
+      // pins of batch are triggered together after the whole group is prepared
+      if(NULL == batch || !VIHCSR04_TriggerBatchAdd(batch, core->triggerPort, core->triggerPin))
+        VIHCSR04_CoreTrigger(bus, core);
+      return false;
+
+    case VIHCSR04_SENSOR_TRIGGERED:
+      if(nowUs - core->triggerTimeUs <= core->adaptive.timeoutUs)
+        return false;
+      break;
+
+    case VIHCSR04_SENSOR_ECHO_HIGH:
+      if(nowUs - core->echoRiseUs <= core->adaptive.timeoutUs)
+        return false;
+      break;
+
+    case VIHCSR04_SENSOR_DONE:
+      core->state = VIHCSR04_SENSOR_IDLE;
+      VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_TRACE, VIHCSR04_LOG_ECHO, core, 
+        (uint32_t)(core->echoRiseUs - core->triggerTimeUs), 
+        (uint32_t)(core->echoFallUs - core->echoRiseUs));
+      VIHCSR04_CoreRecord(bus, core, core->echoFallUs - core->echoRiseUs);
+      VIHCSR04_CoreComplete(bus, core, core->echoFallUs - core->echoRiseUs);
+      return true;
+  }
+
+  // no echo edge received in time
+  core->state = VIHCSR04_SENSOR_IDLE;
+  VIHCSR04_CoreRecord(bus, core, 0);
+
+  // miss of narrowed timeout is repeated with full range in the next cycle
+  uint32_t timeoutUs = core->adaptive.timeoutUs;
+
+  if(VIHCSR04_CoreMiss(core, 0))
+    VIHCSR04_CoreLog(bus, VIHCSR04_DEBUG_DEBUG, VIHCSR04_LOG_ADAPTIVE_MISS, core, timeoutUs, 0);
+  else
+    VIHCSR04_CoreComplete(bus, core, 0);
+  return true;
+}
+
+/**
+ * @brief Firing group scheduler runtime (edge driven mode)
+ * 
+ * @param bus Sensors of bus
+ */
+static inline void VIHCSR04_CoreRuntimeGroups(VIHCSR04_CoreBus_t* bus) {
+
+  uint64_t nowUs = bus->getTimeUsCb();
+
+  if(VIHCSR04_GROUP_GUARD == bus->groupPhase) {
+    if((int64_t)(nowUs - bus->guardEndUs) < 0)
+      return;
+    bus->groupPhase = VIHCSR04_GROUP_SELECT;
+  }
+
+  if(VIHCSR04_GROUP_SELECT == bus->groupPhase) {
+    // group of released sensor with earliest deadline is served first
+    VIHCSR04_Core_t* urgent = VIHCSR04_CoreSelectPeriodic(bus, nowUs);
+
+    // otherwise next group is the smallest group with enabled sensors without period 
+    // after current one, or the smallest such group at all if current was the last one
+    bool foundNext = false, foundFirst = false;
+    uint32_t nextGroup = 0, firstGroup = 0;
+
+    for(uint32_t i = 0; NULL == urgent && i < bus->number; i++) {
+      const VIHCSR04_Core_t* core = VIHCSR04_CoreAt(bus, i);
+      if(!core->enabled || VIHCSR04_CorePeriodic(bus, core))
+        continue;
+      if(!foundFirst || core->group < firstGroup) {
+        firstGroup = core->group;
+        foundFirst = true;
+      }
+      if(core->group > bus->currentGroup && 
+        (!foundNext || core->group < nextGroup)) {
+        nextGroup = core->group;
+        foundNext = true;
+      }
+    }
+
+    if(NULL != urgent)
+      bus->currentGroup = urgent->group;
+    else if(foundFirst)
+      bus->currentGroup = foundNext ? nextGroup : firstGroup;
+    else
+      return;
+
+    bool triggered = false;
+    VIHCSR04_TriggerBatch_t batch;
+    VIHCSR04_TriggerBatchInit(&batch);
+
+    // sensors with period are triggered only if released
+    for(uint32_t i = 0; i < bus->number; i++) {
+      VIHCSR04_Core_t* core = VIHCSR04_CoreAt(bus, i);
+      if(core->group != bus->currentGroup || (VIHCSR04_CorePeriodic(bus, core) ? 
+        !VIHCSR04_SchedDue(&core->sched, nowUs) : VIHCSR04_CoreSkipTurn(bus, core)))
+        continue;
+      if(!VIHCSR04_CoreRunEdgeDriven(bus, core, (NULL != bus->triggerMaskCb) ? &batch : NULL))
+        triggered = true;
+    }
+
+    // one write per port raises trigger pins of all sensors of group
+    for(uint32_t i = 0; i < batch.ports; i++) {
+      bus->triggerMaskCb(batch.gpio[i], batch.pinMask[i], 1, 10);
+    }
+
+    // group of skipped sensors needs no guard interval
+    if(triggered)
+      bus->groupPhase = VIHCSR04_GROUP_MEASURING;
+    return;
+  }
+
+  bool finished = true;
+
+  for(uint32_t i = 0; i < bus->number; i++) {
+    VIHCSR04_Core_t* core = VIHCSR04_CoreAt(bus, i);
+    // sensors which have already finished must not be triggered again in this cycle
+    if(core->group != bus->currentGroup || VIHCSR04_SENSOR_IDLE == core->state)
+      continue;
+    if(!VIHCSR04_CoreRunEdgeDriven(bus, core, NULL))
+      finished = false;
+  }
+
+  if(!finished)
+    return;
+
+  bus->guardEndUs = bus->getTimeUsCb() + bus->guardIntervalUs;
+  bus->groupPhase = VIHCSR04_GROUP_GUARD;
+}
+
+/**
+ * @brief One runtime step of bus: a blocking ping of the next sensor 
+ *   or a step of firing group scheduler in edge driven mode
+ * 
+ * @param bus Sensors of bus
+ */
+static inline void VIHCSR04_CoreRuntime(VIHCSR04_CoreBus_t* bus) {
+
+  if(0 == bus->number)
+    return;
+
+  if(bus->edgeDriven) {
+    VIHCSR04_CoreRuntimeGroups(bus);
+    return;
+  }
+
+  bool timed = NULL != bus->getTimeUsCb;
+  VIHCSR04_Core_t* core = NULL;
+
+  if(timed && (0 < bus->periodicNumber || 0 < bus->guardIntervalUs)) {
+    uint64_t nowUs = bus->getTimeUsCb();
+
+    // echoes of the previous measurement have to decay
+    if(0 < bus->guardIntervalUs && (int64_t)(nowUs - bus->guardEndUs) < 0)
+      return;
+
+    // released sensors with period are served first, by earliest deadline
+    core = VIHCSR04_CoreSelectPeriodic(bus, nowUs);
+  }
+
+  // sensors without period share the rest round robin, 
+  // slots of deleted and stopped sensors are skipped
+  for(uint32_t i = 0; NULL == core && i < bus->number; i++) {
+    if(bus->currentSnsr >= bus->number)
+      bus->currentSnsr = 0;
+
+    VIHCSR04_Core_t* next = VIHCSR04_CoreAt(bus, bus->currentSnsr++);
+
+    if(next->enabled && !VIHCSR04_CorePeriodic(bus, next) && !VIHCSR04_CoreSkipTurn(bus, next))
+      core = next;
+  }
+
+  if(NULL == core)
+    return;
+
+  VIHCSR04_CoreRunBlocking(bus, core);
+
+  if(timed && 0 < bus->guardIntervalUs)
+    bus->guardEndUs = bus->getTimeUsCb() + bus->guardIntervalUs;
+}
+
+/**
+ * @brief Get time of the next action required from runtime
+ * 
+ * @param bus Sensors of bus
+ * @param nowUs Current time
+ * @return uint64_t time of next action, nowUs if work is ready, 
+ *   VIHCSR04_NO_DEADLINE if no sensor is measured
+ */
+static inline uint64_t VIHCSR04_CoreNextAction(const VIHCSR04_CoreBus_t* bus, uint64_t nowUs) {
+
+  uint64_t nextUs = VIHCSR04_NO_DEADLINE;
+
+  if(bus->edgeDriven && VIHCSR04_GROUP_MEASURING == bus->groupPhase) {
+    // the latest action is the echo timeout of a sensor of current group
+    for(uint32_t i = 0; i < bus->number; i++) {
+      const VIHCSR04_Core_t* core = VIHCSR04_CoreAt(bus, i);
+
+      if(core->group != bus->currentGroup || VIHCSR04_SENSOR_IDLE == core->state)
+        continue;
+
+      uint64_t actionUs = nowUs;
+      if(VIHCSR04_SENSOR_TRIGGERED == core->state)
+        actionUs = core->triggerTimeUs + core->adaptive.timeoutUs + 1;
+      else if(VIHCSR04_SENSOR_ECHO_HIGH == core->state)
+        actionUs = core->echoRiseUs + core->adaptive.timeoutUs + 1;
+
+      nextUs = VIHCSR04_SchedEarliest(nextUs, actionUs);
+    }
+
+    // group without pending sensors is finished by the next step
+    if(VIHCSR04_NO_DEADLINE == nextUs)
+      return nowUs;
+  } else {
+    // sensors without period are measured as often as possible
+    for(uint32_t i = 0; i < bus->number; i++) {
+      const VIHCSR04_Core_t* core = VIHCSR04_CoreAt(bus, i);
+
+      if(core->enabled)
+        nextUs = VIHCSR04_SchedEarliest(nextUs, 
+          VIHCSR04_CorePeriodic(bus, core) ? core->sched.releaseUs : nowUs);
+    }
+
+    if(VIHCSR04_NO_DEADLINE == nextUs)
+      return VIHCSR04_NO_DEADLINE;
+
+    // echoes of the previous measurement have to decay
+    if((bus->edgeDriven ? VIHCSR04_GROUP_GUARD == bus->groupPhase : 0 < bus->guardIntervalUs) && 
+      (int64_t)(bus->guardEndUs - nextUs) > 0)
+      nextUs = bus->guardEndUs;
+  }
+
+  return ((int64_t)(nextUs - nowUs) < 0) ? nowUs : nextUs;
+}
+
+/**
+ * @brief Edge of echo signal of sensor, advances edge driven state machine. 
+ *   Can be called from interrupt context
+ * 
+ * @param core Core of sensor
+ * @param level Level of echo signal after the edge
+ * @param timeUs Time stamp of the edge
+ */
+static inline void VIHCSR04_CoreEchoEdge(VIHCSR04_Core_t* core, uint8_t level, uint64_t timeUs) {
+  if(level && VIHCSR04_SENSOR_TRIGGERED == core->state) {
+    core->echoRiseUs = timeUs;
+    core->state = VIHCSR04_SENSOR_ECHO_HIGH;
+  } else if(!level && VIHCSR04_SENSOR_ECHO_HIGH == core->state) {
+    core->echoFallUs = timeUs;
+    core->state = VIHCSR04_SENSOR_DONE;
+  }
+}
+
+/**
+ * @brief Single ping with per-call echo timeout, blocks until echo or timeout. 
+ *   In edge driven mode edges are reported by VIHCSR04_CoreEchoEdge as for 
+ *   async measurement and the wait is bounded by the echo timeout. 
+ *   Filter, statistics and callbacks are not touched
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param timeoutUs Echo timeout in microseconds
+ * @return uint32_t echo duration, 0 if timeout
+ */
+static inline uint32_t VIHCSR04_CorePing(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core, 
+  uint32_t timeoutUs) {
+
+  uint64_t durationUs = 0;
+
+  VIHCSR04_CoreTriggered(bus, core, timeoutUs);
+
+  if(!bus->edgeDriven) {
+    VIHCSR04_CoreTrigger(bus, core);
+    durationUs = bus->pulseInCb(core->echoPort, core->echoPin, 1, 
+      (uint64_t)timeoutUs*1000, core->userContext);
+  } else {
+    core->triggerTimeUs = bus->getTimeUsCb();
+    core->state = VIHCSR04_SENSOR_TRIGGERED;
+    VIHCSR04_CoreTrigger(bus, core);
+
+    uint64_t nowUs = core->triggerTimeUs;
+
+    // missing edge ends the wait at echo timeout
+    while((VIHCSR04_SENSOR_TRIGGERED == core->state && nowUs - core->triggerTimeUs <= timeoutUs) || 
+      (VIHCSR04_SENSOR_ECHO_HIGH == core->state && nowUs - core->echoRiseUs <= timeoutUs))
+      nowUs = bus->getTimeUsCb();
+
+    if(VIHCSR04_SENSOR_DONE == core->state)
+      durationUs = core->echoFallUs - core->echoRiseUs;
+    core->state = VIHCSR04_SENSOR_IDLE;
+  }
+
+  if(durationUs > UINT32_MAX)
+    durationUs = UINT32_MAX;
+
+  VIHCSR04_CoreRecord(bus, core, durationUs);
+
+  return (uint32_t)durationUs;
+}
+
+/**
+ * @brief Sync measurement with per-call conversion, settings and state 
+ *   of async measurement are not touched, result is not reported to 
+ *   call-back, sample buffer, statistics and shared memory
+ * 
+ * @param bus Sensors of bus
+ * @param core Core of sensor
+ * @param conv Precomputed conversion for temperature and max distance
+ * @param durationUs Measured echo duration, 0 if timeout
+ * @return true if measurement is done
+ * @return false if async measurement of sensor is in progress
+ */
+static inline bool VIHCSR04_CoreMeasureSync(VIHCSR04_CoreBus_t* bus, VIHCSR04_Core_t* core, 
+  const VIHCSR04_Conversion_t* conv, uint32_t* durationUs) {
+
+  if(VIHCSR04_SENSOR_IDLE != core->state)
+    return false;
+
+  // full range, a narrowed timeout of async measurement could drop the result
+  *durationUs = VIHCSR04_CorePing(bus, core, conv->maxEchoUs);
+
+  VIHCSR04_CoreMeasured(bus, core, *durationUs, VIHCSR04_ToMm(conv, *durationUs), 
+    VIHCSR04_ToCm(conv, *durationUs));
+
+  return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_CORE_RUN_H
@@ -0,0 +1,227 @@
+/**
+ * @file vihcsr04_coro.hpp
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Coroutine API of HC-SR04 ultrasonic distance sensor control driver (c++ realisation)
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <coroutine>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "vihcsr04.hpp"
+
+namespace vihcsr04 {
+
+  /**
+   * @brief Coroutine of application code started by calling a function returning Task.
+   *   The coroutine runs until the first suspension immediately, 
+   *   its frame is destroyed with the Task object
+   * 
+   */
+  class Task
+  {
+  public:
+    struct promise_type
+    {
+      Task get_return_object() { 
+        return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; 
+      }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept : m_coro(other.m_coro) { other.m_coro = nullptr; }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (m_coro) m_coro.destroy(); }
+
+    /**
+     * @brief Check if coroutine has finished
+     * 
+     * @return true if coroutine has returned
+     */
+    bool Done(void) const { return !m_coro || m_coro.done(); }
+
+  private:
+    explicit Task(std::coroutine_handle<promise_type> coro) : m_coro(coro) {}
+
+    std::coroutine_handle<promise_type> m_coro;
+  };
+
+  /**
+   * @brief Awaitable measurements on top of non-blocking runtime of Hcsr04Sensor.
+   *   Poll calls the sensor runtime and resumes coroutines whose measurements are done, 
+   *   so any number of coroutines wait on one thread without extra threads. 
+   *   Coroutines are never resumed from inside the runtime.
+   *   All calls have to be done from the thread calling Poll. 
+   *   Awaiting coroutines must not be destroyed and awaited sensors must not be deleted
+   *   before their measurements are done. A sensor is either measured by Measure or 
+   *   by one Stream, the other one is rejected while it is in use
+   * 
+   */
+  class Hcsr04Coro
+  {
+  public:
+    /**
+     * @brief Awaitable single measurement, result is distance in mm or INVALID_DISTANCE_MM. 
+     *   Coroutines awaiting the same sensor at the same time share one measurement
+     * 
+     */
+    class MeasureOp
+    {
+    public:
+      MeasureOp(Hcsr04Coro& drv, Handle_t handle, 
+        float temperature, uint16_t maxDistanceCm) : 
+        m_drv(drv), m_handle(handle), 
+        m_temperature(temperature), m_maxDistanceCm(maxDistanceCm) {}
+
+      bool await_ready() const noexcept { return false; }
+      bool await_suspend(std::coroutine_handle<> coro);
+      uint32_t await_resume() const noexcept { return m_distanceMm; }
+
+    private:
+      static void Done(uint32_t distanceMm, const void* context);
+
+      Hcsr04Coro& m_drv;
+      Handle_t m_handle;
+      float m_temperature;
+      uint16_t m_maxDistanceCm;
+      std::coroutine_handle<> m_coro;
+      MeasureOp* m_next{nullptr};            /*!< next coroutine sharing the measurement */
+      uint32_t m_distanceMm{INVALID_DISTANCE_MM};
+    };
+
+    /**
+     * @brief Asynchronous generator of continuous measurement. 
+     *   Measurement is started by construction and stopped by destruction, 
+     *   result of a ping running at destruction is dropped.
+     *   Results which are not taken yet are queued, the oldest is dropped
+     *   if more than MAX_QUEUED results are waiting
+     * 
+     */
+    class Stream
+    {
+    public:
+      static constexpr size_t MAX_QUEUED = 16;
+
+      /**
+       * @brief Awaitable next result of stream
+       * 
+       */
+      class NextOp
+      {
+      public:
+        explicit NextOp(Stream& stream) : m_stream(stream) {}
+
+        bool await_ready() const noexcept { 
+          return !m_stream.m_valid || !m_stream.m_values.empty(); 
+        }
+        void await_suspend(std::coroutine_handle<> coro) noexcept { 
+          m_stream.m_waiter = coro; 
+        }
+        uint32_t await_resume() noexcept;
+
+      private:
+        Stream& m_stream;
+      };
+
+      Stream(Hcsr04Coro& drv, Handle_t handle, 
+        float temperature, uint16_t maxDistanceCm);
+      Stream(const Stream&) = delete;
+      Stream& operator=(const Stream&) = delete;
+      ~Stream();
+
+      /**
+       * @brief Check if continuous measurement is started
+       * 
+       * @return true if stream delivers results
+       */
+      bool IsValid(void) const { return m_valid; }
+
+      /**
+       * @brief Await next result
+       * 
+       * @return NextOp awaitable with distance in mm or INVALID_DISTANCE_MM, 
+       *   INVALID_DISTANCE_MM immediately if stream is not valid
+       */
+      NextOp Next(void) { return NextOp{*this}; }
+
+    private:
+      static void Done(uint32_t distanceMm, const void* context);
+
+      Hcsr04Coro& m_drv;
+      Handle_t m_handle;
+      bool m_valid{false};
+      std::deque<uint32_t> m_values;
+      std::coroutine_handle<> m_waiter;
+    };
+
+    /**
+     * @brief Construct coroutine API over a sensor driver. 
+     *   Edge driven driver is recommended, in blocking mode Poll waits for echoes
+     * 
+     * @param sensor Sensor driver, must outlive this object
+     */
+    explicit Hcsr04Coro(Hcsr04Sensor& sensor) : m_sensor(sensor) {}
+
+    /**
+     * @brief Measure distance once: co_await Measure(handle, 20, 400)
+     * 
+     * @param handle Sensor handle
+     * @param temperature Current environment temperature
+     * @param maxDistanceCm Maximal measured distance
+     * @return MeasureOp awaitable with distance in mm or INVALID_DISTANCE_MM, 
+     *   INVALID_DISTANCE_MM immediately if measurement can not be started 
+     *   or sensor is measured by a Stream
+     */
+    MeasureOp Measure(Handle_t handle, float temperature, uint16_t maxDistanceCm) {
+      return MeasureOp{*this, handle, temperature, maxDistanceCm};
+    }
+
+    /**
+     * @brief Call sensor runtime and resume coroutines with finished measurements, 
+     *   should be placed in main loop
+     * 
+     * @return size_t number of resumed coroutines
+     */
+    size_t Poll(void);
+
+    /**
+     * @brief Get number of sensors with pending single measurements
+     * 
+     * @return size_t number of pending measurements
+     */
+    size_t Pending(void) const { return m_pending.size(); }
+
+  private:
+    Hcsr04Sensor& m_sensor;
+    std::unordered_map<Handle_t, MeasureOp*> m_pending;  /*!< first awaiting operation of every measured sensor */
+    std::unordered_map<Handle_t, Stream*> m_streams;     /*!< stream of every sensor, nullptr after destruction. 
+                                                              Elements never move and are kept, they are the 
+                                                              callback context of running pings */
+    std::vector<std::coroutine_handle<>> m_ready;        /*!< coroutines to resume */
+    std::vector<std::coroutine_handle<>> m_resuming;     /*!< coroutines resumed by current Poll, keeps capacity */
+  };
+}
@@ -0,0 +1,475 @@
+/**
+ * @file vihcsr04_ctx.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Multi-instance (context) api of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_CTX_H
+#define VIHCSR04_CTX_H
+
+#include "vihcsr04.h"
+#include "vihcsr04_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Single-producer/single-consumer queue of samples.
+ *   Only loads and stores are atomic, no read-modify-write, 
+ *   so the queue is lock-free on cores without exclusive access instructions
+ * 
+ */
+typedef struct {
+  VIHCSR04_Sample_t* buffer;    /*!< caller provided storage */
+  uint32_t mask;                /*!< capacity - 1 */
+  VIHCSR04_ATOMIC_U32 head;     /*!< next write position, changed by producer only */
+  VIHCSR04_ATOMIC_U32 tail;     /*!< next read position, changed by consumer only */
+  VIHCSR04_ATOMIC_U32 overflows; /*!< number of dropped samples, changed by producer only */
+} VIHCSR04_SampleRing_t;
+
+/**
+ * @brief Single-producer/single-consumer queue of log records, see VIHCSR04_SampleRing_t
+ * 
+ */
+typedef struct {
+  VIHCSR04_LogRecord_t* buffer; /*!< caller provided storage */
+  uint32_t mask;                /*!< capacity - 1 */
+  VIHCSR04_ATOMIC_U32 head;     /*!< next write position, changed by producer only */
+  VIHCSR04_ATOMIC_U32 tail;     /*!< next read position, changed by consumer only */
+  VIHCSR04_ATOMIC_U32 overflows; /*!< number of dropped records, changed by producer only */
+} VIHCSR04_LogRing_t;
+
+/**
+ * @brief Bounded multi-producer/single-consumer queue of commands. 
+ *   Every cell has a sequence number, producers reserve a cell by 
+ *   compare-and-swap of enqueue position and publish it by its sequence number
+ * 
+ */
+typedef struct {
+  VIHCSR04_Command_t* buffer;   /*!< caller provided storage */
+  uint32_t mask;                /*!< capacity - 1 */
+  VIHCSR04_ATOMIC_U32 enqueuePos; /*!< next reserved position, changed by producers */
+  uint32_t dequeuePos;          /*!< next read position, changed by consumer (runtime) only */
+  VIHCSR04_ATOMIC_U32 overflows; /*!< number of rejected commands, changed by producers */
+} VIHCSR04_CommandRing_t;
+
+/**
+ * @brief Sensor control type, storage of one sensor slot.
+ *   Members are private, use functions of the driver
+ * 
+ */
+typedef struct
+{
+  bool used;                    /*!< slot is used by a created sensor */
+  uint16_t generation;          /*!< slot generation, incremented if sensor is deleted */
+  char name[VIHCSR04_NAME_LEN]; /*!< unique name of sensor */
+  float temperature;            /*!< current environment temperature */
+  uint16_t maxDistanceCm;       /*!< maximal measured distance */
+  VIHCSR04_Core_t core;         /*!< pins, callbacks, schedule and measurement state, shared with c++ realisation */
+} VIHCSR04_Sensor_t;
+
+/**
+ * @brief Driver context: sensors of one bus with callbacks, scheduler and buffers.
+ *   Every context is independent, so contexts can be used from different threads 
+ *   without locking, as long as one context is used by one thread 
+ *   (except sample and log consumer, VIHCSR04_CtxPost... and VIHCSR04_CtxEchoEdge from isr).
+ *   Storage is provided by caller and has to be zero-initialized before 
+ *   the first call, e.g. static or `VIHCSR04_Ctx_t ctx = {0};`.
+ *   Members are private, use functions of the driver
+ * 
+ */
+typedef struct {
+  VIHCSR04_Sensor_t* snsr;                       /*!< caller provided array of sensor slots */
+  uint32_t maxSensors;                           /*!< number of slots in array */
+  VIHCSR04_CoreBus_t bus;                        /*!< callbacks and scheduler shared with c++ realisation, bus.number slots are used */
+  VIHCSR04_SampleRing_t samples;                 /*!< optional buffer of measurement results */
+  VIHCSR04_LogRing_t log;                        /*!< optional buffer of deferred log records */
+  VIHCSR04_CommandRing_t commands;               /*!< optional queue of commands from other threads */
+  VIHCSR04_Recorder_t* recorder;                 /*!< optional recorder of raw measurement stream */
+  VIHCSR04_ShmSegment_t* publisher;              /*!< optional shared memory segment of latest readings */
+} VIHCSR04_Ctx_t;
+
+/**
+ * @brief Initialization of context, see VIHCSR04_Init. 
+ *   Settings made before initialization (printf callback, debug level, 
+ *   sample and log buffers, guard interval) are kept
+ * 
+ * @param ctx Zero-initialized context storage
+ * @param sensors Caller provided array of sensor slots
+ * @param maxSensors Number of slots in array, not more than 0xFFFF
+ * @return false if any argument is invalid
+ */
+bool VIHCSR04_CtxInit(VIHCSR04_Ctx_t* ctx, 
+  VIHCSR04_Sensor_t* sensors, uint32_t maxSensors,
+  VIHCSR04_PulseIn_t pulseInCb,
+  VIHCSR04_TriggerPort_t triggerPortCb
+);
+
+/**
+ * @brief Initialization of context in edge driven mode, see VIHCSR04_InitEdgeDriven 
+ *   and VIHCSR04_CtxInit
+ * 
+ */
+bool VIHCSR04_CtxInitEdgeDriven(VIHCSR04_Ctx_t* ctx, 
+  VIHCSR04_Sensor_t* sensors, uint32_t maxSensors,
+  VIHCSR04_TriggerPort_t triggerPortCb,
+  VIHCSR04_GetTimeUs_t getTimeUsCb
+);
+
+/**
+ * @brief VIHCSR04_EchoEdge for sensors of context
+ * 
+ */
+void VIHCSR04_CtxEchoEdge(VIHCSR04_Ctx_t* ctx, const void* echoPort, uint16_t echoPin, 
+  uint8_t level, uint64_t timeUs);
+
+/**
+ * @brief VIHCSR04_EchoEdgeByHandle for sensors of context
+ * 
+ */
+void VIHCSR04_CtxEchoEdgeByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  uint8_t level, uint64_t timeUs);
+
+/**
+ * @brief VIHCSR04_Create for sensors of context
+ * 
+ */
+VIHCSR04_Handle_t VIHCSR04_CtxCreate(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin);
+
+/**
+ * @brief VIHCSR04_CreateFiltered for sensors of context
+ * 
+ */
+VIHCSR04_Handle_t VIHCSR04_CtxCreateFiltered(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_FilterCfg_t* filterCfg);
+
+/**
+ * @brief VIHCSR04_Delete for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxDelete(VIHCSR04_Ctx_t* ctx, const char* name);
+
+/**
+ * @brief VIHCSR04_DeleteByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxDeleteByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle);
+
+/**
+ * @brief VIHCSR04_GetHandle for sensors of context
+ * 
+ */
+VIHCSR04_Handle_t VIHCSR04_CtxGetHandle(VIHCSR04_Ctx_t* ctx, const char* name);
+
+/**
+ * @brief VIHCSR04_MeasureDistanceAsync for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxMeasureDistanceAsync(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_Distance_t distanceMesuredCb, const void* context);
+
+/**
+ * @brief VIHCSR04_MeasureDistanceAsyncByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxMeasureDistanceAsyncByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_Distance_t distanceMesuredCb, const void* context);
+
+/**
+ * @brief VIHCSR04_MeasureDistanceMmAsyncByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxMeasureDistanceMmAsyncByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context);
+
+/**
+ * @brief VIHCSR04_StopContinuousMeasure for sensors of context
+ * 
+ */
+void VIHCSR04_CtxStopContinuousMeasure(VIHCSR04_Ctx_t* ctx, const char* name);
+
+/**
+ * @brief VIHCSR04_StopContinuousMeasureByHandle for sensors of context
+ * 
+ */
+void VIHCSR04_CtxStopContinuousMeasureByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle);
+
+/**
+ * @brief VIHCSR04_SetFiringGroup for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetFiringGroup(VIHCSR04_Ctx_t* ctx, const char* name, uint16_t group);
+
+/**
+ * @brief VIHCSR04_SetFiringGroupByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetFiringGroupByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, uint16_t group);
+
+/**
+ * @brief VIHCSR04_SetAdaptive for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetAdaptive(VIHCSR04_Ctx_t* ctx, const char* name, bool enable);
+
+/**
+ * @brief VIHCSR04_SetAdaptiveByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetAdaptiveByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, bool enable);
+
+/**
+ * @brief VIHCSR04_SetPeriod for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetPeriod(VIHCSR04_Ctx_t* ctx, const char* name, uint32_t periodUs);
+
+/**
+ * @brief VIHCSR04_SetPeriodByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetPeriodByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, uint32_t periodUs);
+
+/**
+ * @brief VIHCSR04_SetEvents for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetEvents(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const VIHCSR04_EventCfg_t* eventCfg);
+
+/**
+ * @brief VIHCSR04_SetEventsByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetEventsByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  const VIHCSR04_EventCfg_t* eventCfg);
+
+/**
+ * @brief VIHCSR04_GetDeadlineMisses for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxGetDeadlineMisses(VIHCSR04_Ctx_t* ctx, const char* name);
+
+/**
+ * @brief VIHCSR04_GetDeadlineMissesByHandle for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxGetDeadlineMissesByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle);
+
+/**
+ * @brief VIHCSR04_SetGuardInterval for sensors of context
+ * 
+ */
+void VIHCSR04_CtxSetGuardInterval(VIHCSR04_Ctx_t* ctx, uint32_t guardIntervalUs);
+
+/**
+ * @brief VIHCSR04_MeasureDistance for sensors of context
+ * 
+ */
+float VIHCSR04_CtxMeasureDistance(VIHCSR04_Ctx_t* ctx, const char* name,
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief VIHCSR04_MeasureDistanceByHandle for sensors of context
+ * 
+ */
+float VIHCSR04_CtxMeasureDistanceByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle,
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief VIHCSR04_MeasureDistanceMmByHandle for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxMeasureDistanceMmByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle,
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief VIHCSR04_Runtime for sensors of context
+ * 
+ */
+void VIHCSR04_CtxRuntime(VIHCSR04_Ctx_t* ctx);
+
+/**
+ * @brief VIHCSR04_RuntimeUntil for sensors of context
+ * 
+ */
+uint64_t VIHCSR04_CtxRuntimeUntil(VIHCSR04_Ctx_t* ctx, uint32_t budgetUs);
+
+/**
+ * @brief VIHCSR04_SetSampleBuffer for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetSampleBuffer(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sample_t* buffer, uint32_t capacity);
+
+/**
+ * @brief VIHCSR04_DrainSamples for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxDrainSamples(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sample_t* samples, uint32_t maxSamples);
+
+/**
+ * @brief VIHCSR04_GetSampleOverflows for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxGetSampleOverflows(VIHCSR04_Ctx_t* ctx);
+
+/**
+ * @brief VIHCSR04_SetCommandBuffer for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetCommandBuffer(VIHCSR04_Ctx_t* ctx, VIHCSR04_Command_t* buffer, uint32_t capacity);
+
+/**
+ * @brief VIHCSR04_PostCreate for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxPostCreate(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_Created_t createdCb, const void* context);
+
+/**
+ * @brief VIHCSR04_PostDelete for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxPostDelete(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle);
+
+/**
+ * @brief VIHCSR04_PostMeasureMm for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxPostMeasureMm(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context);
+
+/**
+ * @brief VIHCSR04_PostStop for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxPostStop(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle);
+
+/**
+ * @brief VIHCSR04_PostConfigure for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxPostConfigure(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief VIHCSR04_GetCommandOverflows for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxGetCommandOverflows(VIHCSR04_Ctx_t* ctx);
+
+/**
+ * @brief VIHCSR04_SetRecorder for sensors of context
+ * 
+ */
+void VIHCSR04_CtxSetRecorder(VIHCSR04_Ctx_t* ctx, VIHCSR04_Recorder_t* recorder);
+
+/**
+ * @brief VIHCSR04_SetPublisher for sensors of context
+ * 
+ */
+void VIHCSR04_CtxSetPublisher(VIHCSR04_Ctx_t* ctx, VIHCSR04_ShmSegment_t* segment);
+
+/**
+ * @brief VIHCSR04_SetTimeCb for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetTimeCb(VIHCSR04_Ctx_t* ctx, VIHCSR04_GetTimeUs_t getTimeUsCb);
+
+/**
+ * @brief VIHCSR04_SetTriggerMaskCb for sensors of context
+ * 
+ */
+void VIHCSR04_CtxSetTriggerMaskCb(VIHCSR04_Ctx_t* ctx, VIHCSR04_TriggerMask_t triggerMaskCb);
+
+/**
+ * @brief VIHCSR04_GetStats for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxGetStats(VIHCSR04_Ctx_t* ctx, const char* name, VIHCSR04_Stats_t* stats);
+
+/**
+ * @brief VIHCSR04_GetStatsByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxGetStatsByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, VIHCSR04_Stats_t* stats);
+
+/**
+ * @brief VIHCSR04_ResetStats for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxResetStats(VIHCSR04_Ctx_t* ctx, const char* name);
+
+/**
+ * @brief VIHCSR04_ResetStatsByHandle for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxResetStatsByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle);
+
+/**
+ * @brief VIHCSR04_SetPrintfCb for sensors of context
+ * 
+ */
+void VIHCSR04_CtxSetPrintfCb(VIHCSR04_Ctx_t* ctx, const VIHCSR04_Printf_t printfCb);
+
+/**
+ * @brief VIHCSR04_SetLogBuffer for sensors of context
+ * 
+ */
+bool VIHCSR04_CtxSetLogBuffer(VIHCSR04_Ctx_t* ctx, VIHCSR04_LogRecord_t* buffer, uint32_t capacity);
+
+/**
+ * @brief VIHCSR04_DrainLog for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxDrainLog(VIHCSR04_Ctx_t* ctx, VIHCSR04_LogRecord_t* records, uint32_t maxRecords);
+
+/**
+ * @brief VIHCSR04_PrintLog for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxPrintLog(VIHCSR04_Ctx_t* ctx, uint32_t maxRecords);
+
+/**
+ * @brief VIHCSR04_GetLogOverflows for sensors of context
+ * 
+ */
+uint32_t VIHCSR04_CtxGetLogOverflows(VIHCSR04_Ctx_t* ctx);
+
+/**
+ * @brief VIHCSR04_SetDebugLvl for sensors of context
+ * 
+ */
+void VIHCSR04_CtxSetDebugLvl(VIHCSR04_Ctx_t* ctx, const VIHCSR04_DebugLvl_t lvl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_CTX_H
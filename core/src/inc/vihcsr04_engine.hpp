@@ -0,0 +1,315 @@
+/**
+ * @file vihcsr04_engine.hpp
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Multithreaded measurement engine of HC-SR04 ultrasonic distance sensor control driver (c++ realisation)
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "vihcsr04.hpp"
+
+namespace vihcsr04 {
+
+  /**
+   * @brief Measurement engine owning one worker thread per sensor bus.
+   *   A bus is an independent Hcsr04Sensor (own trigger/echo pins, own firing groups),
+   *   its runtime is called only by its worker thread, so buses are measured concurrently.
+   *   Sensors are added, removed and reconfigured by commands executed on the worker 
+   *   between two runtime calls. The worker checks an atomic flag before it takes 
+   *   the bus lock, so the measurement loop is lock-free while no command is pending.
+   *   Results are published by lock-free sample buffer of every bus, 
+   *   distance callbacks are called on the worker thread. Echo edges are queued 
+   *   by a lock-free edge buffer of every bus and applied by the worker before every 
+   *   runtime call, so sensors are touched only by the worker. Worker of a bus without period 
+   *   sleeps until the next action returned by RuntimeUntil, it is woken up earlier 
+   *   by posted commands and by falling echo edges.
+   *   Buses are added and engine is started/stopped by one control thread
+   * 
+   */
+  class Hcsr04Engine
+  {
+  public:
+    typedef uint32_t BusId_t;
+
+    /**
+     * @brief Invalid bus id, returned if bus can not be added
+     * 
+     */
+    static constexpr BusId_t INVALID_BUS = UINT32_MAX;
+
+    Hcsr04Engine() = default;
+    Hcsr04Engine(const Hcsr04Engine&) = delete;
+    Hcsr04Engine& operator=(const Hcsr04Engine&) = delete;
+
+    ~Hcsr04Engine();
+
+    /**
+     * @brief Add a bus measured by blocking pulseIn
+     * 
+     * @param pulseInCb Call-back funktion to count pulse duration
+     * @param triggerPortCb Call-back funktion to trigger a pulse on port
+     * @param sampleCapacity Capacity of sample buffer, has to be a power of 2 (0 - no buffer)
+     * @param period Pause of worker between two runtime calls, 0 - runtime steps follow each other, 
+     *   worker blocks while no sensor is measured
+     * @return BusId_t id of added bus
+     * @return INVALID_BUS if engine is running or capacity is not a power of 2
+     */
+    BusId_t AddBus(PulseIn_t pulseInCb, TriggerPort_t triggerPortCb, 
+      size_t sampleCapacity, std::chrono::microseconds period = {});
+
+    /**
+     * @brief Add a bus measured in edge driven mode, edges are reported by EchoEdge.
+     *   Storage of maxSensors sensors is reserved and never moves, 
+     *   so edges of existing sensors may be reported while sensors are added by commands
+     * 
+     * @param triggerPortCb Call-back funktion to trigger a pulse on port
+     * @param getTimeUsCb Call-back funktion returning current time in microseconds
+     * @param sampleCapacity Capacity of sample buffer, has to be a power of 2 (0 - no buffer)
+     * @param period Pause of worker between two runtime calls, 0 - worker sleeps until the next action
+     * @param maxSensors Number of sensor slots of the bus
+     * @return BusId_t id of added bus
+     * @return INVALID_BUS if engine is running or capacity is not a power of 2
+     */
+    BusId_t AddBus(TriggerPort_t triggerPortCb, GetTimeUs_t getTimeUsCb, 
+      size_t sampleCapacity, std::chrono::microseconds period = {}, 
+      size_t maxSensors = EDGE_DRIVEN_MAX_SENSORS);
+
+    /**
+     * @brief Start one worker thread per bus
+     * 
+     * @return true if engine is started
+     * @return false if engine is already running or has no buses
+     */
+    bool Start(void);
+
+    /**
+     * @brief Stop and join worker threads. Commands left in queues are executed
+     *   by the calling thread, so no future stays unsatisfied. 
+     *   Must not be called concurrently with Execute
+     * 
+     */
+    void Stop(void);
+
+    /**
+     * @brief Check if worker threads are running
+     * 
+     * @return true if engine is running
+     */
+    bool IsRunning(void) const { return m_running; }
+
+    /**
+     * @brief Execute a function with sensor of the bus on its worker thread, 
+     *   between two runtime calls. If engine is not running the function is executed immediately
+     * 
+     * @param bus Bus id
+     * @param func Function called with Hcsr04Sensor& of the bus
+     * @return std::future with result of func, invalid future if bus is not found
+     */
+    template<typename F>
+    auto Execute(BusId_t bus, F&& func) 
+      -> std::future<std::invoke_result_t<F&, Hcsr04Sensor&>> {
+
+      typedef std::invoke_result_t<F&, Hcsr04Sensor&> Result_t;
+
+      if (bus >= m_buses.size())
+        return {};
+
+      auto task = std::make_shared<std::packaged_task<Result_t(Hcsr04Sensor&)>>(
+        std::forward<F>(func));
+      auto result = task->get_future();
+
+      Post(*m_buses[bus], [task](Hcsr04Sensor& sensor) { (*task)(sensor); });
+
+      return result;
+    }
+
+    /**
+     * @brief Register a new sensor on bus, see Hcsr04Sensor::AddSensor
+     * 
+     * @return std::future with handle of created sensor or INVALID_HANDLE
+     */
+    std::future<Handle_t> AddSensor(BusId_t bus, const std::string& name, 
+      const void* triggerPort, uint16_t triggerPin, 
+      const void* echoPort, uint16_t echoPin);
+
+    /**
+     * @brief Delete sensor from bus, see Hcsr04Sensor::DeleteSensor
+     * 
+     * @return std::future with true if sensor is deleted
+     */
+    std::future<bool> DeleteSensor(BusId_t bus, Handle_t handle);
+
+    /**
+     * @brief Start async measurement with distance in mm, see Hcsr04Sensor::MeasureDistanceMmAsync.
+     *   Callback is called on the worker thread of the bus
+     * 
+     * @return std::future with true if measurement is started
+     */
+    std::future<bool> MeasureDistanceMmAsync(BusId_t bus, Handle_t handle, 
+      const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+      const DistanceMm_t distanceMesuredCb = nullptr, const void* context = nullptr);
+
+    /**
+     * @brief Stop continuous measurement, see Hcsr04Sensor::StopContinuousMeasure
+     * 
+     * @return std::future which is ready when measurement is stopped
+     */
+    std::future<void> StopContinuousMeasure(BusId_t bus, Handle_t handle);
+
+    /**
+     * @brief Report an edge of the echo signal of edge driven bus.
+     *   Can be called from interrupt/alert context. The edge is queued and applied 
+     *   by the worker before its next runtime call, edges of one bus have to be 
+     *   reported by one thread. Edges beyond EDGE_CAPACITY pending ones are dropped, 
+     *   sync measurements executed by Execute don't get queued edges
+     * 
+     * @param bus Bus id
+     * @param handle Sensor handle
+     * @param level Signal level after the edge: 1 - rising edge, 0 - falling edge
+     * @param timeUs Time stamp of the edge in microseconds (same time base as getTimeUsCb)
+     */
+    void EchoEdge(BusId_t bus, Handle_t handle, uint8_t level, uint64_t timeUs);
+
+    /**
+     * @brief Take stored samples of bus out of its sample buffer.
+     *   Only one thread may drain a bus, different buses can be drained by different threads
+     * 
+     * @param bus Bus id
+     * @param samples Destination array
+     * @param maxSamples Size of destination array
+     * @return size_t number of copied samples
+     */
+    size_t DrainSamples(BusId_t bus, Sample_t* samples, size_t maxSamples);
+
+    /**
+     * @brief Get number of samples of bus dropped because sample buffer was full
+     * 
+     * @param bus Bus id
+     * @return uint32_t number of dropped samples
+     */
+    uint32_t GetSampleOverflows(BusId_t bus) const;
+
+    /**
+     * @brief Number of echo edges queued per bus until the worker applies them
+     * 
+     */
+    static constexpr size_t EDGE_CAPACITY = 64;
+
+  private:
+    typedef std::function<void(Hcsr04Sensor&)> Command_t;
+
+    /**
+     * @brief Echo edge queued by EchoEdge
+     * 
+     */
+    typedef struct {
+      Handle_t handle;                       /*!< handle of sensor */
+      uint8_t level;                         /*!< signal level after the edge */
+      uint64_t timeUs;                       /*!< time stamp of the edge */
+    } Edge_t;
+
+    /**
+     * @brief Budget of runtime steps between two checks of posted commands
+     * 
+     */
+    static constexpr uint32_t RUNTIME_BUDGET_US = 1000;
+
+    typedef struct Bus_t
+    {
+      template<typename... Args>
+      Bus_t(std::chrono::microseconds period, Args&&... args) : 
+        sensor(std::forward<Args>(args)...), period(period) {}
+
+      Hcsr04Sensor sensor;                   /*!< sensors of the bus, used by worker only while running */
+      std::chrono::microseconds period;      /*!< pause of worker between two runtime calls */
+      std::mutex mutex;                      /*!< protects commands */
+      std::condition_variable_any wakeup;    /*!< wakes up idle worker */
+      std::vector<Command_t> commands;       /*!< posted commands */
+      std::vector<Command_t> executing;      /*!< commands taken by worker, keeps capacity */
+      std::atomic<bool> pending{false};      /*!< commands are posted */
+      SpscRing<Edge_t> edges;                /*!< edges reported by EchoEdge, applied by worker */
+      std::atomic<bool> edge{false};         /*!< falling echo edge was reported */
+      std::jthread worker;                   /*!< worker thread of the bus */
+    } Bus_t;
+
+    /**
+     * @brief Add bus with sample buffer
+     * 
+     * @param bus Created bus
+     * @param sampleCapacity Capacity of sample buffer
+     * @return BusId_t id of added bus or INVALID_BUS
+     */
+    BusId_t AddBus(std::unique_ptr<Bus_t> bus, size_t sampleCapacity);
+
+    /**
+     * @brief Queue command for worker or execute it if engine is not running
+     * 
+     * @param bus Target bus
+     * @param command Command
+     */
+    void Post(Bus_t& bus, Command_t command);
+
+    /**
+     * @brief Execute posted commands
+     * 
+     * @param bus Bus of calling worker
+     */
+    static void ExecuteCommands(Bus_t& bus);
+
+    /**
+     * @brief Apply queued echo edges to sensors of bus
+     * 
+     * @param bus Bus of calling worker
+     */
+    static void ApplyEdges(Bus_t& bus);
+
+    /**
+     * @brief Pause worker without period until the next action of the bus, 
+     *   a posted command, a falling echo edge or stop request
+     * 
+     * @param stop Stop token of the thread
+     * @param bus Bus handled by the worker
+     * @param next Time of the next action returned by RuntimeUntil
+     */
+    static void Idle(std::stop_token stop, Bus_t& bus, uint64_t next);
+
+    /**
+     * @brief Worker thread loop
+     * 
+     * @param stop Stop token of the thread
+     * @param bus Bus handled by the worker
+     */
+    static void Worker(std::stop_token stop, Bus_t& bus);
+
+    std::vector<std::unique_ptr<Bus_t>> m_buses;
+    std::atomic<bool> m_running{false};
+  };
+}
@@ -0,0 +1,175 @@
+/**
+ * @file vihcsr04_event.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Threshold and change based event delivery of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_EVENT_H
+#define VIHCSR04_EVENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** 
+ * @brief Maximal number of zone thresholds of one sensor
+ * */
+#if !defined(VIHCSR04_EVENT_MAX_THRESHOLDS)
+  #define VIHCSR04_EVENT_MAX_THRESHOLDS 4
+#endif
+
+/**
+ * @brief Event configuration. A result is reported if it is the first one, 
+ *   if the zone is changed, if it differs from the last reported one by more than deltaMm 
+ *   or if heartbeatUs has elapsed since the last report. Criteria with 0 are disabled
+ * 
+ */
+typedef struct {
+  uint32_t thresholdMm[VIHCSR04_EVENT_MAX_THRESHOLDS]; /*!< zone borders in ascending order, zone n is between threshold n-1 and n */
+  uint8_t thresholds;           /*!< number of used thresholds */
+  uint32_t hysteresisMm;        /*!< distance has to pass a border by this value to change zone */
+  uint32_t deltaMm;             /*!< min change to the last reported distance, 0 - disabled */
+  uint32_t heartbeatUs;         /*!< max time without report, needs time source, 0 - disabled */
+} VIHCSR04_EventCfg_t;
+
+/**
+ * @brief Event state
+ * 
+ */
+typedef struct {
+  VIHCSR04_EventCfg_t cfg;      /*!< event configuration */
+  bool enabled;                 /*!< event mode is enabled, otherwise every result is reported */
+  bool reported;                /*!< a result has been reported since reset */
+  uint8_t zone;                 /*!< current zone */
+  uint32_t lastMm;              /*!< last reported distance */
+  uint64_t lastUs;              /*!< time of the last report */
+} VIHCSR04_Event_t;
+
+/**
+ * @brief Check event configuration
+ * 
+ * @param cfg Event configuration
+ * @return true if configuration is valid
+ */
+static inline bool VIHCSR04_EventCfgValid(const VIHCSR04_EventCfg_t* cfg) {
+
+  if (VIHCSR04_EVENT_MAX_THRESHOLDS < cfg->thresholds)
+    return false;
+
+  for (uint8_t i = 1; i < cfg->thresholds; i++) {
+    if (cfg->thresholdMm[i] <= cfg->thresholdMm[i - 1])
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Initialize event state
+ * 
+ * @param event Event state
+ * @param cfg Event configuration, NULL to report every result
+ */
+static inline void VIHCSR04_EventInit(VIHCSR04_Event_t* event, 
+  const VIHCSR04_EventCfg_t* cfg) {
+
+  memset(event, 0, sizeof(*event));
+
+  if (NULL != cfg) {
+    event->cfg = *cfg;
+    event->enabled = true;
+  }
+}
+
+/**
+ * @brief Forget reported state, the next result is reported. Configuration is kept
+ * 
+ * @param event Event state
+ */
+static inline void VIHCSR04_EventReset(VIHCSR04_Event_t* event) {
+  event->reported = false;
+}
+
+/**
+ * @brief Zone of distance, the current zone is kept within hysteresis around its borders
+ * 
+ * @param event Event state
+ * @param distanceMm Measured distance, VIHCSR04_INVALID_DISTANCE_MM is beyond all thresholds
+ * @return uint8_t zone 0..thresholds
+ */
+static inline uint8_t VIHCSR04_EventZone(const VIHCSR04_Event_t* event, uint32_t distanceMm) {
+
+  const VIHCSR04_EventCfg_t* cfg = &event->cfg;
+  uint8_t zone = event->reported ? event->zone : 0;
+  uint32_t hysteresisMm = event->reported ? cfg->hysteresisMm : 0;
+
+  while (zone < cfg->thresholds && 
+    (uint64_t)distanceMm >= (uint64_t)cfg->thresholdMm[zone] + hysteresisMm)
+    zone++;
+
+  while (0 < zone && (uint64_t)distanceMm + hysteresisMm < cfg->thresholdMm[zone - 1])
+    zone--;
+
+  return zone;
+}
+
+/**
+ * @brief Decide if result is reported
+ * 
+ * @param event Event state
+ * @param distanceMm Measured (filtered) distance
+ * @param timed Time source is available
+ * @param nowUs Current time
+ * @return true if result has to be reported
+ */
+static inline bool VIHCSR04_EventUpdate(VIHCSR04_Event_t* event, uint32_t distanceMm, 
+  bool timed, uint64_t nowUs) {
+
+  if (!event->enabled)
+    return true;
+
+  uint8_t zone = VIHCSR04_EventZone(event, distanceMm);
+  uint32_t changeMm = (distanceMm > event->lastMm) ? 
+    distanceMm - event->lastMm : event->lastMm - distanceMm;
+
+  bool report = !event->reported || zone != event->zone || 
+    (0 != event->cfg.deltaMm && changeMm > event->cfg.deltaMm) ||
+    (0 != event->cfg.heartbeatUs && timed && nowUs - event->lastUs >= event->cfg.heartbeatUs);
+
+  // zone follows distance also if it is not reported
+  event->zone = zone;
+
+  if (!report)
+    return false;
+
+  event->reported = true;
+  event->lastMm = distanceMm;
+  event->lastUs = nowUs;
+
+  return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_EVENT_H
@@ -0,0 +1,258 @@
+/**
+ * @file vihcsr04_filter.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Streaming distance filters of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_FILTER_H
+#define VIHCSR04_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "vihcsr04_math.h"
+
+/** 
+ * @brief Maximal window of sliding median filter.
+ *   For this window static memory is reserved in every sensor
+ * */
+#if !defined(VIHCSR04_MEDIAN_MAX_WINDOW)
+  #define VIHCSR04_MEDIAN_MAX_WINDOW 9
+#endif
+
+/**
+ * @brief Filter stages, can be combined. 
+ *   Stages are applied in order: median, ema, kalman
+ * 
+ */
+typedef enum {
+  VIHCSR04_FILTER_NONE = 0,
+  VIHCSR04_FILTER_MEDIAN = 1 << 0,   /*!< sliding window median, removes single outliers */
+  VIHCSR04_FILTER_EMA = 1 << 1,      /*!< exponential moving average */
+  VIHCSR04_FILTER_KALMAN = 1 << 2    /*!< constant velocity 1-D kalman filter */
+} VIHCSR04_FilterType_t;
+
+/**
+ * @brief Filter configuration
+ * 
+ */
+typedef struct {
+  uint8_t stages;               /*!< combination of VIHCSR04_FilterType_t */
+  uint8_t medianWindow;         /*!< window of median, 1..VIHCSR04_MEDIAN_MAX_WINDOW */
+  uint8_t emaShift;             /*!< smoothing factor of ema: alpha = 1 / 2^emaShift, 0..15 */
+  float kalmanProcessNoise;     /*!< variance of acceleration, mm^2 per sample^4 */
+  float kalmanMeasurementNoise; /*!< variance of measurement, mm^2 */
+} VIHCSR04_FilterCfg_t;
+
+/**
+ * @brief Filter state, no dynamic memory is used
+ * 
+ */
+typedef struct {
+  VIHCSR04_FilterCfg_t cfg;                           /*!< filter configuration */
+  uint32_t medianHistory[VIHCSR04_MEDIAN_MAX_WINDOW]; /*!< samples in order of arrival */
+  uint32_t medianSorted[VIHCSR04_MEDIAN_MAX_WINDOW];  /*!< the same samples sorted */
+  uint8_t medianCount;                                /*!< number of samples in window */
+  uint8_t medianOldest;                               /*!< position of oldest sample in history */
+  bool emaValid;                                      /*!< ema is initialized */
+  int32_t emaQ8;                                      /*!< ema value, fixed point Q8 */
+  bool kalmanValid;                                   /*!< kalman is initialized */
+  float kalmanPos;                                    /*!< estimated distance, mm */
+  float kalmanVel;                                    /*!< estimated velocity, mm per sample */
+  float kalmanP[2][2];                                /*!< estimation covariance */
+} VIHCSR04_Filter_t;
+
+/**
+ * @brief Check filter configuration
+ * 
+ * @param cfg Filter configuration
+ * @return true if configuration is valid
+ */
+static inline bool VIHCSR04_FilterCfgValid(const VIHCSR04_FilterCfg_t* cfg) {
+
+  if (cfg->stages & ~(VIHCSR04_FILTER_MEDIAN | VIHCSR04_FILTER_EMA | VIHCSR04_FILTER_KALMAN))
+    return false;
+
+  if ((cfg->stages & VIHCSR04_FILTER_MEDIAN) && 
+      (0 == cfg->medianWindow || VIHCSR04_MEDIAN_MAX_WINDOW < cfg->medianWindow))
+    return false;
+
+  if ((cfg->stages & VIHCSR04_FILTER_EMA) && 15 < cfg->emaShift)
+    return false;
+
+  if ((cfg->stages & VIHCSR04_FILTER_KALMAN) && 
+      (0 > cfg->kalmanProcessNoise || 0 >= cfg->kalmanMeasurementNoise))
+    return false;
+
+  return true;
+}
+
+/**
+ * @brief Initialize filter, clears history
+ * 
+ * @param filter Filter state
+ * @param cfg Filter configuration, NULL to disable filtering
+ */
+static inline void VIHCSR04_FilterInit(VIHCSR04_Filter_t* filter, 
+  const VIHCSR04_FilterCfg_t* cfg) {
+
+  memset(filter, 0, sizeof(*filter));
+
+  if (NULL != cfg)
+    filter->cfg = *cfg;
+}
+
+/**
+ * @brief Clear history, configuration is kept
+ * 
+ * @param filter Filter state
+ */
+static inline void VIHCSR04_FilterReset(VIHCSR04_Filter_t* filter) {
+  VIHCSR04_FilterCfg_t cfg = filter->cfg;
+  VIHCSR04_FilterInit(filter, &cfg);
+}
+
+/**
+ * @brief Sliding median: the oldest sample is removed from sorted window 
+ *   and the new one is inserted, without sorting the window again
+ * 
+ */
+static inline uint32_t VIHCSR04_FilterMedian(VIHCSR04_Filter_t* filter, uint32_t distanceMm) {
+
+  uint8_t window = filter->cfg.medianWindow;
+  uint8_t count = filter->medianCount;
+  uint32_t* sorted = filter->medianSorted;
+  uint8_t pos;
+
+  if (count == window) {
+    uint32_t oldest = filter->medianHistory[filter->medianOldest];
+    for (pos = 0; sorted[pos] != oldest; pos++);
+    memmove(&sorted[pos], &sorted[pos + 1], (count - pos - 1) * sizeof(sorted[0]));
+    count--;
+  }
+
+  for (pos = count; 0 < pos && sorted[pos - 1] > distanceMm; pos--) {
+    sorted[pos] = sorted[pos - 1];
+  }
+  sorted[pos] = distanceMm;
+  count++;
+
+  filter->medianHistory[filter->medianOldest] = distanceMm;
+  filter->medianOldest = (filter->medianOldest + 1) % window;
+  filter->medianCount = count;
+
+  return (sorted[(count - 1) / 2] + sorted[count / 2] + 1) / 2;
+}
+
+/**
+ * @brief Exponential moving average in fixed point Q8
+ * 
+ */
+static inline uint32_t VIHCSR04_FilterEma(VIHCSR04_Filter_t* filter, uint32_t distanceMm) {
+
+  int32_t sampleQ8 = (int32_t)(distanceMm << 8);
+
+  if (!filter->emaValid) {
+    filter->emaQ8 = sampleQ8;
+    filter->emaValid = true;
+  } else {
+    // arithmetic shift instead of division, cores without hardware divider are supported
+    filter->emaQ8 += (sampleQ8 - filter->emaQ8) >> filter->cfg.emaShift;
+  }
+
+  return (uint32_t)(filter->emaQ8 + 0x80) >> 8;
+}
+
+/**
+ * @brief Constant velocity kalman filter, one step is one sample
+ * 
+ */
+static inline uint32_t VIHCSR04_FilterKalman(VIHCSR04_Filter_t* filter, uint32_t distanceMm) {
+
+  float z = (float)distanceMm;
+  float q = filter->cfg.kalmanProcessNoise;
+  float r = filter->cfg.kalmanMeasurementNoise;
+  float (*P)[2] = filter->kalmanP;
+
+  if (!filter->kalmanValid) {
+    filter->kalmanPos = z;
+    filter->kalmanVel = 0;
+    P[0][0] = r; P[0][1] = 0;
+    P[1][0] = 0; P[1][1] = r;
+    filter->kalmanValid = true;
+    return distanceMm;
+  }
+
+  // predict: x = F x, P = F P F' + Q, F = [1 1; 0 1], Q = q [1/4 1/2; 1/2 1]
+  filter->kalmanPos += filter->kalmanVel;
+  float p00 = P[0][0] + P[0][1] + P[1][0] + P[1][1] + q / 4;
+  float p01 = P[0][1] + P[1][1] + q / 2;
+  float p10 = P[1][0] + P[1][1] + q / 2;
+  float p11 = P[1][1] + q;
+
+  // update with measured position
+  float s = p00 + r;
+  float k0 = p00 / s;
+  float k1 = p10 / s;
+  float y = z - filter->kalmanPos;
+
+  filter->kalmanPos += k0 * y;
+  filter->kalmanVel += k1 * y;
+
+  P[0][0] = (1 - k0) * p00;
+  P[0][1] = (1 - k0) * p01;
+  P[1][0] = p10 - k1 * p00;
+  P[1][1] = p11 - k1 * p01;
+
+  return (0 < filter->kalmanPos) ? (uint32_t)(filter->kalmanPos + 0.5f) : 0;
+}
+
+/**
+ * @brief Apply configured filter stages to a new sample. 
+ *   Out of range samples are passed through and don't change filter state
+ * 
+ * @param filter Filter state
+ * @param distanceMm Measured distance in mm or VIHCSR04_INVALID_DISTANCE_MM
+ * @return uint32_t filtered distance in mm or VIHCSR04_INVALID_DISTANCE_MM
+ */
+static inline uint32_t VIHCSR04_FilterApply(VIHCSR04_Filter_t* filter, uint32_t distanceMm) {
+
+  if (VIHCSR04_INVALID_DISTANCE_MM == distanceMm)
+    return distanceMm;
+
+  if (filter->cfg.stages & VIHCSR04_FILTER_MEDIAN)
+    distanceMm = VIHCSR04_FilterMedian(filter, distanceMm);
+
+  if (filter->cfg.stages & VIHCSR04_FILTER_EMA)
+    distanceMm = VIHCSR04_FilterEma(filter, distanceMm);
+
+  if (filter->cfg.stages & VIHCSR04_FILTER_KALMAN)
+    distanceMm = VIHCSR04_FilterKalman(filter, distanceMm);
+
+  return distanceMm;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_FILTER_H
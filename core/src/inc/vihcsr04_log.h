@@ -0,0 +1,123 @@
+/**
+ * @file vihcsr04_log.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Deferred binary log of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_LOG_H
+#define VIHCSR04_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "vihcsr04_math.h"
+
+/**
+ * @brief Max length of a line formatted by VIHCSR04_FormatLog, including terminating zero
+ * 
+ */
+#define VIHCSR04_LOG_LINE_LEN 128
+
+/**
+ * @brief Logged events, meaning of record values is given for every event
+ * 
+ */
+typedef enum {
+  VIHCSR04_LOG_CREATED = 0,     /*!< sensor is created: trigger pin, echo pin */
+  VIHCSR04_LOG_TRIGGER,         /*!< measurement is started: echo timeout in us, firing group */
+  VIHCSR04_LOG_RESULT,          /*!< measurement is done: echo duration in us (0 if timeout), distance in mm */
+  VIHCSR04_LOG_ADAPTIVE_MISS,   /*!< no echo within narrowed timeout: timeout in us, - */
+  VIHCSR04_LOG_ADAPTIVE_SKIP,   /*!< stable sensor skips its turn: remaining skipped turns, - */
+  VIHCSR04_LOG_ECHO,            /*!< echo edges: rising edge after trigger in us, echo high in us */
+  VIHCSR04_LOG_DEADLINE_MISS    /*!< measurement started after deadline: lateness in us, period in us */
+} VIHCSR04_LogEvent_t;
+
+/**
+ * @brief Binary log record, written in runtime and formatted later by VIHCSR04_FormatLog
+ * 
+ */
+typedef struct {
+  uint64_t timestampUs;         /*!< time of event, 0 if no time source is set */
+  uint32_t handle;              /*!< handle of sensor */
+  uint32_t value0;              /*!< first raw value, see VIHCSR04_LogEvent_t */
+  uint32_t value1;              /*!< second raw value, see VIHCSR04_LogEvent_t */
+  uint8_t event;                /*!< VIHCSR04_LogEvent_t */
+  uint8_t lvl;                  /*!< debug level of event */
+} VIHCSR04_LogRecord_t;
+
+/**
+ * @brief Format log record as text line
+ * 
+ * @param record Pointer to record
+ * @param name Name of sensor, NULL if unknown
+ * @param line Destination buffer, VIHCSR04_LOG_LINE_LEN is enough for every record
+ * @param len Size of destination buffer
+ * @return int length of formatted line, see snprintf
+ */
+static inline int VIHCSR04_FormatLog(const VIHCSR04_LogRecord_t* record, 
+  const char* name, char* line, size_t len) {
+
+  int n = snprintf(line, len, "%" PRIu64 " us: Sensor \"%s\": ", 
+    record->timestampUs, (NULL != name) ? name : "?");
+
+  if (n < 0 || (size_t)n >= len)
+    return n;
+
+  line += n;
+  len -= n;
+
+  switch (record->event) {
+    case VIHCSR04_LOG_CREATED:
+      return n + snprintf(line, len, "is initialized, trigger pin %" PRIu32 ", echo pin %" PRIu32 "\r\n",
+        record->value0, record->value1);
+    case VIHCSR04_LOG_TRIGGER:
+      return n + snprintf(line, len, "measurement startet, timeout %" PRIu32 " us, group %" PRIu32 "\r\n",
+        record->value0, record->value1);
+    case VIHCSR04_LOG_RESULT:
+      if (VIHCSR04_INVALID_DISTANCE_MM == record->value1)
+        return n + snprintf(line, len, "out of range, echo %" PRIu32 " us\r\n", record->value0);
+      return n + snprintf(line, len, "measured distance %" PRIu32 " mm, echo %" PRIu32 " us\r\n",
+        record->value1, record->value0);
+    case VIHCSR04_LOG_ADAPTIVE_MISS:
+      return n + snprintf(line, len, "no echo within narrowed timeout %" PRIu32 " us\r\n", 
+        record->value0);
+    case VIHCSR04_LOG_ADAPTIVE_SKIP:
+      return n + snprintf(line, len, "turn skipped, %" PRIu32 " turns left\r\n", record->value0);
+    case VIHCSR04_LOG_ECHO:
+      return n + snprintf(line, len, "echo after %" PRIu32 " us, high %" PRIu32 " us\r\n",
+        record->value0, record->value1);
+    case VIHCSR04_LOG_DEADLINE_MISS:
+      return n + snprintf(line, len, "deadline missed by %" PRIu32 " us, period %" PRIu32 " us\r\n",
+        record->value0, record->value1);
+    default:
+      return n + snprintf(line, len, "event %u: %" PRIu32 ", %" PRIu32 "\r\n", 
+        record->event, record->value0, record->value1);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_LOG_H
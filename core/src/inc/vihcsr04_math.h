@@ -0,0 +1,140 @@
+/**
+ * @file vihcsr04_math.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Echo duration to distance conversion of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_MATH_H
+#define VIHCSR04_MATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief Distance in mm returned by integer conversion if echo is out of range
+ * 
+ */
+#define VIHCSR04_INVALID_DISTANCE_MM UINT32_MAX
+
+/**
+ * @brief Precomputed conversion for one temperature and max distance.
+ *   All 64 bit and float arithmetic is done once by VIHCSR04_ConversionInit,
+ *   the conversion of every echo is a single multiplication.
+ *   Integer and float conversion differ by not more than 1 mm
+ *   for echo durations up to 65 ms, so for distances closer than 1 mm 
+ *   to 0 or to maxDistanceCm only one of them may report out of range
+ * 
+ */
+typedef struct {
+  float cmPerUs;                /*!< half of speed of sound in cm/us */
+  uint32_t mmPerUsQ16;          /*!< half of speed of sound in mm/us, fixed point Q16 */
+  uint32_t usPerMmQ8;           /*!< echo duration per mm of distance, fixed point Q8 */
+  uint32_t maxEchoUs;           /*!< echo timeout: max distance with 25% margin in microseconds */
+  uint16_t maxDistanceCm;       /*!< maximal measured distance */
+} VIHCSR04_Conversion_t;
+
+/**
+ * @brief Precompute conversion
+ * 
+ * @param conv Pointer to conversion
+ * @param temperature Current environment temperature
+ * @param maxDistanceCm Maximal measured distance
+ */
+static inline void VIHCSR04_ConversionInit(VIHCSR04_Conversion_t* conv,
+  float temperature, uint16_t maxDistanceCm) {
+
+  //float speedOfSoundInCmPerMicroSec = 0.03313 + 0.0000606 * sensor->temperature; // Cair ≈ (331.3 + 0.606 ⋅ ϑ) m/s
+  uint64_t speadOfSound = 33130000000 + 60600000 * temperature;
+
+  // Compute max delay based on max distance with 25% margin in microseconds
+  //unsigned long maxDistanceDurationMicroSec = 2.5 * sensor->maxDistanceCm / speedOfSoundInCmPerMicroSec;
+  conv->maxEchoUs = (uint32_t)(2500000000000 / speadOfSound * maxDistanceCm);
+
+  //float distanceCm = durationMicroSec / 2.0 * speedOfSoundInCmPerMicroSec;
+  conv->cmPerUs = (float)speadOfSound / 2000000000000;
+
+  // mm/us = speadOfSound / 10^12 * 10 / 2, rounded
+  conv->mmPerUsQ16 = (uint32_t)((speadOfSound * 65536 + 100000000000) / 200000000000);
+  // us/mm = 2 * 10^11 / speadOfSound, rounded
+  conv->usPerMmQ8 = (uint32_t)((51200000000000 + speadOfSound / 2) / speadOfSound);
+
+  conv->maxDistanceCm = maxDistanceCm;
+}
+
+/**
+ * @brief Convert echo duration to distance in cm
+ * 
+ * @param conv Pointer to precomputed conversion
+ * @param durationUs Echo duration in microseconds, 0 if timeout
+ * @return float distance in cm or -1 if out of range
+ */
+static inline float VIHCSR04_ToCm(const VIHCSR04_Conversion_t* conv, uint32_t durationUs) {
+
+  float distanceCm = conv->cmPerUs * durationUs;
+
+  if (distanceCm == 0 || distanceCm > conv->maxDistanceCm) {
+      distanceCm = -1.0 ;
+  }
+
+  return distanceCm;
+}
+
+/**
+ * @brief Convert echo duration to distance in mm using only 32 bit integer arithmetic
+ * 
+ * @param conv Pointer to precomputed conversion
+ * @param durationUs Echo duration in microseconds, 0 if timeout
+ * @return uint32_t distance in mm or VIHCSR04_INVALID_DISTANCE_MM if out of range
+ */
+static inline uint32_t VIHCSR04_ToMm(const VIHCSR04_Conversion_t* conv, uint32_t durationUs) {
+
+  if (0 == durationUs || durationUs > conv->maxEchoUs)
+    return VIHCSR04_INVALID_DISTANCE_MM;
+
+  // (durationUs * mmPerUsQ16) >> 16 splitted to avoid 64 bit multiplication
+  uint32_t distanceMm = (durationUs >> 16) * conv->mmPerUsQ16 +
+    (((durationUs & 0xFFFF) * conv->mmPerUsQ16 + 0x8000) >> 16);
+
+  if (0 == distanceMm || distanceMm > (uint32_t)conv->maxDistanceCm * 10)
+    return VIHCSR04_INVALID_DISTANCE_MM;
+
+  return distanceMm;
+}
+
+/**
+ * @brief Convert distance in mm to cm
+ * 
+ * @param distanceMm Distance in mm or VIHCSR04_INVALID_DISTANCE_MM
+ * @return float distance in cm or -1 if out of range
+ */
+static inline float VIHCSR04_MmToCm(uint32_t distanceMm) {
+
+  if (VIHCSR04_INVALID_DISTANCE_MM == distanceMm)
+    return -1.0;
+
+  return distanceMm / 10.0f;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_MATH_H
@@ -22,30 +22,16 @@
 #ifndef VIHCSR04_PRIVATE_H
 #define VIHCSR04_PRIVATE_H
 
-#include "vihcsr04.h"
-
-/**
- * @brief Sensor control type
- * 
- */
-typedef struct
-{
-  char name[VIHCSR04_NAME_LEN]; /*!< unique name of sensor */
-  const void* triggerPort;      /*!< pointer to the physical port, to witch the trigger pin of sensor is connected*/
-  uint16_t triggerPin;          /*!< pin number, to witch the the trigger pin of sensor is connected*/
-  const void* echoPort;         /*!< pointer to the physical port, to witch the echo pin of sensor is connected*/
-  uint16_t echoPin;             /*!< pin number, to witch the echo pin of sensor is connected*/
-  bool enabled;                 /*!< flag to enabled/disable if messurement */
-  VIHCSR04_MeasureMode_t mode;  /*!< messurement mode */
-  float temperature;            /*!< current environment temperature */
-  uint16_t maxDistanceCm;       /*!< maximal measured distance */
-  const void* userContext;      /*!< user context that is returned by calling distCb */
-  VIHCSR04_Distance_t distCb;   /*!< call-back funktion will be called if meassurement is done */
-} Sensor_t;
+#include "vihcsr04_ctx.h"
+#include "vihcsr04_math.h"
+#include "vihcsr04_rec.h"
+#include "vihcsr04_shm.h"
+#include <stdatomic.h>
 
 /**
  * @brief Initialize a semsor handler
  * 
+ * @param ctx Driver context
  * @param button Pointer to a sensor control structur
  * @param name Unique name of a new sensor
  * @param triggerPort Pointer to a GPIO structur to witch the trigger pin of sensor is connected
@@ -55,23 +41,188 @@ typedef struct
  * @return true if initialization is successful
  * @return false if initialization is failed
  */
-static bool Init(Sensor_t* sensor, const char* name, 
+static bool Init(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sensor_t* sensor, const char* name, 
   const void* triggerPort, uint16_t triggerPin, 
   const void* echoPort, uint16_t echoPin);
 
 /**
  * @brief Find sensor by name in array of initialized sensors
  * 
+ * @param ctx Driver context
  * @param name Sensor name to search
  * @return int32_t index of found sensor, if no button found returns -1
  */
-static int32_t FindSensorByName(const char* name);
+static int32_t FindSensorByName(VIHCSR04_Ctx_t* ctx, const char* name);
 
 /**
- * @brief Button runtime
+ * @brief Find sensor by echo pin in array of initialized sensors
  * 
- * @param button Pointer to a sensor control structur
+ * @param ctx Driver context
+ * @param echoPort Pointer to a GPIO structur of echo pin
+ * @param echoPin Echo pin number
+ * @return int32_t index of found sensor, if no sensor found returns -1
+ */
+static int32_t FindSensorByEcho(VIHCSR04_Ctx_t* ctx, const void* echoPort, uint16_t echoPin);
+
+/**
+ * @brief Make handle of sensor in slot
+ * 
+ * @param ctx Driver context
+ * @param index Slot index
+ * @return VIHCSR04_Handle_t handle of sensor
+ */
+static VIHCSR04_Handle_t MakeHandle(VIHCSR04_Ctx_t* ctx, uint32_t index);
+
+/**
+ * @brief Get sensor by handle
+ * 
+ * @param ctx Driver context
+ * @param handle Sensor handle
+ * @return VIHCSR04_Sensor_t* pointer to sensor, NULL if handle is invalid or stale
+ */
+static VIHCSR04_Sensor_t* GetSensor(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle);
+
+/**
+ * @brief Store sample in sample buffer (producer side)
+ * 
+ * @param ctx Driver context
+ * @param sample Sample to store
+ */
+static void PushSample(VIHCSR04_Ctx_t* ctx, const VIHCSR04_Sample_t* sample);
+
+/**
+ * @brief Attach sensor slots and hooks of context to its bus
+ * 
+ * @param ctx Driver context
+ */
+static void AttachBus(VIHCSR04_Ctx_t* ctx);
+
+#if VIHCSR04_DEBUG
+/**
+ * @brief Store log record in log buffer (producer side), hook of bus
+ * 
+ * @param bus Bus of context
+ * @param lvl Debug level of event
+ * @param event Logged event
+ * @param index Slot index of sensor
+ * @param value0 First raw value, see VIHCSR04_LogEvent_t
+ * @param value1 Second raw value, see VIHCSR04_LogEvent_t
+ * @return true if log buffer is set, even if record is dropped
+ * @return false if event has to be printed
+ */
+static bool Log(VIHCSR04_CoreBus_t* bus, VIHCSR04_DebugLvl_t lvl, VIHCSR04_LogEvent_t event, 
+  uint32_t index, uint32_t value0, uint32_t value1);
+#endif
+
+/**
+ * @brief Name of sensor in slot, hook of bus
+ * 
+ * @param bus Bus of context
+ * @param index Slot index of sensor
+ * @return const char* name of sensor
+ */
+static const char* Name(VIHCSR04_CoreBus_t* bus, uint32_t index);
+
+/**
+ * @brief Store result in shared memory and sample buffer, hook of bus
+ * 
+ * @param bus Bus of context
+ * @param index Slot index of sensor
+ * @param durationUs Echo duration, 0 if timeout
+ * @param distanceMm Distance in mm or VIHCSR04_INVALID_DISTANCE_MM
+ * @param nowUs Time of completion
+ */
+static void Publish(VIHCSR04_CoreBus_t* bus, uint32_t index, 
+  uint32_t durationUs, uint32_t distanceMm, uint64_t nowUs);
+
+/**
+ * @brief Store raw echo duration of a ping in recorder, hook of bus
+ * 
+ * @param bus Bus of context
+ * @param index Slot index of sensor
+ * @param durationUs Echo duration, 0 if timeout
+ */
+static void RecordSample(VIHCSR04_CoreBus_t* bus, uint32_t index, uint32_t durationUs);
+
+// hooks of core runtime, resolved at compile time
+#define VIHCSR04_CORE_STRIDE sizeof(VIHCSR04_Sensor_t)
+#define VIHCSR04_CORE_LOG(bus, lvl, event, index, value0, value1) \
+  Log(bus, lvl, event, index, value0, value1)
+#define VIHCSR04_CORE_NAME(bus, index) Name(bus, index)
+#define VIHCSR04_CORE_PUBLISH(bus, index, durationUs, distanceMm, nowUs) \
+  Publish(bus, index, durationUs, distanceMm, nowUs)
+#define VIHCSR04_CORE_RECORD(bus, index, durationUs) RecordSample(bus, index, durationUs)
+
+#include "vihcsr04_core_run.h"
+
+/**
+ * @brief Store record in recorder, if recorder is set
+ * 
+ * @param ctx Driver context
+ * @param type Type of record
+ * @param sensor Pointer to a sensor control structur
+ * @param value Value, see VIHCSR04_RecType_t
+ */
+static void Record(VIHCSR04_Ctx_t* ctx, VIHCSR04_RecType_t type, 
+  const VIHCSR04_Sensor_t* sensor, uint32_t value);
+
+/**
+ * @brief Store temperature and range of sensor in recorder, if recorder is set
+ * 
+ * @param ctx Driver context
+ * @param sensor Pointer to a sensor control structur
+ * @param temperature Recorded environment temperature
+ * @param maxDistanceCm Recorded maximal distance
+ */
+static void RecordConfig(VIHCSR04_Ctx_t* ctx, const VIHCSR04_Sensor_t* sensor, 
+  float temperature, uint16_t maxDistanceCm);
+
+/**
+ * @brief Reserve cell in command queue (producer side)
+ * 
+ * @param ctx Driver context
+ * @return VIHCSR04_Command_t* reserved cell, NULL if queue is not set or full
+ */
+static VIHCSR04_Command_t* ReserveCommand(VIHCSR04_Ctx_t* ctx);
+
+/**
+ * @brief Make filled cell visible to the runtime (producer side)
+ * 
+ * @param command Reserved cell
+ */
+static void PublishCommand(VIHCSR04_Command_t* command);
+
+/**
+ * @brief Execute posted commands (consumer side)
+ * 
+ * @param ctx Driver context
+ */
+static void ExecuteCommands(VIHCSR04_Ctx_t* ctx);
+
+/**
+ * @brief Sync measurement by VIHCSR04_CoreMeasureSync, 
+ *   recorder gets settings of this call for its sample
+ * 
+ * @param ctx Driver context
+ * @param sensor Pointer to a sensor control structur
+ * @param temperature Current environment temperature
+ * @param conv Precomputed conversion for temperature and max distance
+ * @param durationMicroSec Measured echo duration, 0 if timeout
+ * @return true if measurement is done
+ * @return false if sensor is not found or busy
+ */
+static bool MeasureSync(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sensor_t* sensor, float temperature,
+  const VIHCSR04_Conversion_t* conv, uint32_t* durationMicroSec);
+
+/**
+ * @brief Get time of the next action required from runtime, 
+ *   posted commands are ready work
+ * 
+ * @param ctx Driver context
+ * @param nowUs Current time
+ * @return uint64_t time of next action, nowUs if work is ready, 
+ *   VIHCSR04_NO_DEADLINE if no sensor is measured
  */
-static float Runtime(Sensor_t* sensor);
+static uint64_t NextAction(VIHCSR04_Ctx_t* ctx, uint64_t nowUs);
 
 #endif // VIHCSR04_PRIVATE_H
@@ -0,0 +1,224 @@
+/**
+ * @file vihcsr04_rec.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Record/replay of measurement streams of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_REC_H
+#define VIHCSR04_REC_H
+
+#include "vihcsr04.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Recording format: VIHCSR04_RecHeader_t followed by VIHCSR04_RecRecord_t records, 
+ * both 16 bytes in native byte order. The file is append-only, a truncated file 
+ * is valid up to its last complete record, record n is at offset 16 * (n + 1), 
+ * so the file can be memory-mapped and indexed without parsing.
+ */
+
+/** 
+ * @brief Magic number of recording ("VHRC" in little endian)
+ * */
+#define VIHCSR04_REC_MAGIC 0x43524856u
+
+/** 
+ * @brief Version of recording format
+ * */
+#define VIHCSR04_REC_VERSION 1
+
+/** 
+ * @brief Max number of replayed sensors
+ * */
+#if !defined(VIHCSR04_REPLAY_MAX_SENSORS)
+  #define VIHCSR04_REPLAY_MAX_SENSORS 64
+#endif
+
+/**
+ * @brief Type of record
+ * 
+ */
+typedef enum {
+  VIHCSR04_REC_SENSOR = 1,      /*!< sensor is created, value: trigger pin << 16 | echo pin */
+  VIHCSR04_REC_TEMPERATURE,     /*!< temperature of measurement, value: bits of float */
+  VIHCSR04_REC_RANGE,           /*!< max distance of measurement, value: distance in cm */
+  VIHCSR04_REC_SAMPLE           /*!< raw echo duration returned by pulse measurement, value: duration in us, 0 - timeout */
+} VIHCSR04_RecType_t;
+
+/**
+ * @brief Header of recording
+ * 
+ */
+typedef struct {
+  uint32_t magic;               /*!< VIHCSR04_REC_MAGIC */
+  uint16_t version;             /*!< VIHCSR04_REC_VERSION */
+  uint16_t recordSize;          /*!< size of VIHCSR04_RecRecord_t */
+  uint32_t reserved[2];         /*!< 0 */
+} VIHCSR04_RecHeader_t;
+
+/**
+ * @brief Record of recording
+ * 
+ */
+typedef struct {
+  uint64_t timestampUs;         /*!< time of event, 0 if driver has no time source */
+  uint32_t value;               /*!< value, see VIHCSR04_RecType_t */
+  uint16_t sensor;              /*!< slot index of sensor (lower 16 bits of handle) */
+  uint8_t type;                 /*!< VIHCSR04_RecType_t */
+  uint8_t reserved;             /*!< 0 */
+} VIHCSR04_RecRecord_t;
+
+/**
+ * @brief Write call-back of recorder, e.g. fwrite to an opened file
+ * 
+ * @param data Written bytes
+ * @param size Number of bytes
+ * @param context User context
+ * @return size_t number of written bytes, all bytes or 0 on error
+ */
+typedef size_t (*VIHCSR04_RecWrite_t) (const void* data, size_t size, const void* context);
+
+/**
+ * @brief Recorder: bounded single-producer/single-consumer queue of records 
+ *   filled by the driver runtime and written by VIHCSR04_RecFlush. 
+ *   Members are private
+ * 
+ */
+struct VIHCSR04_Recorder {
+  VIHCSR04_RecRecord_t* buffer; /*!< caller provided storage */
+  uint32_t mask;                /*!< capacity - 1 */
+  VIHCSR04_ATOMIC_U32 head;     /*!< next write position, changed by producer only */
+  VIHCSR04_ATOMIC_U32 tail;     /*!< next read position, changed by consumer only */
+  VIHCSR04_ATOMIC_U32 overflows; /*!< number of dropped records, changed by producer only */
+  VIHCSR04_RecWrite_t writeCb;  /*!< write call-back */
+  const void* context;          /*!< user context of write call-back */
+  bool headerWritten;           /*!< header is written */
+};
+
+/**
+ * @brief Initialize recorder, it is attached to the driver by VIHCSR04_SetRecorder
+ * 
+ * @param recorder Recorder storage
+ * @param buffer Caller provided storage, bounds the memory used between flushes
+ * @param capacity Number of records in buffer, has to be a power of 2
+ * @param writeCb Write call-back
+ * @param context User context of write call-back
+ * @return true if recorder is initialized
+ * @return false if capacity is not a power of 2 or an argument is NULL
+ */
+bool VIHCSR04_RecInit(VIHCSR04_Recorder_t* recorder, 
+  VIHCSR04_RecRecord_t* buffer, uint32_t capacity, 
+  VIHCSR04_RecWrite_t writeCb, const void* context);
+
+/**
+ * @brief Store record (producer side), called by the driver runtime. 
+ *   Record is dropped and counted if buffer is full
+ * 
+ * @param recorder Recorder
+ * @param type Type of record
+ * @param sensor Slot index of sensor
+ * @param timestampUs Time of event
+ * @param value Value, see VIHCSR04_RecType_t
+ */
+void VIHCSR04_RecPut(VIHCSR04_Recorder_t* recorder, VIHCSR04_RecType_t type, 
+  uint16_t sensor, uint64_t timestampUs, uint32_t value);
+
+/**
+ * @brief Write stored records by write call-back (consumer side), 
+ *   the header is written by the first flush. Can be called from another thread 
+ *   than the runtime. On write error the records stay in buffer
+ * 
+ * @param recorder Recorder
+ * @return uint32_t number of written records
+ */
+uint32_t VIHCSR04_RecFlush(VIHCSR04_Recorder_t* recorder);
+
+/**
+ * @brief Get number of records dropped because buffer was full
+ * 
+ * @param recorder Recorder
+ * @return uint32_t number of dropped records
+ */
+uint32_t VIHCSR04_RecGetOverflows(VIHCSR04_Recorder_t* recorder);
+
+/**
+ * @brief Open recording for replay (library vihcsr04replay), e.g. memory-mapped file. 
+ *   Sensors of replay are matched to recorded sensors by echo pin, 
+ *   every sensor replays its own samples in recorded order
+ * 
+ * @param data Recording, has to stay valid while replaying
+ * @param size Size of recording in bytes
+ * @return true if header is valid
+ */
+bool VIHCSR04_ReplayOpen(const void* data, size_t size);
+
+/**
+ * @brief Get configuration of recorded sensor: the first one before replay, 
+ *   the one of the last replayed sample while replaying
+ * 
+ * @param echoPin Echo pin of sensor
+ * @param temperature Recorded temperature
+ * @param maxDistanceCm Recorded max distance
+ * @return true if sensor and its configuration are recorded
+ */
+bool VIHCSR04_ReplayGetConfig(uint16_t echoPin, float* temperature, uint16_t* maxDistanceCm);
+
+/**
+ * @brief Check if all recorded samples are replayed
+ * 
+ * @return true if no sample is left
+ */
+bool VIHCSR04_ReplayDone(void);
+
+/**
+ * @brief Clock of replay, can be used as VIHCSR04_GetTimeUs_t. 
+ *   Time stamp of the last replayed sample, so replay runs as fast as possible
+ * 
+ * @return uint64_t recorded time in microseconds
+ */
+uint64_t VIHCSR04_ReplayGetTimeUs(void);
+
+/**
+ * @brief Replayed pulse measurement, can be used as VIHCSR04_PulseIn_t. 
+ *   Returns the next recorded duration of sensor with echo pin
+ * 
+ * @param gpio Pointer to a GPIO structur of echo pin, ignored
+ * @param port Echo pin number
+ * @param state Measured level
+ * @param maxDurationTreshold Timeout, ignored
+ * @param context User context
+ * @return uint64_t recorded echo duration in microseconds, 0 if timeout or no sample is left
+ */
+uint64_t VIHCSR04_ReplayPulseIn(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t maxDurationTreshold, const void* context);
+
+/**
+ * @brief Replayed trigger, can be used as VIHCSR04_TriggerPort_t, does nothing
+ * 
+ */
+void VIHCSR04_ReplayTrigger(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t pulseDuration, const void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_REC_H
@@ -0,0 +1,127 @@
+/**
+ * @file vihcsr04_ring.hpp
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Lock-free single-producer/single-consumer queue of HC-SR04 driver (c++ realisation)
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+namespace vihcsr04 {
+
+  /**
+   * @brief Lock-free single-producer/single-consumer queue.
+   *   One context calls Push, another one Pop/Drain, no locks are used.
+   *   Storage is allocated only by Resize, which must not be called 
+   *   while producer or consumer are running
+   * 
+   * @tparam T Element type
+   */
+  template<typename T>
+  class SpscRing
+  {
+  public:
+    /**
+     * @brief Allocate storage and clear queue
+     * 
+     * @param capacity Number of elements, has to be a power of 2 (0 releases storage)
+     * @return true if storage is allocated
+     * @return false if capacity is not a power of 2
+     */
+    bool Resize(size_t capacity) {
+      if (0 != (capacity & (capacity - 1)))
+        return false;
+
+      m_buffer.assign(capacity, T{});
+      m_mask = capacity ? capacity - 1 : 0;
+      m_head.store(0, std::memory_order_relaxed);
+      m_tail.store(0, std::memory_order_relaxed);
+      m_overflows.store(0, std::memory_order_relaxed);
+      return true;
+    }
+
+    /**
+     * @brief Check if storage is allocated
+     */
+    bool Enabled() const {
+      return !m_buffer.empty();
+    }
+
+    /**
+     * @brief Store element (producer side)
+     * 
+     * @return true if stored
+     * @return false if queue is full, overflow counter is incremented
+     */
+    bool Push(const T& item) {
+      size_t head = m_head.load(std::memory_order_relaxed);
+      size_t tail = m_tail.load(std::memory_order_acquire);
+
+      if (m_buffer.empty() || head - tail > m_mask) {
+        // only producer changes overflows, load and store is enough
+        m_overflows.store(m_overflows.load(std::memory_order_relaxed) + 1, 
+          std::memory_order_relaxed);
+        return false;
+      }
+
+      m_buffer[head & m_mask] = item;
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * @brief Take up to maxItems elements (consumer side)
+     * 
+     * @return size_t number of copied elements
+     */
+    size_t Drain(T* items, size_t maxItems) {
+      size_t tail = m_tail.load(std::memory_order_relaxed);
+      size_t head = m_head.load(std::memory_order_acquire);
+      size_t count = head - tail;
+
+      if (count > maxItems)
+        count = maxItems;
+
+      for (size_t i = 0; i < count; i++) {
+        items[i] = m_buffer[(tail + i) & m_mask];
+      }
+
+      m_tail.store(tail + count, std::memory_order_release);
+      return count;
+    }
+
+    /**
+     * @brief Number of elements dropped because queue was full
+     */
+    uint32_t Overflows() const {
+      return m_overflows.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::vector<T> m_buffer{};
+    size_t m_mask{};
+    alignas(64) std::atomic<size_t> m_head{};
+    alignas(64) std::atomic<size_t> m_tail{};
+    std::atomic<uint32_t> m_overflows{};
+  };
+}
@@ -0,0 +1,133 @@
+/**
+ * @file vihcsr04_sched.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Per sensor rate scheduling of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_SCHED_H
+#define VIHCSR04_SCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** 
+ * @brief Time of next action if no action is pending
+ * */
+#define VIHCSR04_NO_DEADLINE UINT64_MAX
+
+/**
+ * @brief Rate of one sensor for earliest deadline first scheduling.
+ *   A sensor with period is released once per period, 
+ *   its deadline is the end of the period. A measurement started 
+ *   after the deadline is a deadline miss, the next period starts at the late measurement.
+ *   Sensors without period are measured as often as possible 
+ *   when no sensor with period is released
+ * 
+ */
+typedef struct {
+  uint32_t periodUs;            /*!< target period of measurements, 0 - as often as possible */
+  uint64_t releaseUs;           /*!< start of current period */
+  uint32_t deadlineMisses;      /*!< number of measurements started after deadline */
+} VIHCSR04_Sched_t;
+
+/**
+ * @brief Initialize rate, the first period starts immediately
+ * 
+ * @param sched Rate of sensor
+ * @param periodUs Target period of measurements, 0 - as often as possible
+ * @param nowUs Current time
+ */
+static inline void VIHCSR04_SchedInit(VIHCSR04_Sched_t* sched, uint32_t periodUs, uint64_t nowUs) {
+  sched->periodUs = periodUs;
+  sched->releaseUs = nowUs;
+  sched->deadlineMisses = 0;
+}
+
+/**
+ * @brief Check if measurement of sensor with period is released
+ * 
+ * @param sched Rate of sensor
+ * @param nowUs Current time
+ * @return true if current period has started
+ */
+static inline bool VIHCSR04_SchedDue(const VIHCSR04_Sched_t* sched, uint64_t nowUs) {
+  return (int64_t)(nowUs - sched->releaseUs) >= 0;
+}
+
+/**
+ * @brief Get deadline of current period
+ * 
+ * @param sched Rate of sensor
+ * @return uint64_t end of current period
+ */
+static inline uint64_t VIHCSR04_SchedDeadline(const VIHCSR04_Sched_t* sched) {
+  return sched->releaseUs + sched->periodUs;
+}
+
+/**
+ * @brief Account start of measurement and move to the next period
+ * 
+ * @param sched Rate of sensor
+ * @param nowUs Current time
+ * @return uint32_t lateness in microseconds, 0 if deadline is met
+ */
+static inline uint32_t VIHCSR04_SchedStart(VIHCSR04_Sched_t* sched, uint64_t nowUs) {
+
+  if (0 == sched->periodUs)
+    return 0;
+
+  uint64_t deadline = VIHCSR04_SchedDeadline(sched);
+
+  if ((int64_t)(nowUs - deadline) <= 0) {
+    // keep phase, measurement rate doesn't drift
+    sched->releaseUs = deadline;
+    return 0;
+  }
+
+  // late periods are not caught up by a burst of measurements
+  sched->deadlineMisses++;
+  sched->releaseUs = nowUs + sched->periodUs;
+  return (nowUs - deadline > UINT32_MAX) ? UINT32_MAX : (uint32_t)(nowUs - deadline);
+}
+
+/**
+ * @brief Get earlier of two action times
+ * 
+ * @param aUs Time of action or VIHCSR04_NO_DEADLINE
+ * @param bUs Time of action or VIHCSR04_NO_DEADLINE
+ * @return uint64_t earlier time, VIHCSR04_NO_DEADLINE if both are not pending
+ */
+static inline uint64_t VIHCSR04_SchedEarliest(uint64_t aUs, uint64_t bUs) {
+
+  if (VIHCSR04_NO_DEADLINE == aUs)
+    return bUs;
+  if (VIHCSR04_NO_DEADLINE == bUs)
+    return aUs;
+
+  return ((int64_t)(bUs - aUs) < 0) ? bUs : aUs;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_SCHED_H
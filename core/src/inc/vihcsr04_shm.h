@@ -0,0 +1,372 @@
+/**
+ * @file vihcsr04_shm.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Shared memory publication of latest readings of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_SHM_H
+#define VIHCSR04_SHM_H
+
+#include <string.h>
+#include "vihcsr04.h"
+
+#ifdef __cplusplus
+  #include <atomic>
+  #define VIHCSR04_SHM_STORE(word, value, order) \
+    (word).store(value, std::memory_order_##order)
+  #define VIHCSR04_SHM_LOAD(word, order) \
+    (word).load(std::memory_order_##order)
+  #define VIHCSR04_SHM_FENCE(order) std::atomic_thread_fence(std::memory_order_##order)
+#else
+  #include <stdatomic.h>
+  #define VIHCSR04_SHM_STORE(word, value, order) \
+    atomic_store_explicit(&(word), value, memory_order_##order)
+  #define VIHCSR04_SHM_LOAD(word, order) \
+    atomic_load_explicit((VIHCSR04_ATOMIC_U32*)&(word), memory_order_##order)
+  #define VIHCSR04_SHM_FENCE(order) atomic_thread_fence(memory_order_##order)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Segment layout: VIHCSR04_ShmHeader_t followed by one VIHCSR04_ShmSlot_t per sensor slot, 
+ * both 64 bytes in native byte order. Slot n belongs to the sensor with handle index n. 
+ * Every slot is a seqlock: the only writer (runtime) makes the sequence odd, 
+ * updates the words and makes it even again, readers in any process retry 
+ * if the sequence was odd or has changed while reading. Readers never block the writer.
+ */
+
+/** 
+ * @brief Magic number of segment ("VHSM" in little endian)
+ * */
+#define VIHCSR04_SHM_MAGIC 0x4D534856
+
+/** 
+ * @brief Version of segment layout
+ * */
+#define VIHCSR04_SHM_VERSION 1
+
+/** 
+ * @brief Max length of sensor name in segment
+ * */
+#define VIHCSR04_SHM_NAME_LEN 15
+
+/** 
+ * @brief Number of attempts of reader to get a consistent slot
+ * */
+#if !defined(VIHCSR04_SHM_READ_RETRIES)
+  #define VIHCSR04_SHM_READ_RETRIES 16
+#endif
+
+/**
+ * @brief Status of latest reading
+ * 
+ */
+typedef enum {
+  VIHCSR04_SHM_NONE = 0,        /*!< no sensor or no result yet */
+  VIHCSR04_SHM_VALID,           /*!< distance is valid */
+  VIHCSR04_SHM_TIMEOUT,         /*!< no echo */
+  VIHCSR04_SHM_OUT_OF_RANGE     /*!< echo beyond max distance */
+} VIHCSR04_ShmStatus_t;
+
+/**
+ * @brief Segment header
+ * 
+ */
+typedef struct {
+  uint32_t magic;               /*!< VIHCSR04_SHM_MAGIC */
+  uint32_t version;             /*!< VIHCSR04_SHM_VERSION */
+  uint32_t sensors;             /*!< number of slots */
+  uint32_t slotSize;            /*!< size of slot, sizeof(VIHCSR04_ShmSlot_t) */
+  uint32_t reserved[12];        /*!< slots start at cache line */
+} VIHCSR04_ShmHeader_t;
+
+/**
+ * @brief Latest reading of one sensor, one cache line
+ * 
+ */
+typedef struct {
+  VIHCSR04_ATOMIC_U32 sequence;       /*!< odd while writer updates slot */
+  VIHCSR04_ATOMIC_U32 handle;         /*!< sensor handle, VIHCSR04_INVALID_HANDLE if slot is free */
+  VIHCSR04_ATOMIC_U32 status;         /*!< VIHCSR04_ShmStatus_t */
+  VIHCSR04_ATOMIC_U32 distanceMm;     /*!< distance in mm or VIHCSR04_INVALID_DISTANCE_MM */
+  VIHCSR04_ATOMIC_U32 durationUs;     /*!< echo duration, 0 if timeout */
+  VIHCSR04_ATOMIC_U32 results;        /*!< number of results since creation */
+  VIHCSR04_ATOMIC_U32 timestampUs[2]; /*!< low and high word of result time */
+  VIHCSR04_ATOMIC_U32 name[4];        /*!< zero terminated sensor name */
+  VIHCSR04_ATOMIC_U32 reserved[4];
+} VIHCSR04_ShmSlot_t;
+
+/**
+ * @brief Consistent copy of a slot
+ * 
+ */
+typedef struct {
+  uint32_t handle;              /*!< sensor handle, VIHCSR04_INVALID_HANDLE if slot is free */
+  VIHCSR04_ShmStatus_t status;  /*!< status of latest reading */
+  uint32_t distanceMm;          /*!< distance in mm or VIHCSR04_INVALID_DISTANCE_MM */
+  uint32_t durationUs;          /*!< echo duration, 0 if timeout */
+  uint32_t results;             /*!< number of results since creation */
+  uint64_t timestampUs;         /*!< time of result (time source of driver), 0 without time source */
+  char name[VIHCSR04_SHM_NAME_LEN + 1]; /*!< sensor name */
+} VIHCSR04_ShmReading_t;
+
+/**
+ * @brief Get size of segment
+ * 
+ * @param sensors Number of sensor slots
+ * @return size_t size in bytes
+ */
+static inline size_t VIHCSR04_ShmSize(uint32_t sensors) {
+  return sizeof(VIHCSR04_ShmHeader_t) + (size_t)sensors * sizeof(VIHCSR04_ShmSlot_t);
+}
+
+/**
+ * @brief Get slot of segment
+ * 
+ * @param segment Segment
+ * @param index Handle index of sensor
+ * @return VIHCSR04_ShmSlot_t* slot, NULL if index is beyond segment
+ */
+static inline VIHCSR04_ShmSlot_t* VIHCSR04_ShmSlot(const VIHCSR04_ShmSegment_t* segment, uint32_t index) {
+
+  const VIHCSR04_ShmHeader_t* header = (const VIHCSR04_ShmHeader_t*)segment;
+
+  if (index >= header->sensors)
+    return NULL;
+
+  return (VIHCSR04_ShmSlot_t*)((uintptr_t)segment + sizeof(VIHCSR04_ShmHeader_t)) + index;
+}
+
+/**
+ * @brief Initialize segment in caller provided memory (e.g. mapped shared memory)
+ * 
+ * @param memory Memory of segment, 4 bytes aligned
+ * @param size Size of memory
+ * @param sensors Number of sensor slots
+ * @return VIHCSR04_ShmSegment_t* segment, NULL if memory is too small
+ */
+static inline VIHCSR04_ShmSegment_t* VIHCSR04_ShmInit(void* memory, size_t size, uint32_t sensors) {
+
+  if (NULL == memory || 0 == sensors || size < VIHCSR04_ShmSize(sensors))
+    return NULL;
+
+  VIHCSR04_ShmHeader_t* header = (VIHCSR04_ShmHeader_t*)memory;
+
+  memset(memory, 0, VIHCSR04_ShmSize(sensors));
+  header->version = VIHCSR04_SHM_VERSION;
+  header->sensors = sensors;
+  header->slotSize = sizeof(VIHCSR04_ShmSlot_t);
+  // readers check magic last
+  VIHCSR04_SHM_FENCE(release);
+  header->magic = VIHCSR04_SHM_MAGIC;
+
+  return (VIHCSR04_ShmSegment_t*)memory;
+}
+
+/**
+ * @brief Check header of segment mapped by a reader
+ * 
+ * @param segment Segment
+ * @param size Size of mapped memory
+ * @return true if segment is valid and fits in memory
+ */
+static inline bool VIHCSR04_ShmValid(const VIHCSR04_ShmSegment_t* segment, size_t size) {
+
+  const VIHCSR04_ShmHeader_t* header = (const VIHCSR04_ShmHeader_t*)segment;
+
+  return NULL != segment && sizeof(VIHCSR04_ShmHeader_t) <= size && 
+    VIHCSR04_SHM_MAGIC == header->magic && VIHCSR04_SHM_VERSION == header->version && 
+    sizeof(VIHCSR04_ShmSlot_t) == header->slotSize && VIHCSR04_ShmSize(header->sensors) <= size;
+}
+
+/**
+ * @brief Assign sensor to slot, status and counter are cleared (writer only)
+ * 
+ * @param segment Segment
+ * @param index Handle index of sensor
+ * @param handle Sensor handle, VIHCSR04_INVALID_HANDLE if sensor is deleted
+ * @param name Sensor name, NULL if sensor is deleted
+ */
+static inline void VIHCSR04_ShmAssign(VIHCSR04_ShmSegment_t* segment, uint32_t index, 
+  uint32_t handle, const char* name) {
+
+  VIHCSR04_ShmSlot_t* slot = VIHCSR04_ShmSlot(segment, index);
+  uint32_t words[4] = {0};
+
+  if (NULL == slot)
+    return;
+
+  // name of driver is not terminated if it fills its buffer
+  for (size_t i = 0; NULL != name && i < VIHCSR04_SHM_NAME_LEN && '\0' != name[i]; i++)
+    ((char*)words)[i] = name[i];
+
+  uint32_t sequence = VIHCSR04_SHM_LOAD(slot->sequence, relaxed);
+
+  VIHCSR04_SHM_STORE(slot->sequence, sequence + 1, relaxed);
+  VIHCSR04_SHM_FENCE(release);
+  VIHCSR04_SHM_STORE(slot->handle, handle, relaxed);
+  VIHCSR04_SHM_STORE(slot->status, VIHCSR04_SHM_NONE, relaxed);
+  VIHCSR04_SHM_STORE(slot->distanceMm, VIHCSR04_INVALID_DISTANCE_MM, relaxed);
+  VIHCSR04_SHM_STORE(slot->durationUs, 0, relaxed);
+  VIHCSR04_SHM_STORE(slot->results, 0, relaxed);
+  VIHCSR04_SHM_STORE(slot->timestampUs[0], 0, relaxed);
+  VIHCSR04_SHM_STORE(slot->timestampUs[1], 0, relaxed);
+  for (uint32_t i = 0; i < 4; i++)
+    VIHCSR04_SHM_STORE(slot->name[i], words[i], relaxed);
+  VIHCSR04_SHM_STORE(slot->sequence, sequence + 2, release);
+}
+
+/**
+ * @brief Publish result of sensor (writer only)
+ * 
+ * @param segment Segment
+ * @param index Handle index of sensor
+ * @param durationUs Echo duration, 0 if timeout
+ * @param distanceMm Reported distance or VIHCSR04_INVALID_DISTANCE_MM
+ * @param timestampUs Time of result
+ */
+static inline void VIHCSR04_ShmPublish(VIHCSR04_ShmSegment_t* segment, uint32_t index, 
+  uint32_t durationUs, uint32_t distanceMm, uint64_t timestampUs) {
+
+  VIHCSR04_ShmSlot_t* slot = VIHCSR04_ShmSlot(segment, index);
+
+  if (NULL == slot)
+    return;
+
+  VIHCSR04_ShmStatus_t status = (0 == durationUs) ? VIHCSR04_SHM_TIMEOUT : 
+    (VIHCSR04_INVALID_DISTANCE_MM == distanceMm) ? VIHCSR04_SHM_OUT_OF_RANGE : VIHCSR04_SHM_VALID;
+  uint32_t sequence = VIHCSR04_SHM_LOAD(slot->sequence, relaxed);
+
+  VIHCSR04_SHM_STORE(slot->sequence, sequence + 1, relaxed);
+  VIHCSR04_SHM_FENCE(release);
+  VIHCSR04_SHM_STORE(slot->status, (uint32_t)status, relaxed);
+  VIHCSR04_SHM_STORE(slot->distanceMm, distanceMm, relaxed);
+  VIHCSR04_SHM_STORE(slot->durationUs, durationUs, relaxed);
+  VIHCSR04_SHM_STORE(slot->results, VIHCSR04_SHM_LOAD(slot->results, relaxed) + 1, relaxed);
+  VIHCSR04_SHM_STORE(slot->timestampUs[0], (uint32_t)timestampUs, relaxed);
+  VIHCSR04_SHM_STORE(slot->timestampUs[1], (uint32_t)(timestampUs >> 32), relaxed);
+  VIHCSR04_SHM_STORE(slot->sequence, sequence + 2, release);
+}
+
+/**
+ * @brief Read latest reading of sensor, never blocks the writer
+ * 
+ * @param segment Segment
+ * @param index Handle index of sensor
+ * @param reading Consistent copy of slot
+ * @return true if reading is consistent
+ * @return false if index is beyond segment or slot was updated during every attempt
+ */
+static inline bool VIHCSR04_ShmRead(const VIHCSR04_ShmSegment_t* segment, uint32_t index, 
+  VIHCSR04_ShmReading_t* reading) {
+
+  const VIHCSR04_ShmSlot_t* slot = VIHCSR04_ShmSlot(segment, index);
+  uint32_t words[4];
+
+  if (NULL == slot)
+    return false;
+
+  for (uint32_t attempt = 0; attempt < VIHCSR04_SHM_READ_RETRIES; attempt++) {
+    uint32_t sequence = VIHCSR04_SHM_LOAD(slot->sequence, acquire);
+
+    if (0 != (sequence & 1))
+      continue;
+
+    reading->handle = VIHCSR04_SHM_LOAD(slot->handle, relaxed);
+    reading->status = (VIHCSR04_ShmStatus_t)VIHCSR04_SHM_LOAD(slot->status, relaxed);
+    reading->distanceMm = VIHCSR04_SHM_LOAD(slot->distanceMm, relaxed);
+    reading->durationUs = VIHCSR04_SHM_LOAD(slot->durationUs, relaxed);
+    reading->results = VIHCSR04_SHM_LOAD(slot->results, relaxed);
+    reading->timestampUs = VIHCSR04_SHM_LOAD(slot->timestampUs[0], relaxed) | 
+      ((uint64_t)VIHCSR04_SHM_LOAD(slot->timestampUs[1], relaxed) << 32);
+    for (uint32_t i = 0; i < 4; i++)
+      words[i] = VIHCSR04_SHM_LOAD(slot->name[i], relaxed);
+
+    VIHCSR04_SHM_FENCE(acquire);
+
+    if (sequence == VIHCSR04_SHM_LOAD(slot->sequence, relaxed)) {
+      memcpy(reading->name, words, sizeof(reading->name));
+      reading->name[VIHCSR04_SHM_NAME_LEN] = '\0';
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Find slot of sensor by name
+ * 
+ * @param segment Segment
+ * @param name Sensor name
+ * @return int32_t handle index of sensor, -1 if not found
+ */
+static inline int32_t VIHCSR04_ShmFind(const VIHCSR04_ShmSegment_t* segment, const char* name) {
+
+  const VIHCSR04_ShmHeader_t* header = (const VIHCSR04_ShmHeader_t*)segment;
+  VIHCSR04_ShmReading_t reading;
+
+  for (uint32_t i = 0; i < header->sensors; i++) {
+    if (VIHCSR04_ShmRead(segment, i, &reading) && VIHCSR04_INVALID_HANDLE != reading.handle && 
+      0 == strncmp(reading.name, name, VIHCSR04_SHM_NAME_LEN))
+      return (int32_t)i;
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Create (or replace) POSIX shared memory segment and map it for the writer
+ * 
+ * @param name Name of shared memory object, e.g. "/vihcsr04"
+ * @param sensors Number of sensor slots
+ * @return VIHCSR04_ShmSegment_t* mapped segment, NULL on error
+ */
+VIHCSR04_ShmSegment_t* VIHCSR04_ShmCreate(const char* name, uint32_t sensors);
+
+/**
+ * @brief Map existing POSIX shared memory segment read-only for a reader
+ * 
+ * @param name Name of shared memory object
+ * @return const VIHCSR04_ShmSegment_t* mapped segment, NULL if not found or invalid
+ */
+const VIHCSR04_ShmSegment_t* VIHCSR04_ShmOpen(const char* name);
+
+/**
+ * @brief Unmap segment created or opened by VIHCSR04_ShmCreate/VIHCSR04_ShmOpen
+ * 
+ * @param segment Mapped segment
+ */
+void VIHCSR04_ShmClose(const VIHCSR04_ShmSegment_t* segment);
+
+/**
+ * @brief Remove shared memory object, mapped segments stay valid until closed
+ * 
+ * @param name Name of shared memory object
+ * @return true if object is removed
+ */
+bool VIHCSR04_ShmUnlink(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_SHM_H
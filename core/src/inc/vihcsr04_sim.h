@@ -0,0 +1,206 @@
+/**
+ * @file vihcsr04_sim.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Virtual time echo simulator of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_SIM_H
+#define VIHCSR04_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/** 
+ * @brief Max number of simulated sensors
+ * */
+#if !defined(VIHCSR04_SIM_MAX_SENSORS)
+  #define VIHCSR04_SIM_MAX_SENSORS 16
+#endif
+
+/** 
+ * @brief Delay between trigger and rising edge of echo (ultrasonic burst)
+ * */
+#if !defined(VIHCSR04_SIM_BURST_US)
+  #define VIHCSR04_SIM_BURST_US 450
+#endif
+
+/** 
+ * @brief Echo pulse length if no echo is received (sensor internal timeout)
+ * */
+#if !defined(VIHCSR04_SIM_NO_ECHO_US)
+  #define VIHCSR04_SIM_NO_ECHO_US 38000
+#endif
+
+/** 
+ * @brief Max distance at which the sensor receives an echo
+ * */
+#if !defined(VIHCSR04_SIM_MAX_RANGE_MM)
+  #define VIHCSR04_SIM_MAX_RANGE_MM 4500
+#endif
+
+/**
+ * @brief Edge call-back, has the signature of VIHCSR04_EchoEdge
+ * 
+ */
+typedef void (*VIHCSR04_SimEdge_t) (const void* echoPort, uint16_t echoPin, 
+  uint8_t level, uint64_t timeUs);
+
+/**
+ * @brief Reset simulator: virtual clock is set to 0, all sensors are removed
+ * 
+ * @param seed Seed of pseudo random generator used for noise and dropouts, same seed - same results
+ */
+void VIHCSR04_SimInit(uint32_t seed);
+
+/**
+ * @brief Add simulated sensor. Target distance is out of range until it is set
+ * 
+ * @param triggerPort Pointer to a GPIO structur of trigger pin
+ * @param triggerPin Trigger pin number
+ * @param echoPort Pointer to a GPIO structur of echo pin
+ * @param echoPin Echo pin number
+ * @return int32_t index of simulated sensor, -1 if no place left
+ */
+int32_t VIHCSR04_SimAddSensor(const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin);
+
+/**
+ * @brief Set distance to the target
+ * 
+ * @param sensor Index of simulated sensor
+ * @param distanceMm Distance in mm, beyond VIHCSR04_SIM_MAX_RANGE_MM no echo is received
+ * @return true if sensor is found
+ */
+bool VIHCSR04_SimSetDistance(int32_t sensor, uint32_t distanceMm);
+
+/**
+ * @brief Set noise of measured distance
+ * 
+ * @param sensor Index of simulated sensor
+ * @param noiseMm Amplitude of uniformly distributed noise in mm
+ * @return true if sensor is found
+ */
+bool VIHCSR04_SimSetNoise(int32_t sensor, uint32_t noiseMm);
+
+/**
+ * @brief Set probability of lost echo
+ * 
+ * @param sensor Index of simulated sensor
+ * @param permille Probability of dropout in 1/1000
+ * @return true if sensor is found
+ */
+bool VIHCSR04_SimSetDropout(int32_t sensor, uint16_t permille);
+
+/**
+ * @brief Set crosstalk between two sensors: the burst of "from" sensor is received 
+ *   by "to" sensor if it is waiting for echo, the first received echo ends the measurement
+ * 
+ * @param from Index of sending sensor
+ * @param to Index of receiving sensor
+ * @param pathMm Equivalent distance of sound path, the echo arrives as from a target at pathMm (0 - no crosstalk)
+ * @return true if sensors are found
+ */
+bool VIHCSR04_SimSetCrosstalk(int32_t from, int32_t to, uint32_t pathMm);
+
+/**
+ * @brief Set environment temperature used for speed of sound
+ * 
+ * @param temperature Temperature in degrees Celsius
+ */
+void VIHCSR04_SimSetTemperature(float temperature);
+
+/**
+ * @brief Set call-back receiving echo edges in edge driven mode, 
+ *   edges are reported by VIHCSR04_SimAdvance
+ * 
+ * @param edgeCb Edge call-back (for example VIHCSR04_EchoEdge), NULL - blocking mode only
+ */
+void VIHCSR04_SimSetEdgeCb(VIHCSR04_SimEdge_t edgeCb);
+
+/**
+ * @brief Get number of triggers of simulated sensor
+ * 
+ * @param sensor Index of simulated sensor
+ * @return uint32_t number of triggers
+ */
+uint32_t VIHCSR04_SimGetTriggerCount(int32_t sensor);
+
+/**
+ * @brief Virtual clock, can be used as VIHCSR04_GetTimeUs_t
+ * 
+ * @return uint64_t current virtual time in microseconds
+ */
+uint64_t VIHCSR04_SimGetTimeUs(void);
+
+/**
+ * @brief Advance virtual clock, echo edges falling into the interval 
+ *   are reported to edge call-back in time order
+ * 
+ * @param us Time interval in microseconds
+ */
+void VIHCSR04_SimAdvance(uint64_t us);
+
+/**
+ * @brief Simulated pulse measurement, can be used as VIHCSR04_PulseIn_t. 
+ *   Virtual clock is advanced to the falling edge of echo or to the timeout
+ * 
+ * @param gpio Pointer to a GPIO structur of echo pin
+ * @param port Echo pin number
+ * @param state Measured level, only 1 is supported
+ * @param maxDurationTreshold Timeout in the units used by the driver (microseconds * 1000)
+ * @param context User context
+ * @return uint64_t echo duration in microseconds, 0 if timeout or sensor was not triggered
+ */
+uint64_t VIHCSR04_SimPulseIn(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t maxDurationTreshold, const void* context);
+
+/**
+ * @brief Simulated trigger, can be used as VIHCSR04_TriggerPort_t. 
+ *   Starts measurement of the sensor with matching trigger pin, virtual clock is not advanced
+ * 
+ * @param gpio Pointer to a GPIO structur of trigger pin
+ * @param port Trigger pin number
+ * @param state Trigger level
+ * @param pulseDuration Trigger pulse duration in microseconds
+ * @param context User context
+ */
+void VIHCSR04_SimTrigger(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t pulseDuration, const void* context);
+
+/**
+ * @brief Simulated batched trigger, can be used as VIHCSR04_TriggerMask_t. 
+ *   Starts measurement of all sensors with trigger pin in pinMask at the same time
+ * 
+ * @param gpio Pointer to a GPIO structur of trigger pins
+ * @param pinMask Trigger pins, bit n is pin n
+ * @param state Trigger level
+ * @param pulseDuration Trigger pulse duration in microseconds
+ */
+void VIHCSR04_SimTriggerMask(const void* gpio, uint32_t pinMask, 
+  uint8_t state, uint64_t pulseDuration);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_SIM_H
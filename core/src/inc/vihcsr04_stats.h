@@ -0,0 +1,187 @@
+/**
+ * @file vihcsr04_stats.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Runtime statistics of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_STATS_H
+#define VIHCSR04_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "vihcsr04_math.h"
+
+/** 
+ * @brief Enable per-sensor statistics. 
+ *   If 0 no statistics is kept and no instruction is added to the runtime
+ * */
+#if !defined(VIHCSR04_STATS)
+  #define VIHCSR04_STATS 0
+#endif
+
+/** 
+ * @brief Number of histogram buckets. Bucket 0 counts value 0, 
+ *   bucket b counts values in [2^(b-1), 2^b), the last bucket counts all greater values
+ * */
+#if !defined(VIHCSR04_STATS_BUCKETS)
+  #define VIHCSR04_STATS_BUCKETS 24
+#endif
+
+/**
+ * @brief Histogram with log2 scale buckets
+ * 
+ */
+typedef struct {
+  uint32_t bucket[VIHCSR04_STATS_BUCKETS]; /*!< number of values in bucket */
+  uint32_t count;               /*!< number of values */
+  uint32_t max;                 /*!< maximal value */
+  uint64_t sum;                 /*!< sum of values */
+} VIHCSR04_Hist_t;
+
+/**
+ * @brief Statistics of one sensor, time values in microseconds. 
+ *   Time based values are recorded only if a time source is set
+ * 
+ */
+typedef struct {
+  uint32_t pings;               /*!< number of triggers */
+  uint32_t results;             /*!< number of reported results */
+  uint32_t timeouts;            /*!< results without echo */
+  uint32_t outOfRange;          /*!< results with echo beyond max distance */
+  uint64_t ageUs;               /*!< age of the last result at snapshot time, UINT64_MAX if no result */
+  VIHCSR04_Hist_t echoUs;       /*!< echo duration */
+  VIHCSR04_Hist_t latencyUs;    /*!< time from trigger to reported result */
+  VIHCSR04_Hist_t callbackUs;   /*!< time spent in distance callback */
+  VIHCSR04_Hist_t jitterUs;     /*!< difference between two consecutive intervals of results */
+  uint64_t pingUs;              /*!< time of the last trigger */
+  uint64_t lastResultUs;        /*!< time of the last result */
+  uint64_t lastIntervalUs;      /*!< interval between the last two results */
+} VIHCSR04_Stats_t;
+
+/**
+ * @brief Add value to histogram
+ * 
+ * @param hist Histogram
+ * @param value Value
+ */
+static inline void VIHCSR04_HistAdd(VIHCSR04_Hist_t* hist, uint32_t value) {
+
+  uint32_t bucket = 0;
+
+#if defined(__GNUC__)
+  if(0 != value)
+    bucket = 32 - __builtin_clz(value);
+#else
+  for(uint32_t v = value; 0 != v; v >>= 1)
+    bucket++;
+#endif
+
+  if(bucket >= VIHCSR04_STATS_BUCKETS)
+    bucket = VIHCSR04_STATS_BUCKETS - 1;
+
+  hist->bucket[bucket]++;
+  hist->count++;
+  hist->sum += value;
+  if(value > hist->max)
+    hist->max = value;
+}
+
+/**
+ * @brief Clear statistics
+ * 
+ * @param stats Statistics
+ */
+static inline void VIHCSR04_StatsReset(VIHCSR04_Stats_t* stats) {
+  memset(stats, 0, sizeof(*stats));
+}
+
+/**
+ * @brief Record trigger
+ * 
+ * @param stats Statistics
+ * @param nowUs Current time
+ */
+static inline void VIHCSR04_StatsPing(VIHCSR04_Stats_t* stats, uint64_t nowUs) {
+  stats->pings++;
+  stats->pingUs = nowUs;
+}
+
+/**
+ * @brief Record reported result
+ * 
+ * @param stats Statistics
+ * @param durationUs Echo duration, 0 if timeout
+ * @param distanceMm Distance in mm or VIHCSR04_INVALID_DISTANCE_MM
+ * @param timed Time source is set, nowUs is valid
+ * @param nowUs Current time
+ */
+static inline void VIHCSR04_StatsResult(VIHCSR04_Stats_t* stats, uint32_t durationUs, 
+  uint32_t distanceMm, bool timed, uint64_t nowUs) {
+
+  stats->results++;
+
+  if(0 == durationUs) {
+    stats->timeouts++;
+  } else {
+    VIHCSR04_HistAdd(&stats->echoUs, durationUs);
+    if(VIHCSR04_INVALID_DISTANCE_MM == distanceMm)
+      stats->outOfRange++;
+  }
+
+  if(!timed)
+    return;
+
+  VIHCSR04_HistAdd(&stats->latencyUs, (uint32_t)(nowUs - stats->pingUs));
+
+  if(1 < stats->results) {
+    uint64_t intervalUs = nowUs - stats->lastResultUs;
+    if(2 < stats->results)
+      VIHCSR04_HistAdd(&stats->jitterUs, (uint32_t)((intervalUs > stats->lastIntervalUs) ? 
+        intervalUs - stats->lastIntervalUs : stats->lastIntervalUs - intervalUs));
+    stats->lastIntervalUs = intervalUs;
+  }
+
+  stats->lastResultUs = nowUs;
+}
+
+/**
+ * @brief Make snapshot of statistics
+ * 
+ * @param stats Statistics
+ * @param snapshot Destination
+ * @param timed Time source is set, nowUs is valid
+ * @param nowUs Current time
+ */
+static inline void VIHCSR04_StatsSnapshot(const VIHCSR04_Stats_t* stats, 
+  VIHCSR04_Stats_t* snapshot, bool timed, uint64_t nowUs) {
+
+  *snapshot = *stats;
+  snapshot->ageUs = (timed && 0 != stats->results) ? 
+    nowUs - stats->lastResultUs : UINT64_MAX;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_STATS_H
@@ -0,0 +1,107 @@
+/**
+ * @file vihcsr04_trigger.h
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Port-wide batched trigger writes of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#ifndef VIHCSR04_TRIGGER_H
+#define VIHCSR04_TRIGGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** 
+ * @brief Maximal number of GPIO ports triggered together by one firing group.
+ *   Sensors on further ports are triggered one by one
+ * */
+#if !defined(VIHCSR04_TRIGGER_MAX_PORTS)
+  #define VIHCSR04_TRIGGER_MAX_PORTS 4
+#endif
+
+/**
+ * @brief Call-back function to raise all pins of pinMask of one GPIO port 
+ *   for pulseDuration with one register write, e.g. BSRR of STM32 
+ *   or gpiod_line_request_set_values of libgpiod
+ * 
+ */
+typedef void (*VIHCSR04_TriggerMask_t) (
+  const void* gpio, uint32_t pinMask, uint8_t state, uint64_t pulseDuration);
+
+/**
+ * @brief Trigger pins of sensors fired together, collected per GPIO port
+ * 
+ */
+typedef struct {
+  const void* gpio[VIHCSR04_TRIGGER_MAX_PORTS];   /*!< GPIO ports of collected pins */
+  uint32_t pinMask[VIHCSR04_TRIGGER_MAX_PORTS];   /*!< collected pins of each port */
+  uint32_t ports;                                 /*!< number of used ports */
+} VIHCSR04_TriggerBatch_t;
+
+/**
+ * @brief Initialize empty batch
+ * 
+ * @param batch Batch of trigger pins
+ */
+static inline void VIHCSR04_TriggerBatchInit(VIHCSR04_TriggerBatch_t* batch) {
+  batch->ports = 0;
+}
+
+/**
+ * @brief Add trigger pin to batch
+ * 
+ * @param batch Batch of trigger pins
+ * @param gpio Pointer to a GPIO structur of trigger pin
+ * @param pin Trigger pin number
+ * @return true if pin is added
+ * @return false if pin doesn't fit into mask or all ports are used, 
+ *   the pin has to be triggered alone
+ */
+static inline bool VIHCSR04_TriggerBatchAdd(VIHCSR04_TriggerBatch_t* batch, 
+  const void* gpio, uint16_t pin) {
+
+  if(32 <= pin)
+    return false;
+
+  uint32_t i = 0;
+
+  while(i < batch->ports && batch->gpio[i] != gpio)
+    i++;
+
+  if(VIHCSR04_TRIGGER_MAX_PORTS == i)
+    return false;
+
+  if(batch->ports == i) {
+    batch->gpio[i] = gpio;
+    batch->pinMask[i] = 0;
+    batch->ports++;
+  }
+
+  batch->pinMask[i] |= (uint32_t)1 << pin;
+
+  return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIHCSR04_TRIGGER_H
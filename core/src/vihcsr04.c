@@ -22,145 +22,969 @@
 #include "vihcsr04_private.h"
 #include "string.h"
 
+_Static_assert(sizeof(_Atomic uint32_t) == sizeof(uint32_t), 
+  "layout of VIHCSR04_Ctx_t in c++ requires atomic counters of the same size");
+
+/**
+ * @brief sensor slots of default context
+ * 
+ */
+static VIHCSR04_Sensor_t defaultSensors[VIHCSR04_MAX_SENSORS];
+
 /**
- * @brief array of all sensors in system
+ * @brief default context used by functions without context
  * 
  */
-static struct {
-  Sensor_t snsr[VIHCSR04_MAX_SENSORS];           /*!< array of all buttons */
-  uint32_t currentSnsr;                          /*!< current handled sensor in runtime */
-  uint32_t initializedNumber;                    /*!< number of initialized sensors in array*/
-  VIHCSR04_PulseIn_t pulseInCb;                  /*!< call-back funktion to measure pulse duration*/                      
-  VIHCSR04_TriggerPort_t triggerPortCb;          /*!< call-back funktion to trigger a pulse*/                        
-  VIHCSR04_Printf_t printfCb;                    /*!< printf callback */
-  VIHCSR04_DebugLvl_t debugLvl;                  /*!< debug level */
-} sensors;
+static VIHCSR04_Ctx_t defaultCtx = {
+  .snsr = defaultSensors,
+  .maxSensors = VIHCSR04_MAX_SENSORS
+};
 
 bool VIHCSR04_Init(
   VIHCSR04_PulseIn_t pulseInCb,
   VIHCSR04_TriggerPort_t triggerPortCb
 ) {
+  return VIHCSR04_CtxInit(&defaultCtx, defaultSensors, VIHCSR04_MAX_SENSORS, 
+    pulseInCb, triggerPortCb);
+}
+
+bool VIHCSR04_InitEdgeDriven(
+  VIHCSR04_TriggerPort_t triggerPortCb,
+  VIHCSR04_GetTimeUs_t getTimeUsCb
+) {
+  return VIHCSR04_CtxInitEdgeDriven(&defaultCtx, defaultSensors, VIHCSR04_MAX_SENSORS, 
+    triggerPortCb, getTimeUsCb);
+}
+
+void VIHCSR04_EchoEdge(const void* echoPort, uint16_t echoPin, 
+  uint8_t level, uint64_t timeUs) {
+  VIHCSR04_CtxEchoEdge(&defaultCtx, echoPort, echoPin, level, timeUs);
+}
+
+void VIHCSR04_EchoEdgeByHandle(VIHCSR04_Handle_t handle, 
+  uint8_t level, uint64_t timeUs) {
+  VIHCSR04_CtxEchoEdgeByHandle(&defaultCtx, handle, level, timeUs);
+}
+
+VIHCSR04_Handle_t VIHCSR04_Create(const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin) {
+  return VIHCSR04_CtxCreate(&defaultCtx, name, 
+    triggerPort, triggerPin, echoPort, echoPin);
+}
+
+VIHCSR04_Handle_t VIHCSR04_CreateFiltered(const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_FilterCfg_t* filterCfg) {
+  return VIHCSR04_CtxCreateFiltered(&defaultCtx, name, 
+    triggerPort, triggerPin, echoPort, echoPin, filterCfg);
+}
+
+bool VIHCSR04_Delete(const char* name) {
+  return VIHCSR04_CtxDelete(&defaultCtx, name);
+}
+
+bool VIHCSR04_DeleteByHandle(VIHCSR04_Handle_t handle) {
+  return VIHCSR04_CtxDeleteByHandle(&defaultCtx, handle);
+}
+
+VIHCSR04_Handle_t VIHCSR04_GetHandle(const char* name) {
+  return VIHCSR04_CtxGetHandle(&defaultCtx, name);
+}
+
+bool VIHCSR04_MeasureDistanceAsync(const char* name, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_Distance_t distanceMesuredCb, const void* context) {
+  return VIHCSR04_CtxMeasureDistanceAsync(&defaultCtx, name, 
+    mode, temperature, maxDistanceCm, distanceMesuredCb, context);
+}
+
+bool VIHCSR04_MeasureDistanceAsyncByHandle(VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_Distance_t distanceMesuredCb, const void* context) {
+  return VIHCSR04_CtxMeasureDistanceAsyncByHandle(&defaultCtx, handle, 
+    mode, temperature, maxDistanceCm, distanceMesuredCb, context);
+}
+
+bool VIHCSR04_MeasureDistanceMmAsyncByHandle(VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context) {
+  return VIHCSR04_CtxMeasureDistanceMmAsyncByHandle(&defaultCtx, handle, 
+    mode, temperature, maxDistanceCm, distanceMesuredCb, context);
+}
+
+void VIHCSR04_StopContinuousMeasure(const char* name) {
+  VIHCSR04_CtxStopContinuousMeasure(&defaultCtx, name);
+}
+
+void VIHCSR04_StopContinuousMeasureByHandle(VIHCSR04_Handle_t handle) {
+  VIHCSR04_CtxStopContinuousMeasureByHandle(&defaultCtx, handle);
+}
+
+bool VIHCSR04_SetFiringGroup(const char* name, uint16_t group) {
+  return VIHCSR04_CtxSetFiringGroup(&defaultCtx, name, group);
+}
+
+bool VIHCSR04_SetFiringGroupByHandle(VIHCSR04_Handle_t handle, uint16_t group) {
+  return VIHCSR04_CtxSetFiringGroupByHandle(&defaultCtx, handle, group);
+}
+
+bool VIHCSR04_SetAdaptive(const char* name, bool enable) {
+  return VIHCSR04_CtxSetAdaptive(&defaultCtx, name, enable);
+}
+
+bool VIHCSR04_SetAdaptiveByHandle(VIHCSR04_Handle_t handle, bool enable) {
+  return VIHCSR04_CtxSetAdaptiveByHandle(&defaultCtx, handle, enable);
+}
+
+bool VIHCSR04_SetPeriod(const char* name, uint32_t periodUs) {
+  return VIHCSR04_CtxSetPeriod(&defaultCtx, name, periodUs);
+}
+
+bool VIHCSR04_SetPeriodByHandle(VIHCSR04_Handle_t handle, uint32_t periodUs) {
+  return VIHCSR04_CtxSetPeriodByHandle(&defaultCtx, handle, periodUs);
+}
+
+bool VIHCSR04_SetEvents(const char* name, const VIHCSR04_EventCfg_t* eventCfg) {
+  return VIHCSR04_CtxSetEvents(&defaultCtx, name, eventCfg);
+}
+
+bool VIHCSR04_SetEventsByHandle(VIHCSR04_Handle_t handle, const VIHCSR04_EventCfg_t* eventCfg) {
+  return VIHCSR04_CtxSetEventsByHandle(&defaultCtx, handle, eventCfg);
+}
+
+uint32_t VIHCSR04_GetDeadlineMisses(const char* name) {
+  return VIHCSR04_CtxGetDeadlineMisses(&defaultCtx, name);
+}
+
+uint32_t VIHCSR04_GetDeadlineMissesByHandle(VIHCSR04_Handle_t handle) {
+  return VIHCSR04_CtxGetDeadlineMissesByHandle(&defaultCtx, handle);
+}
+
+void VIHCSR04_SetGuardInterval(uint32_t guardIntervalUs) {
+  VIHCSR04_CtxSetGuardInterval(&defaultCtx, guardIntervalUs);
+}
+
+float VIHCSR04_MeasureDistance(const char* name,
+  float temperature, uint16_t maxDistanceCm) {
+  return VIHCSR04_CtxMeasureDistance(&defaultCtx, name, temperature, maxDistanceCm);
+}
+
+float VIHCSR04_MeasureDistanceByHandle(VIHCSR04_Handle_t handle,
+  float temperature, uint16_t maxDistanceCm) {
+  return VIHCSR04_CtxMeasureDistanceByHandle(&defaultCtx, handle, temperature, maxDistanceCm);
+}
+
+uint32_t VIHCSR04_MeasureDistanceMmByHandle(VIHCSR04_Handle_t handle,
+  float temperature, uint16_t maxDistanceCm) {
+  return VIHCSR04_CtxMeasureDistanceMmByHandle(&defaultCtx, handle, temperature, maxDistanceCm);
+}
+
+void VIHCSR04_Runtime(void) {
+  VIHCSR04_CtxRuntime(&defaultCtx);
+}
+
+uint64_t VIHCSR04_RuntimeUntil(uint32_t budgetUs) {
+  return VIHCSR04_CtxRuntimeUntil(&defaultCtx, budgetUs);
+}
+
+bool VIHCSR04_SetSampleBuffer(VIHCSR04_Sample_t* buffer, uint32_t capacity) {
+  return VIHCSR04_CtxSetSampleBuffer(&defaultCtx, buffer, capacity);
+}
+
+uint32_t VIHCSR04_DrainSamples(VIHCSR04_Sample_t* samples, uint32_t maxSamples) {
+  return VIHCSR04_CtxDrainSamples(&defaultCtx, samples, maxSamples);
+}
+
+uint32_t VIHCSR04_GetSampleOverflows(void) {
+  return VIHCSR04_CtxGetSampleOverflows(&defaultCtx);
+}
+
+bool VIHCSR04_SetCommandBuffer(VIHCSR04_Command_t* buffer, uint32_t capacity) {
+  return VIHCSR04_CtxSetCommandBuffer(&defaultCtx, buffer, capacity);
+}
+
+bool VIHCSR04_PostCreate(const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_Created_t createdCb, const void* context) {
+  return VIHCSR04_CtxPostCreate(&defaultCtx, name, 
+    triggerPort, triggerPin, echoPort, echoPin, createdCb, context);
+}
+
+bool VIHCSR04_PostDelete(VIHCSR04_Handle_t handle) {
+  return VIHCSR04_CtxPostDelete(&defaultCtx, handle);
+}
+
+bool VIHCSR04_PostMeasureMm(VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context) {
+  return VIHCSR04_CtxPostMeasureMm(&defaultCtx, handle, 
+    mode, temperature, maxDistanceCm, distanceMesuredCb, context);
+}
+
+bool VIHCSR04_PostStop(VIHCSR04_Handle_t handle) {
+  return VIHCSR04_CtxPostStop(&defaultCtx, handle);
+}
+
+bool VIHCSR04_PostConfigure(VIHCSR04_Handle_t handle, 
+  float temperature, uint16_t maxDistanceCm) {
+  return VIHCSR04_CtxPostConfigure(&defaultCtx, handle, temperature, maxDistanceCm);
+}
+
+uint32_t VIHCSR04_GetCommandOverflows(void) {
+  return VIHCSR04_CtxGetCommandOverflows(&defaultCtx);
+}
+
+void VIHCSR04_SetRecorder(VIHCSR04_Recorder_t* recorder) {
+  VIHCSR04_CtxSetRecorder(&defaultCtx, recorder);
+}
+
+void VIHCSR04_SetPublisher(VIHCSR04_ShmSegment_t* segment) {
+  VIHCSR04_CtxSetPublisher(&defaultCtx, segment);
+}
+
+bool VIHCSR04_SetTimeCb(VIHCSR04_GetTimeUs_t getTimeUsCb) {
+  return VIHCSR04_CtxSetTimeCb(&defaultCtx, getTimeUsCb);
+}
+
+void VIHCSR04_SetTriggerMaskCb(VIHCSR04_TriggerMask_t triggerMaskCb) {
+  VIHCSR04_CtxSetTriggerMaskCb(&defaultCtx, triggerMaskCb);
+}
+
+bool VIHCSR04_GetStats(const char* name, VIHCSR04_Stats_t* stats) {
+  return VIHCSR04_CtxGetStats(&defaultCtx, name, stats);
+}
+
+bool VIHCSR04_GetStatsByHandle(VIHCSR04_Handle_t handle, VIHCSR04_Stats_t* stats) {
+  return VIHCSR04_CtxGetStatsByHandle(&defaultCtx, handle, stats);
+}
+
+bool VIHCSR04_ResetStats(const char* name) {
+  return VIHCSR04_CtxResetStats(&defaultCtx, name);
+}
+
+bool VIHCSR04_ResetStatsByHandle(VIHCSR04_Handle_t handle) {
+  return VIHCSR04_CtxResetStatsByHandle(&defaultCtx, handle);
+}
+
+void VIHCSR04_SetPrintfCb(VIHCSR04_Printf_t printfCb) {
+  VIHCSR04_CtxSetPrintfCb(&defaultCtx, printfCb);
+}
+
+bool VIHCSR04_SetLogBuffer(VIHCSR04_LogRecord_t* buffer, uint32_t capacity) {
+  return VIHCSR04_CtxSetLogBuffer(&defaultCtx, buffer, capacity);
+}
+
+uint32_t VIHCSR04_DrainLog(VIHCSR04_LogRecord_t* records, uint32_t maxRecords) {
+  return VIHCSR04_CtxDrainLog(&defaultCtx, records, maxRecords);
+}
+
+uint32_t VIHCSR04_PrintLog(uint32_t maxRecords) {
+  return VIHCSR04_CtxPrintLog(&defaultCtx, maxRecords);
+}
+
+uint32_t VIHCSR04_GetLogOverflows(void) {
+  return VIHCSR04_CtxGetLogOverflows(&defaultCtx);
+}
+
+void VIHCSR04_SetDebugLvl(VIHCSR04_DebugLvl_t lvl) {
+  VIHCSR04_CtxSetDebugLvl(&defaultCtx, lvl);
+}
+
+bool VIHCSR04_CtxInit(VIHCSR04_Ctx_t* ctx, 
+  VIHCSR04_Sensor_t* sensors, uint32_t maxSensors,
+  VIHCSR04_PulseIn_t pulseInCb,
+  VIHCSR04_TriggerPort_t triggerPortCb
+) {
 
-  if(NULL == pulseInCb || NULL == triggerPortCb)
+  if(NULL == ctx || NULL == pulseInCb || NULL == triggerPortCb)
+    return false;
+
+  // sensor index is limited by 16 bit of VIHCSR04_Handle_t
+  if(NULL == sensors || 0 == maxSensors || 0xFFFF < maxSensors)
     return false;
   
-  sensors.pulseInCb = pulseInCb;
-  sensors.triggerPortCb = triggerPortCb;
-  sensors.currentSnsr = 0;
-  sensors.initializedNumber = 0;
+  ctx->snsr = sensors;
+  ctx->maxSensors = maxSensors;
+  AttachBus(ctx);
+  ctx->bus.pulseInCb = pulseInCb;
+  ctx->bus.triggerPortCb = triggerPortCb;
+  ctx->bus.getTimeUsCb = NULL;
+  ctx->bus.edgeDriven = false;
+
+  for(uint32_t i = 0; i < ctx->maxSensors; i++) {
+    Init(ctx, &ctx->snsr[i], NULL, NULL, 0, NULL, 0);
+    ctx->snsr[i].generation++;
+  }
+  ctx->bus.periodicNumber = 0;
+  return true;
+}
+
+bool VIHCSR04_CtxInitEdgeDriven(VIHCSR04_Ctx_t* ctx, 
+  VIHCSR04_Sensor_t* sensors, uint32_t maxSensors,
+  VIHCSR04_TriggerPort_t triggerPortCb,
+  VIHCSR04_GetTimeUs_t getTimeUsCb
+) {
+
+  if(NULL == ctx || NULL == triggerPortCb || NULL == getTimeUsCb)
+    return false;
+
+  if(NULL == sensors || 0 == maxSensors || 0xFFFF < maxSensors)
+    return false;
 
-  for(uint32_t i = 0; i < VIHCSR04_MAX_SENSORS; i++) {
-    Init(&sensors.snsr[i], NULL, NULL, 0, NULL, 0);
+  ctx->snsr = sensors;
+  ctx->maxSensors = maxSensors;
+  AttachBus(ctx);
+  ctx->bus.pulseInCb = NULL;
+  ctx->bus.triggerPortCb = triggerPortCb;
+  ctx->bus.getTimeUsCb = getTimeUsCb;
+  ctx->bus.edgeDriven = true;
+
+  for(uint32_t i = 0; i < ctx->maxSensors; i++) {
+    Init(ctx, &ctx->snsr[i], NULL, NULL, 0, NULL, 0);
+    ctx->snsr[i].generation++;
   }
+  ctx->bus.periodicNumber = 0;
   return true;
 }
 
-bool VIHCSR04_Create(const char* name, 
+void VIHCSR04_CtxEchoEdge(VIHCSR04_Ctx_t* ctx, const void* echoPort, uint16_t echoPin, 
+  uint8_t level, uint64_t timeUs) {
+
+  if(!ctx->bus.edgeDriven)
+    return;
+
+  int32_t sensorIndex = FindSensorByEcho(ctx, echoPort, echoPin);
+
+  if(0 > sensorIndex)
+    return;
+
+  VIHCSR04_CtxEchoEdgeByHandle(ctx, MakeHandle(ctx, sensorIndex), level, timeUs);
+}
+
+void VIHCSR04_CtxEchoEdgeByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  uint8_t level, uint64_t timeUs) {
+
+  if(!ctx->bus.edgeDriven)
+    return;
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
+    return;
+
+  VIHCSR04_CoreEchoEdge(&sensor->core, level, timeUs);
+}
+
+VIHCSR04_Handle_t VIHCSR04_CtxCreate(VIHCSR04_Ctx_t* ctx, const char* name, 
   const void* triggerPort, uint16_t triggerPin, 
   const void* echoPort, uint16_t echoPin) {
+  return VIHCSR04_CtxCreateFiltered(ctx, name, triggerPort, triggerPin, 
+    echoPort, echoPin, NULL);
+}
+
+VIHCSR04_Handle_t VIHCSR04_CtxCreateFiltered(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_FilterCfg_t* filterCfg) {
 
   if(NULL == name)
-    return false;
+    return VIHCSR04_INVALID_HANDLE;
 
-  if(VIHCSR04_MAX_SENSORS <= sensors.initializedNumber)
-    return false;
+  if(NULL != filterCfg && !VIHCSR04_FilterCfgValid(filterCfg))
+    return VIHCSR04_INVALID_HANDLE;
 
-  int32_t sensorIndex = FindSensorByName(name);
+  int32_t sensorIndex = FindSensorByName(ctx, name);
 
   if(0 <= sensorIndex)
+    return VIHCSR04_INVALID_HANDLE;
+
+  // reuse a slot of deleted sensor if any
+  uint32_t slot = 0;
+  while(slot < ctx->bus.number && ctx->snsr[slot].used)
+    slot++;
+
+  if(ctx->maxSensors <= slot)
+    return VIHCSR04_INVALID_HANDLE;
+
+  if(!Init(ctx, &ctx->snsr[slot], name, 
+    triggerPort, triggerPin, echoPort, echoPin))
+    return VIHCSR04_INVALID_HANDLE;
+
+  ctx->snsr[slot].core.group = slot;
+  VIHCSR04_FilterInit(&ctx->snsr[slot].core.filter, filterCfg);
+
+  if(slot == ctx->bus.number)
+    ctx->bus.number++;
+
+  return MakeHandle(ctx, slot);
+}
+
+bool VIHCSR04_CtxDelete(VIHCSR04_Ctx_t* ctx, const char* name) {
+  return VIHCSR04_CtxDeleteByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name));
+}
+
+bool VIHCSR04_CtxDeleteByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
     return false;
 
-  if(Init(&sensors.snsr[sensors.initializedNumber], name, 
-    triggerPort, triggerPin, echoPort, echoPin)) {
-    sensors.initializedNumber++;
-    return true;
-  }
+  Init(ctx, sensor, NULL, NULL, 0, NULL, 0);
+
+  // all existing handles of this slot become stale
+  sensor->generation++;
+
+  while(0 < ctx->bus.number && 
+    !ctx->snsr[ctx->bus.number - 1].used)
+    ctx->bus.number--;
 
   return true;
 }
 
-bool VIHCSR04_MeasureDistanceAsync(
+VIHCSR04_Handle_t VIHCSR04_CtxGetHandle(VIHCSR04_Ctx_t* ctx, const char* name) {
+
+  int32_t sensorIndex = FindSensorByName(ctx, name);
+
+  if(0 > sensorIndex)
+    return VIHCSR04_INVALID_HANDLE;
+
+  return MakeHandle(ctx, sensorIndex);
+}
+
+bool VIHCSR04_CtxMeasureDistanceAsync(VIHCSR04_Ctx_t* ctx, 
   const char* name, const VIHCSR04_MeasureMode_t mode, 
   float temperature, uint16_t maxDistanceCm,
   const VIHCSR04_Distance_t distanceMesuredCb, const void* context) {
 
-  if(NULL == name)
+  return VIHCSR04_CtxMeasureDistanceAsyncByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name), 
+    mode, temperature, maxDistanceCm, distanceMesuredCb, context);
+}
+
+bool VIHCSR04_CtxMeasureDistanceAsyncByHandle(VIHCSR04_Ctx_t* ctx, 
+  VIHCSR04_Handle_t handle, const VIHCSR04_MeasureMode_t mode, 
+  float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_Distance_t distanceMesuredCb, const void* context) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
     return false;
-  
-  int32_t sensorIndex = FindSensorByName(name);
 
-  if(0 > sensorIndex)
+  sensor->temperature = temperature;
+  sensor->maxDistanceCm = maxDistanceCm;
+  sensor->core.distCb = distanceMesuredCb;
+  sensor->core.distMmCb = NULL;
+  sensor->core.userContext = context;
+  RecordConfig(ctx, sensor, sensor->temperature, sensor->maxDistanceCm);
+  VIHCSR04_CoreMeasureAsync(&ctx->bus, &sensor->core, 
+    VIHCSR04_CONTINUOUS_MEASURE == mode, temperature, maxDistanceCm);
+ 
+  return true;
+}
+
+bool VIHCSR04_CtxMeasureDistanceMmAsyncByHandle(VIHCSR04_Ctx_t* ctx, 
+  VIHCSR04_Handle_t handle, const VIHCSR04_MeasureMode_t mode, 
+  float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
     return false;
 
-  sensors.snsr[sensorIndex].mode = mode;
-  sensors.snsr[sensorIndex].temperature = temperature;
-  sensors.snsr[sensorIndex].maxDistanceCm = maxDistanceCm;
-  sensors.snsr[sensorIndex].distCb = distanceMesuredCb;
-  sensors.snsr[sensorIndex].userContext = context;
-  sensors.snsr[sensorIndex].enabled = true;
+  sensor->temperature = temperature;
+  sensor->maxDistanceCm = maxDistanceCm;
+  sensor->core.distCb = NULL;
+  sensor->core.distMmCb = distanceMesuredCb;
+  sensor->core.userContext = context;
+  RecordConfig(ctx, sensor, sensor->temperature, sensor->maxDistanceCm);
+  VIHCSR04_CoreMeasureAsync(&ctx->bus, &sensor->core, 
+    VIHCSR04_CONTINUOUS_MEASURE == mode, temperature, maxDistanceCm);
  
   return true;
 }
 
-void VIHCSR04_StopContinuousMeasure(const char* name) {
+void VIHCSR04_CtxStopContinuousMeasure(VIHCSR04_Ctx_t* ctx, const char* name) {
+  VIHCSR04_CtxStopContinuousMeasureByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name));
+}
 
-  if(NULL == name)
+void VIHCSR04_CtxStopContinuousMeasureByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
     return;
+
+  sensor->core.enabled = false;
+}
+
+bool VIHCSR04_CtxSetFiringGroup(VIHCSR04_Ctx_t* ctx, const char* name, uint16_t group) {
+  return VIHCSR04_CtxSetFiringGroupByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name), group);
+}
+
+bool VIHCSR04_CtxSetFiringGroupByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, uint16_t group) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
+    return false;
+
+  sensor->core.group = group;
+
+  return true;
+}
+
+bool VIHCSR04_CtxSetAdaptive(VIHCSR04_Ctx_t* ctx, const char* name, bool enable) {
+  return VIHCSR04_CtxSetAdaptiveByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name), enable);
+}
+
+bool VIHCSR04_CtxSetAdaptiveByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, bool enable) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
+    return false;
+
+  VIHCSR04_AdaptiveInit(&sensor->core.adaptive, enable);
+
+  return true;
+}
+
+bool VIHCSR04_CtxSetPeriod(VIHCSR04_Ctx_t* ctx, const char* name, uint32_t periodUs) {
+  return VIHCSR04_CtxSetPeriodByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name), periodUs);
+}
+
+bool VIHCSR04_CtxSetPeriodByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, uint32_t periodUs) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
+    return false;
+
+  VIHCSR04_CoreSetPeriod(&ctx->bus, &sensor->core, periodUs);
+
+  return true;
+}
+
+bool VIHCSR04_CtxSetEvents(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const VIHCSR04_EventCfg_t* eventCfg) {
+  return VIHCSR04_CtxSetEventsByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name), eventCfg);
+}
+
+bool VIHCSR04_CtxSetEventsByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  const VIHCSR04_EventCfg_t* eventCfg) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor || (NULL != eventCfg && !VIHCSR04_EventCfgValid(eventCfg)))
+    return false;
+
+  VIHCSR04_EventInit(&sensor->core.event, eventCfg);
+
+  return true;
+}
+
+uint32_t VIHCSR04_CtxGetDeadlineMisses(VIHCSR04_Ctx_t* ctx, const char* name) {
+  return VIHCSR04_CtxGetDeadlineMissesByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name));
+}
+
+uint32_t VIHCSR04_CtxGetDeadlineMissesByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle) {
+
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
+    return 0;
+
+  return sensor->core.sched.deadlineMisses;
+}
+
+void VIHCSR04_CtxSetGuardInterval(VIHCSR04_Ctx_t* ctx, uint32_t guardIntervalUs) {
+  ctx->bus.guardIntervalUs = guardIntervalUs;
+}
+
+float VIHCSR04_CtxMeasureDistance(VIHCSR04_Ctx_t* ctx, const char* name, 
+  float temperature, uint16_t maxDistanceCm) {
+  return VIHCSR04_CtxMeasureDistanceByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name), 
+    temperature, maxDistanceCm);
+}
+
+float VIHCSR04_CtxMeasureDistanceByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  float temperature, uint16_t maxDistanceCm) {
   
-  int32_t sensorIndex = FindSensorByName(name);
+  VIHCSR04_Conversion_t conv;
+  uint32_t durationMicroSec;
 
-  if(0 > sensorIndex)
-    return;
+  VIHCSR04_ConversionInit(&conv, temperature, maxDistanceCm);
+
+  if(!MeasureSync(ctx, GetSensor(ctx, handle), temperature, &conv, &durationMicroSec))
+    return -1;
 
-  sensors.snsr[sensorIndex].enabled = false;
+  return VIHCSR04_ToCm(&conv, durationMicroSec);
 }
 
-float VIHCSR04_MeasureDistance(const char* name, 
+uint32_t VIHCSR04_CtxMeasureDistanceMmByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
   float temperature, uint16_t maxDistanceCm) {
   
+  VIHCSR04_Conversion_t conv;
+  uint32_t durationMicroSec;
+
+  VIHCSR04_ConversionInit(&conv, temperature, maxDistanceCm);
+
+  if(!MeasureSync(ctx, GetSensor(ctx, handle), temperature, &conv, &durationMicroSec))
+    return VIHCSR04_INVALID_DISTANCE_MM;
+
+  return VIHCSR04_ToMm(&conv, durationMicroSec);
+}
+
+void VIHCSR04_CtxRuntime(VIHCSR04_Ctx_t* ctx) {
+  // commands of other threads are executed between measurements, 
+  // so sensor settings are never changed by two threads
+  if(NULL != ctx->commands.buffer)
+    ExecuteCommands(ctx);
+
+  VIHCSR04_CoreRuntime(&ctx->bus);
+}
+
+uint64_t VIHCSR04_CtxRuntimeUntil(VIHCSR04_Ctx_t* ctx, uint32_t budgetUs) {
+
+  if(NULL == ctx->bus.getTimeUsCb) {
+    VIHCSR04_CtxRuntime(ctx);
+    return NextAction(ctx, 0);
+  }
+
+  uint64_t startUs = ctx->bus.getTimeUsCb();
+  uint64_t nowUs = startUs;
+  uint64_t nextUs = NextAction(ctx, nowUs);
+
+  // steps are started only while budget lasts, the last one can exceed it
+  while(nextUs == nowUs && nowUs - startUs < budgetUs) {
+    VIHCSR04_CtxRuntime(ctx);
+    nowUs = ctx->bus.getTimeUsCb();
+    nextUs = NextAction(ctx, nowUs);
+  }
+
+  return nextUs;
+}
+
+bool VIHCSR04_CtxSetSampleBuffer(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sample_t* buffer, uint32_t capacity) {
+
+  if(NULL != buffer && (0 == capacity || 0 != (capacity & (capacity - 1))))
+    return false;
+
+  ctx->samples.buffer = NULL;
+  ctx->samples.mask = (NULL != buffer) ? capacity - 1 : 0;
+  atomic_store_explicit(&ctx->samples.head, 0, memory_order_relaxed);
+  atomic_store_explicit(&ctx->samples.tail, 0, memory_order_relaxed);
+  atomic_store_explicit(&ctx->samples.overflows, 0, memory_order_relaxed);
+  ctx->samples.buffer = buffer;
+
+  return true;
+}
+
+uint32_t VIHCSR04_CtxDrainSamples(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sample_t* samples, uint32_t maxSamples) {
+
+  if(NULL == ctx->samples.buffer || NULL == samples)
+    return 0;
+
+  uint32_t tail = atomic_load_explicit(&ctx->samples.tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&ctx->samples.head, memory_order_acquire);
+  uint32_t count = head - tail;
+
+  if(count > maxSamples)
+    count = maxSamples;
+
+  for(uint32_t i = 0; i < count; i++) {
+    samples[i] = ctx->samples.buffer[(tail + i) & ctx->samples.mask];
+  }
+
+  atomic_store_explicit(&ctx->samples.tail, tail + count, memory_order_release);
+
+  return count;
+}
+
+uint32_t VIHCSR04_CtxGetSampleOverflows(VIHCSR04_Ctx_t* ctx) {
+  return atomic_load_explicit(&ctx->samples.overflows, memory_order_relaxed);
+}
+
+bool VIHCSR04_CtxSetCommandBuffer(VIHCSR04_Ctx_t* ctx, VIHCSR04_Command_t* buffer, uint32_t capacity) {
+
+  if(NULL != buffer && (0 == capacity || 0 != (capacity & (capacity - 1))))
+    return false;
+
+  ctx->commands.buffer = NULL;
+  ctx->commands.mask = (NULL != buffer) ? capacity - 1 : 0;
+  ctx->commands.dequeuePos = 0;
+  atomic_store_explicit(&ctx->commands.enqueuePos, 0, memory_order_relaxed);
+  atomic_store_explicit(&ctx->commands.overflows, 0, memory_order_relaxed);
+
+  for(uint32_t i = 0; NULL != buffer && i < capacity; i++) {
+    atomic_store_explicit(&buffer[i].sequence, i, memory_order_relaxed);
+  }
+
+  ctx->commands.buffer = buffer;
+
+  return true;
+}
+
+bool VIHCSR04_CtxPostCreate(VIHCSR04_Ctx_t* ctx, const char* name, 
+  const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin,
+  const VIHCSR04_Created_t createdCb, const void* context) {
+
   if(NULL == name)
-    return -1;
+    return false;
 
-  int32_t sensorIndex = FindSensorByName(name);
+  VIHCSR04_Command_t* command = ReserveCommand(ctx);
 
-  if(0 > sensorIndex)
-    return -1;
+  if(NULL == command)
+    return false;
+
+  command->type = VIHCSR04_CMD_CREATE;
+  strncpy(command->name, name, VIHCSR04_NAME_LEN - 1);
+  command->name[VIHCSR04_NAME_LEN - 1] = '\0';
+  command->triggerPort = triggerPort;
+  command->triggerPin = triggerPin;
+  command->echoPort = echoPort;
+  command->echoPin = echoPin;
+  command->createdCb = createdCb;
+  command->context = context;
+  PublishCommand(command);
+
+  return true;
+}
+
+bool VIHCSR04_CtxPostDelete(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle) {
 
-  Sensor_t tmpSensor = sensors.snsr[sensorIndex];
+  VIHCSR04_Command_t* command = ReserveCommand(ctx);
 
-  sensors.snsr[sensorIndex].temperature = temperature;
-  sensors.snsr[sensorIndex].maxDistanceCm = maxDistanceCm;
-  sensors.snsr[sensorIndex].enabled = true;
+  if(NULL == command)
+    return false;
+
+  command->type = VIHCSR04_CMD_DELETE;
+  command->handle = handle;
+  PublishCommand(command);
+
+  return true;
+}
+
+bool VIHCSR04_CtxPostMeasureMm(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  const VIHCSR04_MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+  const VIHCSR04_DistanceMm_t distanceMesuredCb, const void* context) {
 
-  float res = Runtime(&sensors.snsr[sensorIndex]);
+  VIHCSR04_Command_t* command = ReserveCommand(ctx);
+
+  if(NULL == command)
+    return false;
 
-  sensors.snsr[sensorIndex] = tmpSensor;
+  command->type = VIHCSR04_CMD_MEASURE;
+  command->handle = handle;
+  command->mode = mode;
+  command->temperature = temperature;
+  command->maxDistanceCm = maxDistanceCm;
+  command->distMmCb = distanceMesuredCb;
+  command->context = context;
+  PublishCommand(command);
 
-  return res;
+  return true;
 }
 
-void VIHCSR04_Runtime(void) {
-  if(0 >= sensors.initializedNumber)
+bool VIHCSR04_CtxPostStop(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle) {
+
+  VIHCSR04_Command_t* command = ReserveCommand(ctx);
+
+  if(NULL == command)
+    return false;
+
+  command->type = VIHCSR04_CMD_STOP;
+  command->handle = handle;
+  PublishCommand(command);
+
+  return true;
+}
+
+bool VIHCSR04_CtxPostConfigure(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, 
+  float temperature, uint16_t maxDistanceCm) {
+
+  VIHCSR04_Command_t* command = ReserveCommand(ctx);
+
+  if(NULL == command)
+    return false;
+
+  command->type = VIHCSR04_CMD_CONFIGURE;
+  command->handle = handle;
+  command->temperature = temperature;
+  command->maxDistanceCm = maxDistanceCm;
+  PublishCommand(command);
+
+  return true;
+}
+
+uint32_t VIHCSR04_CtxGetCommandOverflows(VIHCSR04_Ctx_t* ctx) {
+  return atomic_load_explicit(&ctx->commands.overflows, memory_order_relaxed);
+}
+
+void VIHCSR04_CtxSetRecorder(VIHCSR04_Ctx_t* ctx, VIHCSR04_Recorder_t* recorder) {
+
+  ctx->recorder = recorder;
+
+  // recording started while running has to know existing sensors
+  for(uint32_t i = 0; i < ctx->bus.number; i++) {
+    VIHCSR04_Sensor_t* sensor = &ctx->snsr[i];
+    if(!sensor->used)
+      continue;
+    Record(ctx, VIHCSR04_REC_SENSOR, sensor, 
+      ((uint32_t)sensor->core.triggerPin << 16) | sensor->core.echoPin);
+    if(0 != sensor->maxDistanceCm)
+      RecordConfig(ctx, sensor, sensor->temperature, sensor->maxDistanceCm);
+  }
+}
+
+void VIHCSR04_CtxSetPublisher(VIHCSR04_Ctx_t* ctx, VIHCSR04_ShmSegment_t* segment) {
+
+  ctx->publisher = segment;
+
+  if(NULL == segment)
     return;
-  
-  Runtime(&sensors.snsr[sensors.currentSnsr]);
 
-  sensors.currentSnsr++;
+  // readers have to find existing sensors
+  for(uint32_t i = 0; i < ctx->bus.number; i++) {
+    if(ctx->snsr[i].used)
+      VIHCSR04_ShmAssign(segment, i, MakeHandle(ctx, i), ctx->snsr[i].name);
+  }
+}
+
+bool VIHCSR04_CtxSetLogBuffer(VIHCSR04_Ctx_t* ctx, VIHCSR04_LogRecord_t* buffer, uint32_t capacity) {
+
+  if(NULL != buffer && (0 == capacity || 0 != (capacity & (capacity - 1))))
+    return false;
+
+  ctx->log.buffer = NULL;
+  ctx->log.mask = (NULL != buffer) ? capacity - 1 : 0;
+  atomic_store_explicit(&ctx->log.head, 0, memory_order_relaxed);
+  atomic_store_explicit(&ctx->log.tail, 0, memory_order_relaxed);
+  atomic_store_explicit(&ctx->log.overflows, 0, memory_order_relaxed);
+  ctx->log.buffer = buffer;
+
+  return true;
+}
+
+uint32_t VIHCSR04_CtxDrainLog(VIHCSR04_Ctx_t* ctx, VIHCSR04_LogRecord_t* records, uint32_t maxRecords) {
 
-  if(sensors.currentSnsr >= sensors.initializedNumber) {
-    sensors.currentSnsr = 0;
+  if(NULL == ctx->log.buffer || NULL == records)
+    return 0;
+
+  uint32_t tail = atomic_load_explicit(&ctx->log.tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&ctx->log.head, memory_order_acquire);
+  uint32_t count = head - tail;
+
+  if(count > maxRecords)
+    count = maxRecords;
+
+  for(uint32_t i = 0; i < count; i++) {
+    records[i] = ctx->log.buffer[(tail + i) & ctx->log.mask];
   }
+
+  atomic_store_explicit(&ctx->log.tail, tail + count, memory_order_release);
+
+  return count;
 }
 
-void VIHCSR04_SetPrintfCb(VIHCSR04_Printf_t printfCb) {
-  sensors.printfCb = printfCb;
+uint32_t VIHCSR04_CtxPrintLog(VIHCSR04_Ctx_t* ctx, uint32_t maxRecords) {
+
+  if(NULL == ctx->bus.printfCb)
+    return 0;
+
+  VIHCSR04_LogRecord_t record;
+  char line[VIHCSR04_LOG_LINE_LEN];
+  uint32_t count = 0;
+
+  while(count < maxRecords && 0 < VIHCSR04_CtxDrainLog(ctx, &record, 1)) {
+    const VIHCSR04_Sensor_t* sensor = GetSensor(ctx, record.handle);
+
+    VIHCSR04_FormatLog(&record, (NULL != sensor) ? sensor->name : NULL, line, sizeof(line));
+    ctx->bus.printfCb("%s", line);
+    count++;
+  }
+
+  return count;
 }
 
-void VIHCSR04_SetDebugLvl(VIHCSR04_DebugLvl_t lvl) {
-  sensors.debugLvl = lvl;
+uint32_t VIHCSR04_CtxGetLogOverflows(VIHCSR04_Ctx_t* ctx) {
+  return atomic_load_explicit(&ctx->log.overflows, memory_order_relaxed);
+}
+
+bool VIHCSR04_CtxSetTimeCb(VIHCSR04_Ctx_t* ctx, VIHCSR04_GetTimeUs_t getTimeUsCb) {
+
+  // edge driven mode can't work without time source
+  if(ctx->bus.edgeDriven && NULL == getTimeUsCb)
+    return false;
+
+  ctx->bus.getTimeUsCb = getTimeUsCb;
+
+  return true;
+}
+
+void VIHCSR04_CtxSetTriggerMaskCb(VIHCSR04_Ctx_t* ctx, VIHCSR04_TriggerMask_t triggerMaskCb) {
+  ctx->bus.triggerMaskCb = triggerMaskCb;
+}
+
+bool VIHCSR04_CtxGetStats(VIHCSR04_Ctx_t* ctx, const char* name, VIHCSR04_Stats_t* stats) {
+  return VIHCSR04_CtxGetStatsByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name), stats);
 }
 
-static bool Init(Sensor_t* sensor, const char* name, 
+bool VIHCSR04_CtxGetStatsByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle, VIHCSR04_Stats_t* stats) {
+#if VIHCSR04_STATS
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor || NULL == stats)
+    return false;
+
+  VIHCSR04_StatsSnapshot(&sensor->core.stats, stats, NULL != ctx->bus.getTimeUsCb, 
+    VIHCSR04_CoreNow(&ctx->bus));
+
+  return true;
+#else
+  (void)ctx;
+  (void)handle;
+  (void)stats;
+  return false;
+#endif
+}
+
+bool VIHCSR04_CtxResetStats(VIHCSR04_Ctx_t* ctx, const char* name) {
+  return VIHCSR04_CtxResetStatsByHandle(ctx, VIHCSR04_CtxGetHandle(ctx, name));
+}
+
+bool VIHCSR04_CtxResetStatsByHandle(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle) {
+#if VIHCSR04_STATS
+  VIHCSR04_Sensor_t* sensor = GetSensor(ctx, handle);
+
+  if(NULL == sensor)
+    return false;
+
+  VIHCSR04_StatsReset(&sensor->core.stats);
+
+  return true;
+#else
+  (void)ctx;
+  (void)handle;
+  return false;
+#endif
+}
+
+void VIHCSR04_CtxSetPrintfCb(VIHCSR04_Ctx_t* ctx, VIHCSR04_Printf_t printfCb) {
+  ctx->bus.printfCb = printfCb;
+}
+
+void VIHCSR04_CtxSetDebugLvl(VIHCSR04_Ctx_t* ctx, VIHCSR04_DebugLvl_t lvl) {
+  ctx->bus.debugLvl = lvl;
+}
+
+static bool Init(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sensor_t* sensor, const char* name, 
   const void* triggerPort, uint16_t triggerPin, 
   const void* echoPort, uint16_t echoPin) {
 
@@ -169,79 +993,326 @@ static bool Init(Sensor_t* sensor, const char* name,
 
   if(NULL == name)
     memset(sensor->name, 0, VIHCSR04_NAME_LEN);
-  else
-    strncpy(sensor->name, name, VIHCSR04_NAME_LEN);
+  else {
+    strncpy(sensor->name, name, VIHCSR04_NAME_LEN - 1);
+    sensor->name[VIHCSR04_NAME_LEN - 1] = '\0';
+  }
+
+  sensor->used = (NULL != name);
+
+  VIHCSR04_CoreSetPeriod(&ctx->bus, &sensor->core, 0);
+  sensor->temperature = 0;
+  sensor->maxDistanceCm = 0;
+  sensor->core.triggerPort = triggerPort;
+  sensor->core.triggerPin = triggerPin;
+  sensor->core.echoPort = echoPort;
+  sensor->core.echoPin = echoPin;
+  sensor->core.enabled = false;
+  sensor->core.continuous = false;
+  sensor->core.distCb = NULL;
+  sensor->core.distMmCb = NULL;
+  sensor->core.userContext = NULL;
+  VIHCSR04_ConversionInit(&sensor->core.conv, 0, 0);
+  sensor->core.lastDurationUs = 0;
+  VIHCSR04_FilterInit(&sensor->core.filter, NULL);
+  VIHCSR04_EventInit(&sensor->core.event, NULL);
+  VIHCSR04_AdaptiveInit(&sensor->core.adaptive, false);
+#if VIHCSR04_STATS
+  VIHCSR04_StatsReset(&sensor->core.stats);
+#endif
+  sensor->core.group = 0;
+  sensor->core.state = VIHCSR04_SENSOR_IDLE;
+  sensor->core.triggerTimeUs = 0;
+  sensor->core.echoRiseUs = 0;
+  sensor->core.echoFallUs = 0;
 
-  sensor->triggerPort = triggerPort;
-  sensor->triggerPin = triggerPin;
-  sensor->echoPort = echoPort;
-  sensor->echoPin = echoPin;
-  sensor->enabled = false;
+  if(sensor->used)
+    Record(ctx, VIHCSR04_REC_SENSOR, sensor, ((uint32_t)triggerPin << 16) | echoPin);
 
-  if(VIHCSR04_DEBUG_INFO <= sensors.debugLvl && 
-     NULL != sensors.printfCb && 0 < strlen(sensor->name))
-    sensors.printfCb("Sensor \"%s\": is initialized\r\n", sensor->name);
+  if(NULL != ctx->publisher)
+    VIHCSR04_ShmAssign(ctx->publisher, sensor - ctx->snsr, sensor->used ? 
+      MakeHandle(ctx, sensor - ctx->snsr) : VIHCSR04_INVALID_HANDLE, sensor->used ? sensor->name : NULL);
+
+  if(sensor->used)
+    VIHCSR04_CoreCreated(&ctx->bus, &sensor->core);
 
   return true;
 }
 
-static int32_t FindSensorByName(const char* name) {
+static int32_t FindSensorByName(VIHCSR04_Ctx_t* ctx, const char* name) {
   int32_t result = -1;
 
   if(NULL == name)
     return result;
 
-  for(uint32_t i = 0; ((i < VIHCSR04_MAX_SENSORS) && 
-      (i < sensors.initializedNumber)); i++) {
-    if(0 == strncmp(sensors.snsr[i].name, name, VIHCSR04_NAME_LEN)) {
+  for(uint32_t i = 0; ((i < ctx->maxSensors) && 
+      (i < ctx->bus.number)); i++) {
+    if(ctx->snsr[i].used && 
+       0 == strncmp(ctx->snsr[i].name, name, VIHCSR04_NAME_LEN - 1)) {
       result = i;
+      break;
     }
   }
   return result;
 }
 
-static float Runtime(Sensor_t* sensor) {
+static int32_t FindSensorByEcho(VIHCSR04_Ctx_t* ctx, const void* echoPort, uint16_t echoPin) {
 
-  if(NULL == sensor || !sensor->enabled)
-    return -1;
+  for(uint32_t i = 0; ((i < ctx->maxSensors) && 
+      (i < ctx->bus.number)); i++) {
+    if(ctx->snsr[i].used && 
+       ctx->snsr[i].core.echoPort == echoPort && 
+       ctx->snsr[i].core.echoPin == echoPin) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static VIHCSR04_Handle_t MakeHandle(VIHCSR04_Ctx_t* ctx, uint32_t index) {
+  // generation 0 is never used, so a valid handle is never equal to VIHCSR04_INVALID_HANDLE
+  if(0 == ctx->snsr[index].generation)
+    ctx->snsr[index].generation = 1;
+
+  return ((VIHCSR04_Handle_t)ctx->snsr[index].generation << 16) | index;
+}
+
+static VIHCSR04_Sensor_t* GetSensor(VIHCSR04_Ctx_t* ctx, VIHCSR04_Handle_t handle) {
+  uint32_t index = handle & 0xFFFF;
+
+  if(index >= ctx->bus.number)
+    return NULL;
+
+  VIHCSR04_Sensor_t* sensor = &ctx->snsr[index];
+
+  if(!sensor->used || sensor->generation != (handle >> 16))
+    return NULL;
+
+  return sensor;
+}
+
+static void PushSample(VIHCSR04_Ctx_t* ctx, const VIHCSR04_Sample_t* sample) {
 
-  if(VIHCSR04_DEBUG_INFO <= sensors.debugLvl && 
-     NULL != sensors.printfCb)
-    sensors.printfCb("Sensor \"%s\": measurement startet\r\n", sensor->name);
+  uint32_t head = atomic_load_explicit(&ctx->samples.head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&ctx->samples.tail, memory_order_acquire);
 
-  //float speedOfSoundInCmPerMicroSec = 0.03313 + 0.0000606 * sensor->temperature; // Cair ≈ (331.3 + 0.606 ⋅ ϑ) m/s
-  uint64_t speadOfSound = 33130000000 + 60600000 * sensor->temperature;
+  if(head - tail > ctx->samples.mask) {
+    // only producer changes overflows, load and store is enough
+    atomic_store_explicit(&ctx->samples.overflows, 
+      atomic_load_explicit(&ctx->samples.overflows, memory_order_relaxed) + 1, 
+      memory_order_relaxed);
+    return;
+  }
+
+  ctx->samples.buffer[head & ctx->samples.mask] = *sample;
+
+  atomic_store_explicit(&ctx->samples.head, head + 1, memory_order_release);
+}
+
+static void AttachBus(VIHCSR04_Ctx_t* ctx) {
+
+  ctx->bus.drv = ctx;
+  ctx->bus.sensors = &ctx->snsr[0].core;
+  ctx->bus.number = 0;
+  ctx->bus.currentSnsr = 0;
+  ctx->bus.groupPhase = VIHCSR04_GROUP_SELECT;
+  ctx->bus.currentGroup = 0;
+  ctx->bus.guardEndUs = 0;
+}
+
+#if VIHCSR04_DEBUG
+static bool Log(VIHCSR04_CoreBus_t* bus, VIHCSR04_DebugLvl_t lvl, VIHCSR04_LogEvent_t event, 
+  uint32_t index, uint32_t value0, uint32_t value1) {
+
+  VIHCSR04_Ctx_t* ctx = (VIHCSR04_Ctx_t*)bus->drv;
+
+  if(NULL == ctx->log.buffer)
+    return false;
+
+  uint32_t head = atomic_load_explicit(&ctx->log.head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&ctx->log.tail, memory_order_acquire);
+
+  if(head - tail > ctx->log.mask) {
+    // only producer changes overflows, load and store is enough
+    atomic_store_explicit(&ctx->log.overflows, 
+      atomic_load_explicit(&ctx->log.overflows, memory_order_relaxed) + 1, 
+      memory_order_relaxed);
+    return true;
+  }
 
-  // Compute max delay based on max distance with 25% margin in microseconds
-  //unsigned long maxDistanceDurationMicroSec = 2.5 * sensor->maxDistanceCm / speedOfSoundInCmPerMicroSec;
-  uint64_t maxDistance = 2500000000000 / speadOfSound * sensor->maxDistanceCm;
+  VIHCSR04_LogRecord_t* record = &ctx->log.buffer[head & ctx->log.mask];
 
-  // Hold trigger for 10 microseconds, which is signal for sensor to measure distance.
-  sensors.triggerPortCb(sensor->triggerPort, sensor->triggerPin, 1, 10, sensor->userContext);
+  record->timestampUs = VIHCSR04_CoreNow(bus);
+  record->handle = MakeHandle(ctx, index);
+  record->value0 = value0;
+  record->value1 = value1;
+  record->event = (uint8_t)event;
+  record->lvl = (uint8_t)lvl;
 
-  // Measure the length of echo signal, which is equal to the time needed for sound to go there and back.
-  uint64_t durationMicroSec = sensors.pulseInCb(
-    sensor->echoPort, sensor->echoPin, 1, maxDistance*1000, sensor->userContext); 
+  atomic_store_explicit(&ctx->log.head, head + 1, memory_order_release);
+  return true;
+}
+#endif
+
+static const char* Name(VIHCSR04_CoreBus_t* bus, uint32_t index) {
+  return ((VIHCSR04_Ctx_t*)bus->drv)->snsr[index].name;
+}
+
+static void Publish(VIHCSR04_CoreBus_t* bus, uint32_t index, 
+  uint32_t durationUs, uint32_t distanceMm, uint64_t nowUs) {
+
+  VIHCSR04_Ctx_t* ctx = (VIHCSR04_Ctx_t*)bus->drv;
+
+  if(NULL != ctx->publisher)
+    VIHCSR04_ShmPublish(ctx->publisher, index, durationUs, distanceMm, nowUs);
+
+  if(NULL != ctx->samples.buffer) {
+    VIHCSR04_Sample_t sample = {
+      .handle = MakeHandle(ctx, index),
+      .durationUs = durationUs,
+      .distanceMm = distanceMm,
+      .timestampUs = nowUs
+    };
+    PushSample(ctx, &sample);
+  }
+}
+
+static void RecordSample(VIHCSR04_CoreBus_t* bus, uint32_t index, uint32_t durationUs) {
+  VIHCSR04_Ctx_t* ctx = (VIHCSR04_Ctx_t*)bus->drv;
+  Record(ctx, VIHCSR04_REC_SAMPLE, &ctx->snsr[index], durationUs);
+}
 
-  //float distanceCm = durationMicroSec / 2.0 * speedOfSoundInCmPerMicroSec;
-  float distanceCm = (float)speadOfSound / 2000000000000 * durationMicroSec ;
+static void Record(VIHCSR04_Ctx_t* ctx, VIHCSR04_RecType_t type, 
+  const VIHCSR04_Sensor_t* sensor, uint32_t value) {
 
-  //float distanceCm = durationMicroSec / 
+  if(NULL == ctx->recorder)
+    return;
 
-  if (distanceCm == 0 || distanceCm > sensor->maxDistanceCm) {
-      distanceCm = -1.0 ;
-  } 
+  VIHCSR04_RecPut(ctx->recorder, type, (uint16_t)(sensor - ctx->snsr), 
+    VIHCSR04_CoreNow(&ctx->bus), value);
+}
 
-  if(VIHCSR04_DEBUG_INFO <= sensors.debugLvl && 
-     NULL != sensors.printfCb)
-    sensors.printfCb("Sensor \"%s\": measured distance %f\r\n", sensor->name, distanceCm);
+static void RecordConfig(VIHCSR04_Ctx_t* ctx, const VIHCSR04_Sensor_t* sensor, 
+  float temperature, uint16_t maxDistanceCm) {
 
-  if (sensor->distCb)
-    sensor->distCb(distanceCm, sensor->userContext);
+  if(NULL == ctx->recorder)
+    return;
 
-  if (sensor->mode == VIHCSR04_ONESHOT_MEASURE)
-    sensor->enabled = false;
+  uint32_t value;
 
-  return distanceCm;
+  memcpy(&value, &temperature, sizeof(value));
+  Record(ctx, VIHCSR04_REC_TEMPERATURE, sensor, value);
+  Record(ctx, VIHCSR04_REC_RANGE, sensor, maxDistanceCm);
 }
 
+static VIHCSR04_Command_t* ReserveCommand(VIHCSR04_Ctx_t* ctx) {
+
+  VIHCSR04_Command_t* buffer = ctx->commands.buffer;
+
+  if(NULL == buffer)
+    return NULL;
+
+  uint32_t pos = atomic_load_explicit(&ctx->commands.enqueuePos, memory_order_relaxed);
+
+  while(true) {
+    VIHCSR04_Command_t* command = &buffer[pos & ctx->commands.mask];
+    uint32_t sequence = atomic_load_explicit(&command->sequence, memory_order_acquire);
+    int32_t diff = (int32_t)(sequence - pos);
+
+    if(0 == diff) {
+      // cell is free, reserve it if no other producer was faster
+      if(atomic_compare_exchange_weak_explicit(&ctx->commands.enqueuePos, &pos, pos + 1, 
+        memory_order_relaxed, memory_order_relaxed))
+        return command;
+    } else if(0 > diff) {
+      // cell of previous round is not consumed yet, queue is full
+      atomic_fetch_add_explicit(&ctx->commands.overflows, 1, memory_order_relaxed);
+      return NULL;
+    } else {
+      pos = atomic_load_explicit(&ctx->commands.enqueuePos, memory_order_relaxed);
+    }
+  }
+}
+
+static void PublishCommand(VIHCSR04_Command_t* command) {
+  // reserved cell has sequence equal to its position, position + 1 marks it as filled
+  atomic_store_explicit(&command->sequence, 
+    atomic_load_explicit(&command->sequence, memory_order_relaxed) + 1, memory_order_release);
+}
+
+static void ExecuteCommands(VIHCSR04_Ctx_t* ctx) {
+
+  // commands posted while executing wait for the next cycle
+  for(uint32_t i = 0; i <= ctx->commands.mask; i++) {
+    uint32_t pos = ctx->commands.dequeuePos;
+    VIHCSR04_Command_t* command = &ctx->commands.buffer[pos & ctx->commands.mask];
+
+    if((int32_t)(atomic_load_explicit(&command->sequence, memory_order_acquire) - (pos + 1)) < 0)
+      return;
+
+    switch(command->type) {
+      case VIHCSR04_CMD_CREATE: {
+        VIHCSR04_Handle_t handle = VIHCSR04_CtxCreate(ctx, command->name, 
+          command->triggerPort, command->triggerPin, command->echoPort, command->echoPin);
+        if(NULL != command->createdCb)
+          command->createdCb(handle, command->context);
+        break;
+      }
+      case VIHCSR04_CMD_DELETE:
+        VIHCSR04_CtxDeleteByHandle(ctx, command->handle);
+        break;
+      case VIHCSR04_CMD_MEASURE:
+        VIHCSR04_CtxMeasureDistanceMmAsyncByHandle(ctx, command->handle, command->mode, 
+          command->temperature, command->maxDistanceCm, command->distMmCb, command->context);
+        break;
+      case VIHCSR04_CMD_STOP:
+        VIHCSR04_CtxStopContinuousMeasureByHandle(ctx, command->handle);
+        break;
+      case VIHCSR04_CMD_CONFIGURE: {
+        VIHCSR04_Sensor_t* sensor = GetSensor(ctx, command->handle);
+        if(NULL == sensor)
+          break;
+        sensor->temperature = command->temperature;
+        sensor->maxDistanceCm = command->maxDistanceCm;
+        VIHCSR04_ConversionInit(&sensor->core.conv, command->temperature, command->maxDistanceCm);
+        // narrowed timeout depends on range
+        VIHCSR04_AdaptiveInit(&sensor->core.adaptive, sensor->core.adaptive.enabled);
+        RecordConfig(ctx, sensor, sensor->temperature, sensor->maxDistanceCm);
+        break;
+      }
+    }
+
+    // cell is free for producers of the next round
+    atomic_store_explicit(&command->sequence, pos + ctx->commands.mask + 1, memory_order_release);
+    ctx->commands.dequeuePos = pos + 1;
+  }
+}
+
+static bool MeasureSync(VIHCSR04_Ctx_t* ctx, VIHCSR04_Sensor_t* sensor, float temperature,
+  const VIHCSR04_Conversion_t* conv, uint32_t* durationMicroSec) {
+
+  if(NULL == sensor || VIHCSR04_SENSOR_IDLE != sensor->core.state)
+    return false;
+
+  // replay converts the sample with settings of this call
+  RecordConfig(ctx, sensor, temperature, conv->maxDistanceCm);
+
+  VIHCSR04_CoreMeasureSync(&ctx->bus, &sensor->core, conv, durationMicroSec);
+
+  // replay continues with settings of async measurement
+  if(0 != sensor->maxDistanceCm)
+    RecordConfig(ctx, sensor, sensor->temperature, sensor->maxDistanceCm);
+
+  return true;
+}
+
+static uint64_t NextAction(VIHCSR04_Ctx_t* ctx, uint64_t nowUs) {
+
+  // posted commands are executed by the next runtime step
+  if(NULL != ctx->commands.buffer && (int32_t)(atomic_load_explicit(
+    &ctx->commands.buffer[ctx->commands.dequeuePos & ctx->commands.mask].sequence, 
+    memory_order_acquire) - (ctx->commands.dequeuePos + 1)) >= 0)
+    return nowUs;
+
+  return VIHCSR04_CoreNextAction(&ctx->bus, nowUs);
+}
@@ -23,128 +23,640 @@
 
 namespace vihcsr04 {
 
+  /**
+   * @brief Hooks of core runtime, there is no recorder in c++ realisation
+   * 
+   */
+  struct CoreHooks {
+
+    /**
+     * @brief Store log record in log buffer (producer side)
+     * 
+     * @return true if log buffer is enabled, even if record is dropped
+     * @return false if event has to be printed
+     */
+    static bool Log(VIHCSR04_CoreBus_t* bus, VIHCSR04_DebugLvl_t lvl, VIHCSR04_LogEvent_t event, 
+      uint32_t index, uint32_t value0, uint32_t value1);
+
+    /**
+     * @brief Name of sensor in slot
+     * 
+     */
+    static const char* Name(VIHCSR04_CoreBus_t* bus, uint32_t index);
+
+    /**
+     * @brief Store result in shared memory and sample buffer
+     * 
+     */
+    static void Publish(VIHCSR04_CoreBus_t* bus, uint32_t index, 
+      uint32_t durationUs, uint32_t distanceMm, uint64_t nowUs);
+  };
+
+}
+
+// hooks of core runtime, resolved at compile time
+#define VIHCSR04_CORE_STRIDE sizeof(VIHCSR04_Core_t)
+#define VIHCSR04_CORE_LOG(bus, lvl, event, index, value0, value1) \
+  vihcsr04::CoreHooks::Log(bus, lvl, event, index, value0, value1)
+#define VIHCSR04_CORE_NAME(bus, index) vihcsr04::CoreHooks::Name(bus, index)
+#define VIHCSR04_CORE_PUBLISH(bus, index, durationUs, distanceMm, nowUs) \
+  vihcsr04::CoreHooks::Publish(bus, index, durationUs, distanceMm, nowUs)
+
+#include "vihcsr04_core_run.h"
+
+namespace vihcsr04 {
+
+  bool CoreHooks::Log(VIHCSR04_CoreBus_t* bus, VIHCSR04_DebugLvl_t lvl, VIHCSR04_LogEvent_t event, 
+    uint32_t index, uint32_t value0, uint32_t value1) {
+
+    Hcsr04Sensor* drv = static_cast<Hcsr04Sensor*>(bus->drv);
+
+    if (!drv->m_log.Enabled())
+      return false;
+
+    drv->m_log.Push(LogRecord_t{
+      .timestampUs = VIHCSR04_CoreNow(bus),
+      .handle = drv->MakeHandle(index),
+      .value0 = value0,
+      .value1 = value1,
+      .event = (uint8_t)event,
+      .lvl = (uint8_t)lvl
+    });
+
+    return true;
+  }
+
+  const char* CoreHooks::Name(VIHCSR04_CoreBus_t* bus, uint32_t index) {
+    return static_cast<Hcsr04Sensor*>(bus->drv)->m_sensors[index].name.c_str();
+  }
+
+  void CoreHooks::Publish(VIHCSR04_CoreBus_t* bus, uint32_t index, 
+    uint32_t durationUs, uint32_t distanceMm, uint64_t nowUs) {
+
+    Hcsr04Sensor* drv = static_cast<Hcsr04Sensor*>(bus->drv);
+
+    if (nullptr != drv->m_publisher)
+      VIHCSR04_ShmPublish(drv->m_publisher, index, durationUs, distanceMm, nowUs);
+
+    if (drv->m_samples.Enabled()) {
+      drv->m_samples.Push(Sample_t{
+        .handle = drv->MakeHandle(index),
+        .durationUs = durationUs,
+        .distanceMm = distanceMm,
+        .timestampUs = nowUs
+      });
+    }
+  }
+
   Hcsr04Sensor::Hcsr04Sensor(PulseIn_t pulseInCb, TriggerPort_t triggerPortCb) {
 
     if(nullptr == pulseInCb || nullptr == triggerPortCb)
       return;
 
-    m_pulseInCb = pulseInCb;
-    m_triggerPortCb = triggerPortCb;
+    m_bus.drv = this;
+    m_bus.pulseInCb = pulseInCb;
+    m_bus.triggerPortCb = triggerPortCb;
+
+    m_isInitialized = true;
+  }
+
+  Hcsr04Sensor::Hcsr04Sensor(TriggerPort_t triggerPortCb, GetTimeUs_t getTimeUsCb, 
+      size_t maxSensors) {
+
+    if(nullptr == triggerPortCb || nullptr == getTimeUsCb || 
+       0 == maxSensors || maxSensors > m_maxSensors)
+      return;
+
+    m_bus.drv = this;
+    m_bus.triggerPortCb = triggerPortCb;
+    m_bus.getTimeUsCb = getTimeUsCb;
+    m_bus.edgeDriven = true;
+
+    // EchoEdge works on m_sensors from interrupt context, storage must never move
+    m_maxSensors = maxSensors;
+    m_sensors.reserve(maxSensors);
+    m_cores.reserve(maxSensors);
 
     m_isInitialized = true;
   }
 
   Hcsr04Sensor::~Hcsr04Sensor() {
     m_sensors.clear();
+    m_cores.clear();
+    m_names.clear();
   }
 
-  bool Hcsr04Sensor::AddSensor(const std::string& name, 
+  Handle_t Hcsr04Sensor::AddSensor(std::string_view name, 
       const void* triggerPort, uint16_t triggerPin, 
       const void* echoPort, uint16_t echoPin) {
+    return AddSensor(name, triggerPort, triggerPin, echoPort, echoPin, 
+      FilterCfg_t{});
+  }
+
+  Handle_t Hcsr04Sensor::AddSensor(std::string_view name, 
+      const void* triggerPort, uint16_t triggerPin, 
+      const void* echoPort, uint16_t echoPin,
+      const FilterCfg_t& filterCfg) {
     
     if (!m_isInitialized || name.empty() || 
-        m_sensors.contains(name))
-      return false;
+        m_names.contains(name) || !VIHCSR04_FilterCfgValid(&filterCfg))
+      return INVALID_HANDLE;
+
+    // reuse the lowest slot of deleted sensor if any, as c realisation does
+    uint32_t slot = m_sensors.size();
+    if (!m_freeSlots.empty()) {
+      auto lowest = std::min_element(m_freeSlots.begin(), m_freeSlots.end());
+      slot = *lowest;
+      m_freeSlots.erase(lowest);
+    } else if (slot >= m_maxSensors) {
+      return INVALID_HANDLE;
+    } else {
+      m_sensors.emplace_back();
+      m_cores.emplace_back();
+      // storage can move in blocking mode
+      m_bus.sensors = m_cores.data();
+      m_bus.number = m_cores.size();
+    }
+
+    uint16_t generation = m_sensors[slot].generation;
 
-    m_sensors[name] = Sensor_t{
-      .name = name,
-      .triggerPort = triggerPort,
-      .triggerPin = triggerPin,
-      .echoPort = echoPort,
-      .echoPin = echoPin
+    m_sensors[slot] = Sensor_t{
+      .used = true,
+      .generation = generation,
+      .name = std::string(name)
     };
 
-    m_sensorsPtr.push_back(&m_sensors.at(name));
-    if(DEBUG_INFO <= m_debugLvl && nullptr != m_printfCb)
-      m_printfCb("Sensor \"%s\": registered\r\n", name.c_str());
+    VIHCSR04_Core_t& core = m_cores[slot];
+    core = VIHCSR04_Core_t{};
+    core.triggerPort = triggerPort;
+    core.triggerPin = triggerPin;
+    core.echoPort = echoPort;
+    core.echoPin = echoPin;
+    core.group = slot;
+    VIHCSR04_FilterInit(&core.filter, &filterCfg);
 
-    return true;
+    m_names.emplace(name, slot);
+
+    if (nullptr != m_publisher)
+      VIHCSR04_ShmAssign(m_publisher, slot, MakeHandle(slot), m_sensors[slot].name.c_str());
+
+    VIHCSR04_CoreCreated(&m_bus, &core);
+
+    return MakeHandle(slot);
   }
 
-  bool Hcsr04Sensor::DeleteSensor(const std::string& name) {
+  bool Hcsr04Sensor::DeleteSensor(std::string_view name) {
+    return DeleteSensor(GetHandle(name));
+  }
+
+  bool Hcsr04Sensor::DeleteSensor(Handle_t handle) {
+
+    Sensor_t* sensor = GetSensor(handle);
 
-    if (!m_isInitialized || name.empty())
+    if (nullptr == sensor)
       return false;
 
-    m_sensors.erase(name);
+    m_names.erase(sensor->name);
 
-    m_sensorsPtr.clear();
+    VIHCSR04_Core_t& core = CoreOf(sensor);
+    VIHCSR04_CoreSetPeriod(&m_bus, &core, 0);
+    core = VIHCSR04_Core_t{};
 
-    for (auto it = m_sensors.begin(); it != m_sensors.end(); ++it) {
-      m_sensorsPtr.push_back(&it->second);
-    }
+    // all existing handles of this slot become stale
+    uint16_t generation = sensor->generation + 1;
+    *sensor = Sensor_t{};
+    sensor->generation = generation;
+
+    m_freeSlots.push_back(handle & 0xFFFF);
+
+    if (nullptr != m_publisher)
+      VIHCSR04_ShmAssign(m_publisher, handle & 0xFFFF, INVALID_HANDLE, nullptr);
 
     return true;
   }
 
-  bool Hcsr04Sensor::MeasureDistanceAsync(const std::string& name, 
+  Handle_t Hcsr04Sensor::GetHandle(std::string_view name) {
+
+    if (!m_isInitialized)
+      return INVALID_HANDLE;
+
+    auto it = m_names.find(name);
+
+    if (it == m_names.end())
+      return INVALID_HANDLE;
+
+    return MakeHandle(it->second);
+  }
+
+  bool Hcsr04Sensor::MeasureDistanceAsync(std::string_view name, 
     const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
     const Distance_t distanceMesuredCb, const void* context) {
-    
-    if (!m_isInitialized || name.empty() ||
-        !m_sensors.contains(name))
+    return MeasureDistanceAsync(GetHandle(name), mode, temperature, 
+      maxDistanceCm, distanceMesuredCb, context);
+  }
+
+  bool Hcsr04Sensor::MeasureDistanceAsync(Handle_t handle, 
+    const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+    const Distance_t distanceMesuredCb, const void* context) {
+
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
       return false;
 
-    auto& sensor = m_sensors[name];
+    sensor->temperature = temperature;
+    sensor->maxDistanceCm = maxDistanceCm;
+    VIHCSR04_Core_t& core = CoreOf(sensor);
+    core.distCb = distanceMesuredCb;
+    core.distMmCb = nullptr;
+    core.userContext = context;
+    VIHCSR04_CoreMeasureAsync(&m_bus, &core, 
+      CONTINUOUS_MEASURE == mode, temperature, maxDistanceCm);
+
+    return true;
+  }
+
+  bool Hcsr04Sensor::MeasureDistanceMmAsync(Handle_t handle, 
+    const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+    const DistanceMm_t distanceMesuredCb, const void* context) {
 
-    sensor.mode = mode;
-    sensor.temperature = temperature;
-    sensor.maxDistanceCm = maxDistanceCm;
-    sensor.distCb = distanceMesuredCb;
-    sensor.userContext = context;
-    sensor.enabled = true;
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return false;
+
+    sensor->temperature = temperature;
+    sensor->maxDistanceCm = maxDistanceCm;
+    VIHCSR04_Core_t& core = CoreOf(sensor);
+    core.distCb = nullptr;
+    core.distMmCb = distanceMesuredCb;
+    core.userContext = context;
+    VIHCSR04_CoreMeasureAsync(&m_bus, &core, 
+      CONTINUOUS_MEASURE == mode, temperature, maxDistanceCm);
 
     return true;
   }
 
-  float Hcsr04Sensor::MeasureDistance(const std::string& name, 
+  void Hcsr04Sensor::StopContinuousMeasure(std::string_view name) {
+    StopContinuousMeasure(GetHandle(name));
+  }
+
+  void Hcsr04Sensor::StopContinuousMeasure(Handle_t handle) {
+
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return;
+
+    CoreOf(sensor).enabled = false;
+  }
+
+  bool Hcsr04Sensor::SetFiringGroup(std::string_view name, uint32_t group) {
+    return SetFiringGroup(GetHandle(name), group);
+  }
+
+  bool Hcsr04Sensor::SetFiringGroup(Handle_t handle, uint32_t group) {
+
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return false;
+
+    CoreOf(sensor).group = group;
+
+    return true;
+  }
+
+  bool Hcsr04Sensor::SetAdaptive(std::string_view name, bool enable) {
+    return SetAdaptive(GetHandle(name), enable);
+  }
+
+  bool Hcsr04Sensor::SetAdaptive(Handle_t handle, bool enable) {
+
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return false;
+
+    VIHCSR04_AdaptiveInit(&CoreOf(sensor).adaptive, enable);
+
+    return true;
+  }
+
+  bool Hcsr04Sensor::SetPeriod(std::string_view name, uint32_t periodUs) {
+    return SetPeriod(GetHandle(name), periodUs);
+  }
+
+  bool Hcsr04Sensor::SetPeriod(Handle_t handle, uint32_t periodUs) {
+
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return false;
+
+    VIHCSR04_CoreSetPeriod(&m_bus, &CoreOf(sensor), periodUs);
+
+    return true;
+  }
+
+  bool Hcsr04Sensor::SetEvents(std::string_view name, const EventCfg_t* eventCfg) {
+    return SetEvents(GetHandle(name), eventCfg);
+  }
+
+  bool Hcsr04Sensor::SetEvents(Handle_t handle, const EventCfg_t* eventCfg) {
+
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor || (nullptr != eventCfg && !VIHCSR04_EventCfgValid(eventCfg)))
+      return false;
+
+    VIHCSR04_EventInit(&CoreOf(sensor).event, eventCfg);
+
+    return true;
+  }
+
+  uint32_t Hcsr04Sensor::GetDeadlineMisses(std::string_view name) {
+    return GetDeadlineMisses(GetHandle(name));
+  }
+
+  uint32_t Hcsr04Sensor::GetDeadlineMisses(Handle_t handle) {
+
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return 0;
+
+    return CoreOf(sensor).sched.deadlineMisses;
+  }
+
+  void Hcsr04Sensor::SetGuardInterval(uint32_t guardIntervalUs) {
+    m_bus.guardIntervalUs = guardIntervalUs;
+  }
+
+  float Hcsr04Sensor::MeasureDistance(std::string_view name, 
       float temperature, uint16_t maxDistanceCm) {
+    return MeasureDistance(GetHandle(name), temperature, maxDistanceCm);
+  }
+
+  float Hcsr04Sensor::MeasureDistance(Handle_t handle, 
+      float temperature, uint16_t maxDistanceCm) {
+
+    VIHCSR04_Conversion_t conv;
+    uint32_t durationMicroSec;
+
+    VIHCSR04_ConversionInit(&conv, temperature, maxDistanceCm);
 
-    if (!m_isInitialized || name.empty() ||
-        !m_sensors.contains(name))
+    if (!MeasureSync(handle, conv, durationMicroSec))
       return -1;
 
-    
-    Sensor_t tmpSensor = m_sensors[name];
-    Sensor_t& currSensor = m_sensors[name];
+    return VIHCSR04_ToCm(&conv, durationMicroSec);
+  }
+
+  uint32_t Hcsr04Sensor::MeasureDistanceMm(Handle_t handle, 
+      float temperature, uint16_t maxDistanceCm) {
+
+    VIHCSR04_Conversion_t conv;
+    uint32_t durationMicroSec;
+
+    VIHCSR04_ConversionInit(&conv, temperature, maxDistanceCm);
+
+    if (!MeasureSync(handle, conv, durationMicroSec))
+      return INVALID_DISTANCE_MM;
 
-    currSensor.temperature = temperature;
-    currSensor.maxDistanceCm = maxDistanceCm;
-    currSensor.enabled = true;
+    return VIHCSR04_ToMm(&conv, durationMicroSec);
+  }
 
-    float res = currSensor.Runtime(m_pulseInCb, m_triggerPortCb, 
-      m_printfCb, m_debugLvl);
+  bool Hcsr04Sensor::MeasureSync(Handle_t handle, 
+      const VIHCSR04_Conversion_t& conv, uint32_t& durationMicroSec) {
 
-    m_sensors[name] = tmpSensor;
+    Sensor_t* sensor = GetSensor(handle);
 
-    return res;
+    return nullptr != sensor && 
+      VIHCSR04_CoreMeasureSync(&m_bus, &CoreOf(sensor), &conv, &durationMicroSec);
   }
 
   void Hcsr04Sensor::Runtime(void) {
-    if(!m_isInitialized || m_sensorsPtr.empty())
+    if (m_isInitialized)
+      VIHCSR04_CoreRuntime(&m_bus);
+  }
+
+  uint64_t Hcsr04Sensor::RuntimeUntil(uint32_t budgetUs) {
+
+    if (nullptr == m_bus.getTimeUsCb) {
+      Runtime();
+      return NextAction(0);
+    }
+
+    uint64_t start = m_bus.getTimeUsCb();
+    uint64_t now = start;
+    uint64_t next = NextAction(now);
+
+    // steps are started only while budget lasts, the last one can exceed it
+    while (next == now && now - start < budgetUs) {
+      Runtime();
+      now = m_bus.getTimeUsCb();
+      next = NextAction(now);
+    }
+
+    return next;
+  }
+
+  uint64_t Hcsr04Sensor::NextAction(uint64_t now) const {
+
+    if (!m_isInitialized)
+      return NO_DEADLINE;
+
+    return VIHCSR04_CoreNextAction(&m_bus, now);
+  }
+
+  void Hcsr04Sensor::EchoEdge(const void* echoPort, uint16_t echoPin, 
+    uint8_t level, uint64_t timeUs) {
+
+    if (!m_isInitialized || !m_bus.edgeDriven)
+      return;
+
+    for (size_t i = 0; i < m_sensors.size(); i++) {
+      if (!m_sensors[i].used || m_cores[i].echoPort != echoPort || 
+          m_cores[i].echoPin != echoPin)
+        continue;
+
+      EchoEdge(MakeHandle(i), level, timeUs);
+      return;
+    }
+  }
+
+  void Hcsr04Sensor::EchoEdge(Handle_t handle, uint8_t level, uint64_t timeUs) {
+
+    if (!m_bus.edgeDriven)
       return;
 
-    auto currSensor = m_sensorsPtr[m_currentSnsr];
+    Sensor_t* sensor = GetSensor(handle);
 
-    if(!currSensor)
+    if (nullptr == sensor)
       return;
 
-    currSensor->Runtime(m_pulseInCb, m_triggerPortCb, 
-      m_printfCb, m_debugLvl);
+    VIHCSR04_CoreEchoEdge(&CoreOf(sensor), level, timeUs);
+  }
+
+  Handle_t Hcsr04Sensor::MakeHandle(uint32_t index) {
+    // generation 0 is never used, so a valid handle is never equal to INVALID_HANDLE
+    if (0 == m_sensors[index].generation)
+      m_sensors[index].generation = 1;
+
+    return ((Handle_t)m_sensors[index].generation << 16) | index;
+  }
+
+  VIHCSR04_Core_t& Hcsr04Sensor::CoreOf(const Sensor_t* sensor) {
+    return m_cores[sensor - m_sensors.data()];
+  }
+
+  Hcsr04Sensor::Sensor_t* Hcsr04Sensor::GetSensor(Handle_t handle) {
+    uint32_t index = handle & 0xFFFF;
+
+    if (!m_isInitialized || index >= m_sensors.size())
+      return nullptr;
+
+    Sensor_t* sensor = &m_sensors[index];
+
+    if (!sensor->used || sensor->generation != (handle >> 16))
+      return nullptr;
+
+    return sensor;
+  }
+
+  bool Hcsr04Sensor::SetSampleBuffer(size_t capacity) {
+    return m_samples.Resize(capacity);
+  }
+
+  size_t Hcsr04Sensor::DrainSamples(Sample_t* samples, size_t maxSamples) {
+
+    if (nullptr == samples)
+      return 0;
+
+    return m_samples.Drain(samples, maxSamples);
+  }
+
+  uint32_t Hcsr04Sensor::GetSampleOverflows(void) const {
+    return m_samples.Overflows();
+  }
+
+  bool Hcsr04Sensor::SetLogBuffer(size_t capacity) {
+    return m_log.Resize(capacity);
+  }
+
+  size_t Hcsr04Sensor::DrainLog(LogRecord_t* records, size_t maxRecords) {
+
+    if (nullptr == records)
+      return 0;
+
+    return m_log.Drain(records, maxRecords);
+  }
 
-    m_currentSnsr++;
+  size_t Hcsr04Sensor::PrintLog(size_t maxRecords) {
 
-    if(m_currentSnsr >= m_sensorsPtr.size()) {
-      m_currentSnsr = 0;
+    if (nullptr == m_bus.printfCb)
+      return 0;
+
+    LogRecord_t record;
+    char line[VIHCSR04_LOG_LINE_LEN];
+    size_t count = 0;
+
+    while (count < maxRecords && 0 < m_log.Drain(&record, 1)) {
+      const Sensor_t* sensor = GetSensor(record.handle);
+
+      VIHCSR04_FormatLog(&record, sensor ? sensor->name.c_str() : nullptr, line, sizeof(line));
+      m_bus.printfCb("%s", line);
+      count++;
     }
+
+    return count;
+  }
+
+  uint32_t Hcsr04Sensor::GetLogOverflows(void) const {
+    return m_log.Overflows();
+  }
+
+  bool Hcsr04Sensor::SetTimeCb(GetTimeUs_t getTimeUsCb) {
+
+    // edge driven mode can't work without time source
+    if (m_bus.edgeDriven && nullptr == getTimeUsCb)
+      return false;
+
+    m_bus.getTimeUsCb = getTimeUsCb;
+
+    return true;
+  }
+
+  GetTimeUs_t Hcsr04Sensor::GetTimeCb(void) const {
+    return m_bus.getTimeUsCb;
+  }
+
+  void Hcsr04Sensor::SetTriggerMaskCb(TriggerMask_t triggerMaskCb) {
+    m_bus.triggerMaskCb = triggerMaskCb;
+  }
+
+  bool Hcsr04Sensor::GetStats(std::string_view name, Stats_t& stats) {
+    return GetStats(GetHandle(name), stats);
+  }
+
+  bool Hcsr04Sensor::GetStats(Handle_t handle, Stats_t& stats) {
+#if VIHCSR04_STATS
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return false;
+
+    VIHCSR04_StatsSnapshot(&CoreOf(sensor).stats, &stats, nullptr != m_bus.getTimeUsCb, 
+      VIHCSR04_CoreNow(&m_bus));
+
+    return true;
+#else
+    (void)handle;
+    (void)stats;
+    return false;
+#endif
+  }
+
+  bool Hcsr04Sensor::ResetStats(std::string_view name) {
+    return ResetStats(GetHandle(name));
+  }
+
+  bool Hcsr04Sensor::ResetStats(Handle_t handle) {
+#if VIHCSR04_STATS
+    Sensor_t* sensor = GetSensor(handle);
+
+    if (nullptr == sensor)
+      return false;
+
+    VIHCSR04_StatsReset(&CoreOf(sensor).stats);
+
+    return true;
+#else
+    (void)handle;
+    return false;
+#endif
   }
 
   void Hcsr04Sensor::SetPrintfCb(const Printf_t printfCb) {
-    m_printfCb = printfCb;
+    m_bus.printfCb = printfCb;
   }
 
   void Hcsr04Sensor::SetDebugLvl(const DebugLvl_t lvl) {
-    m_debugLvl = lvl;
+    m_bus.debugLvl = (VIHCSR04_DebugLvl_t)lvl;
+  }
+
+  void Hcsr04Sensor::SetPublisher(VIHCSR04_ShmSegment_t* segment) {
+
+    m_publisher = segment;
+
+    if (nullptr == segment)
+      return;
+
+    // readers have to find existing sensors
+    for (size_t i = 0; i < m_sensors.size(); i++) {
+      if (m_sensors[i].used)
+        VIHCSR04_ShmAssign(segment, i, MakeHandle(i), m_sensors[i].name.c_str());
+    }
   }
 
 }
@@ -0,0 +1,239 @@
+/**
+ * @file vihcsr04_batch.c
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Batch echo duration to distance conversion of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#include "vihcsr04_batch.h"
+
+#if VIHCSR04_BATCH_SIMD && (defined(__x86_64__) || defined(__i386__)) && \
+  (defined(__GNUC__) || defined(__clang__))
+  #define VIHCSR04_BATCH_X86 1
+  #include <immintrin.h>
+#elif VIHCSR04_BATCH_SIMD && defined(__ARM_NEON)
+  #define VIHCSR04_BATCH_NEON 1
+  #include <arm_neon.h>
+#endif
+
+// fields of conversion are gathered as 32 bit words
+_Static_assert(0 == sizeof(VIHCSR04_Conversion_t) % 4, 
+  "size of VIHCSR04_Conversion_t has to be a multiple of 4");
+
+static void ToMmScalar(const VIHCSR04_Conversion_t* conv, 
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  for(size_t i = 0; i < count; i++)
+    distancesMm[i] = VIHCSR04_ToMm(conv, durationsUs[i]);
+}
+
+static void ToMmIndexedScalar(const VIHCSR04_Conversion_t* convs, const uint16_t* convIndex,
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  for(size_t i = 0; i < count; i++)
+    distancesMm[i] = VIHCSR04_ToMm(&convs[convIndex[i]], durationsUs[i]);
+}
+
+#if VIHCSR04_BATCH_X86
+
+/*
+ * Every kernel computes the same 32 bit arithmetic as VIHCSR04_ToMm:
+ *   mm = (d >> 16) * q + (((d & 0xFFFF) * q + 0x8000) >> 16)
+ * and replaces results with VIHCSR04_INVALID_DISTANCE_MM 
+ * if d == 0, d > maxEchoUs, mm == 0 or mm > maxDistanceCm * 10.
+ * Unsigned a <= b is checked as min(a, b) == a.
+ */
+
+__attribute__((target("sse4.1")))
+static inline __m128i ToMmSse(__m128i d, __m128i q, __m128i maxEcho, __m128i maxMm) {
+
+  const __m128i zero = _mm_setzero_si128();
+  __m128i mm = _mm_add_epi32(
+    _mm_mullo_epi32(_mm_srli_epi32(d, 16), q),
+    _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(_mm_and_si128(d, _mm_set1_epi32(0xFFFF)), q), 
+      _mm_set1_epi32(0x8000)), 16));
+
+  __m128i valid = _mm_andnot_si128(_mm_cmpeq_epi32(d, zero), 
+    _mm_cmpeq_epi32(_mm_min_epu32(d, maxEcho), d));
+  valid = _mm_andnot_si128(_mm_cmpeq_epi32(mm, zero), valid);
+  valid = _mm_and_si128(valid, _mm_cmpeq_epi32(_mm_min_epu32(mm, maxMm), mm));
+
+  // invalid lanes become all ones, which is VIHCSR04_INVALID_DISTANCE_MM
+  return _mm_or_si128(mm, _mm_xor_si128(valid, _mm_set1_epi32(-1)));
+}
+
+__attribute__((target("sse4.1")))
+static void ToMmSse41(const VIHCSR04_Conversion_t* conv, 
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  const __m128i q = _mm_set1_epi32((int32_t)conv->mmPerUsQ16);
+  const __m128i maxEcho = _mm_set1_epi32((int32_t)conv->maxEchoUs);
+  const __m128i maxMm = _mm_set1_epi32((int32_t)conv->maxDistanceCm * 10);
+  size_t i = 0;
+
+  for(; i + 4 <= count; i += 4) {
+    __m128i d = _mm_loadu_si128((const __m128i*)&durationsUs[i]);
+    _mm_storeu_si128((__m128i*)&distancesMm[i], ToMmSse(d, q, maxEcho, maxMm));
+  }
+
+  ToMmScalar(conv, &durationsUs[i], &distancesMm[i], count - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ToMmAvx(__m256i d, __m256i q, __m256i maxEcho, __m256i maxMm) {
+
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i mm = _mm256_add_epi32(
+    _mm256_mullo_epi32(_mm256_srli_epi32(d, 16), q),
+    _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_and_si256(d, _mm256_set1_epi32(0xFFFF)), q), 
+      _mm256_set1_epi32(0x8000)), 16));
+
+  __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(d, zero), 
+    _mm256_cmpeq_epi32(_mm256_min_epu32(d, maxEcho), d));
+  valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(mm, zero), valid);
+  valid = _mm256_and_si256(valid, _mm256_cmpeq_epi32(_mm256_min_epu32(mm, maxMm), mm));
+
+  // invalid lanes become all ones, which is VIHCSR04_INVALID_DISTANCE_MM
+  return _mm256_or_si256(mm, _mm256_xor_si256(valid, _mm256_set1_epi32(-1)));
+}
+
+__attribute__((target("avx2")))
+static void ToMmAvx2(const VIHCSR04_Conversion_t* conv, 
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  const __m256i q = _mm256_set1_epi32((int32_t)conv->mmPerUsQ16);
+  const __m256i maxEcho = _mm256_set1_epi32((int32_t)conv->maxEchoUs);
+  const __m256i maxMm = _mm256_set1_epi32((int32_t)conv->maxDistanceCm * 10);
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8) {
+    __m256i d = _mm256_loadu_si256((const __m256i*)&durationsUs[i]);
+    _mm256_storeu_si256((__m256i*)&distancesMm[i], ToMmAvx(d, q, maxEcho, maxMm));
+  }
+
+  ToMmScalar(conv, &durationsUs[i], &distancesMm[i], count - i);
+}
+
+__attribute__((target("avx2")))
+static void ToMmIndexedAvx2(const VIHCSR04_Conversion_t* convs, const uint16_t* convIndex,
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  // conversion fields are gathered as 32 bit words: index * words per conversion
+  const __m256i stride = _mm256_set1_epi32(sizeof(VIHCSR04_Conversion_t) / 4);
+  const int* qBase = (const int*)&convs->mmPerUsQ16;
+  const int* maxEchoBase = (const int*)&convs->maxEchoUs;
+  // 16 bit maxDistanceCm is followed by padding inside of conversion
+  const int* maxCmBase = (const int*)&convs->maxDistanceCm;
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8) {
+    __m256i idx = _mm256_mullo_epi32(_mm256_cvtepu16_epi32(
+      _mm_loadu_si128((const __m128i*)&convIndex[i])), stride);
+    __m256i q = _mm256_i32gather_epi32(qBase, idx, 4);
+    __m256i maxEcho = _mm256_i32gather_epi32(maxEchoBase, idx, 4);
+    __m256i maxMm = _mm256_mullo_epi32(_mm256_and_si256(
+      _mm256_i32gather_epi32(maxCmBase, idx, 4), _mm256_set1_epi32(0xFFFF)), _mm256_set1_epi32(10));
+    __m256i d = _mm256_loadu_si256((const __m256i*)&durationsUs[i]);
+    _mm256_storeu_si256((__m256i*)&distancesMm[i], ToMmAvx(d, q, maxEcho, maxMm));
+  }
+
+  ToMmIndexedScalar(convs, &convIndex[i], &durationsUs[i], &distancesMm[i], count - i);
+}
+
+#endif // VIHCSR04_BATCH_X86
+
+#if VIHCSR04_BATCH_NEON
+
+static void ToMmNeon(const VIHCSR04_Conversion_t* conv, 
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  const uint32x4_t q = vdupq_n_u32(conv->mmPerUsQ16);
+  const uint32x4_t maxEcho = vdupq_n_u32(conv->maxEchoUs);
+  const uint32x4_t maxMm = vdupq_n_u32((uint32_t)conv->maxDistanceCm * 10);
+  const uint32x4_t zero = vdupq_n_u32(0);
+  size_t i = 0;
+
+  // same 32 bit arithmetic as VIHCSR04_ToMm
+  for(; i + 4 <= count; i += 4) {
+    uint32x4_t d = vld1q_u32(&durationsUs[i]);
+    uint32x4_t mm = vaddq_u32(vmulq_u32(vshrq_n_u32(d, 16), q),
+      vshrq_n_u32(vaddq_u32(vmulq_u32(vandq_u32(d, vdupq_n_u32(0xFFFF)), q), 
+        vdupq_n_u32(0x8000)), 16));
+
+    uint32x4_t valid = vandq_u32(vmvnq_u32(vceqq_u32(d, zero)), vcleq_u32(d, maxEcho));
+    valid = vandq_u32(valid, vmvnq_u32(vceqq_u32(mm, zero)));
+    valid = vandq_u32(valid, vcleq_u32(mm, maxMm));
+
+    // invalid lanes become all ones, which is VIHCSR04_INVALID_DISTANCE_MM
+    vst1q_u32(&distancesMm[i], vorrq_u32(mm, vmvnq_u32(valid)));
+  }
+
+  ToMmScalar(conv, &durationsUs[i], &distancesMm[i], count - i);
+}
+
+#endif // VIHCSR04_BATCH_NEON
+
+void VIHCSR04_ToMmBatch(const VIHCSR04_Conversion_t* conv, 
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  if(NULL == conv || NULL == durationsUs || NULL == distancesMm)
+    return;
+
+#if VIHCSR04_BATCH_X86
+  if(__builtin_cpu_supports("avx2"))
+    ToMmAvx2(conv, durationsUs, distancesMm, count);
+  else if(__builtin_cpu_supports("sse4.1"))
+    ToMmSse41(conv, durationsUs, distancesMm, count);
+  else
+    ToMmScalar(conv, durationsUs, distancesMm, count);
+#elif VIHCSR04_BATCH_NEON
+  ToMmNeon(conv, durationsUs, distancesMm, count);
+#else
+  ToMmScalar(conv, durationsUs, distancesMm, count);
+#endif
+}
+
+void VIHCSR04_ToMmBatchIndexed(const VIHCSR04_Conversion_t* convs, const uint16_t* convIndex,
+  const uint32_t* durationsUs, uint32_t* distancesMm, size_t count) {
+
+  if(NULL == convs || NULL == convIndex || NULL == durationsUs || NULL == distancesMm)
+    return;
+
+  // without gather instructions loading of conversions dominates, scalar kernel is used
+#if VIHCSR04_BATCH_X86
+  if(__builtin_cpu_supports("avx2"))
+    ToMmIndexedAvx2(convs, convIndex, durationsUs, distancesMm, count);
+  else
+    ToMmIndexedScalar(convs, convIndex, durationsUs, distancesMm, count);
+#else
+  ToMmIndexedScalar(convs, convIndex, durationsUs, distancesMm, count);
+#endif
+}
+
+const char* VIHCSR04_BatchKernel(void) {
+#if VIHCSR04_BATCH_X86
+  if(__builtin_cpu_supports("avx2"))
+    return "avx2";
+  if(__builtin_cpu_supports("sse4.1"))
+    return "sse4.1";
+  return "scalar";
+#elif VIHCSR04_BATCH_NEON
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
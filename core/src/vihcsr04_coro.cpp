@@ -0,0 +1,136 @@
+/**
+ * @file vihcsr04_coro.cpp
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Coroutine API of HC-SR04 ultrasonic distance sensor control driver (c++ realisation)
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#include "vihcsr04_coro.hpp"
+
+namespace vihcsr04 {
+
+  bool Hcsr04Coro::MeasureOp::await_suspend(std::coroutine_handle<> coro) {
+
+    m_coro = coro;
+
+    // callback of a stream must not be replaced
+    auto stream = m_drv.m_streams.find(m_handle);
+    if (stream != m_drv.m_streams.end() && nullptr != stream->second)
+      return false;
+
+    // join measurement which is already running on this sensor
+    auto pending = m_drv.m_pending.find(m_handle);
+    if (pending != m_drv.m_pending.end()) {
+      m_next = pending->second->m_next;
+      pending->second->m_next = this;
+      return true;
+    }
+
+    if (!m_drv.m_sensor.MeasureDistanceMmAsync(m_handle, ONESHOT_MEASURE, 
+        m_temperature, m_maxDistanceCm, Done, this))
+      return false;
+
+    m_drv.m_pending.emplace(m_handle, this);
+
+    return true;
+  }
+
+  void Hcsr04Coro::MeasureOp::Done(uint32_t distanceMm, const void* context) {
+
+    MeasureOp* op = static_cast<MeasureOp*>(const_cast<void*>(context));
+
+    op->m_drv.m_pending.erase(op->m_handle);
+
+    for (; nullptr != op; op = op->m_next) {
+      op->m_distanceMm = distanceMm;
+      op->m_drv.m_ready.push_back(op->m_coro);
+    }
+  }
+
+  uint32_t Hcsr04Coro::Stream::NextOp::await_resume() noexcept {
+
+    if (m_stream.m_values.empty())
+      return INVALID_DISTANCE_MM;
+
+    uint32_t distanceMm = m_stream.m_values.front();
+    m_stream.m_values.pop_front();
+
+    return distanceMm;
+  }
+
+  Hcsr04Coro::Stream::Stream(Hcsr04Coro& drv, Handle_t handle, 
+      float temperature, uint16_t maxDistanceCm) : m_drv(drv), m_handle(handle) {
+
+    if (m_drv.m_pending.contains(m_handle))
+      return;
+
+    // slot of the sensor is reused, so callback context of earlier streams stays valid
+    Stream*& slot = m_drv.m_streams[m_handle];
+    if (nullptr != slot)
+      return;
+
+    m_valid = m_drv.m_sensor.MeasureDistanceMmAsync(m_handle, CONTINUOUS_MEASURE, 
+      temperature, maxDistanceCm, Done, &slot);
+
+    if (m_valid)
+      slot = this;
+  }
+
+  Hcsr04Coro::Stream::~Stream() {
+
+    if (!m_valid)
+      return;
+
+    m_drv.m_sensor.StopContinuousMeasure(m_handle);
+    // a running ping still completes, its result is dropped by Done
+    m_drv.m_streams[m_handle] = nullptr;
+  }
+
+  void Hcsr04Coro::Stream::Done(uint32_t distanceMm, const void* context) {
+
+    Stream* stream = *static_cast<Stream* const*>(context);
+
+    if (nullptr == stream)
+      return;
+
+    if (stream->m_values.size() >= MAX_QUEUED)
+      stream->m_values.pop_front();
+
+    stream->m_values.push_back(distanceMm);
+
+    if (stream->m_waiter) {
+      stream->m_drv.m_ready.push_back(stream->m_waiter);
+      stream->m_waiter = nullptr;
+    }
+  }
+
+  size_t Hcsr04Coro::Poll(void) {
+
+    m_sensor.Runtime();
+
+    // resumed coroutines can start new measurements, they are resumed by next Poll
+    m_resuming.swap(m_ready);
+
+    for (auto coro : m_resuming)
+      coro.resume();
+
+    size_t resumed = m_resuming.size();
+    m_resuming.clear();
+
+    return resumed;
+  }
+}
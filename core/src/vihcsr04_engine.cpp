@@ -0,0 +1,235 @@
+/**
+ * @file vihcsr04_engine.cpp
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Multithreaded measurement engine of HC-SR04 ultrasonic distance sensor control driver (c++ realisation)
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#include "vihcsr04_engine.hpp"
+
+namespace vihcsr04 {
+
+  Hcsr04Engine::~Hcsr04Engine() {
+    Stop();
+  }
+
+  Hcsr04Engine::BusId_t Hcsr04Engine::AddBus(PulseIn_t pulseInCb, 
+      TriggerPort_t triggerPortCb, size_t sampleCapacity, 
+      std::chrono::microseconds period) {
+    return AddBus(std::make_unique<Bus_t>(period, pulseInCb, triggerPortCb), 
+      sampleCapacity);
+  }
+
+  Hcsr04Engine::BusId_t Hcsr04Engine::AddBus(TriggerPort_t triggerPortCb, 
+      GetTimeUs_t getTimeUsCb, size_t sampleCapacity, 
+      std::chrono::microseconds period, size_t maxSensors) {
+    return AddBus(std::make_unique<Bus_t>(period, triggerPortCb, getTimeUsCb, maxSensors), 
+      sampleCapacity);
+  }
+
+  Hcsr04Engine::BusId_t Hcsr04Engine::AddBus(std::unique_ptr<Bus_t> bus, 
+      size_t sampleCapacity) {
+
+    if (m_running || !bus->sensor.SetSampleBuffer(sampleCapacity) || 
+        !bus->edges.Resize(EDGE_CAPACITY))
+      return INVALID_BUS;
+
+    m_buses.push_back(std::move(bus));
+
+    return m_buses.size() - 1;
+  }
+
+  bool Hcsr04Engine::Start(void) {
+
+    if (m_running || m_buses.empty())
+      return false;
+
+    // commands are queued from now on
+    m_running = true;
+
+    for (auto& bus : m_buses)
+      bus->worker = std::jthread(Worker, std::ref(*bus));
+
+    return true;
+  }
+
+  void Hcsr04Engine::Stop(void) {
+
+    if (!m_running)
+      return;
+
+    for (auto& bus : m_buses) {
+      bus->worker.request_stop();
+      bus->worker.join();
+    }
+
+    m_running = false;
+
+    for (auto& bus : m_buses) {
+      ExecuteCommands(*bus);
+      ApplyEdges(*bus);
+    }
+  }
+
+  std::future<Handle_t> Hcsr04Engine::AddSensor(BusId_t bus, const std::string& name, 
+      const void* triggerPort, uint16_t triggerPin, 
+      const void* echoPort, uint16_t echoPin) {
+    return Execute(bus, [=](Hcsr04Sensor& sensor) {
+      return sensor.AddSensor(name, triggerPort, triggerPin, echoPort, echoPin);
+    });
+  }
+
+  std::future<bool> Hcsr04Engine::DeleteSensor(BusId_t bus, Handle_t handle) {
+    return Execute(bus, [=](Hcsr04Sensor& sensor) {
+      return sensor.DeleteSensor(handle);
+    });
+  }
+
+  std::future<bool> Hcsr04Engine::MeasureDistanceMmAsync(BusId_t bus, Handle_t handle, 
+      const MeasureMode_t mode, float temperature, uint16_t maxDistanceCm,
+      const DistanceMm_t distanceMesuredCb, const void* context) {
+    return Execute(bus, [=](Hcsr04Sensor& sensor) {
+      return sensor.MeasureDistanceMmAsync(handle, mode, temperature, 
+        maxDistanceCm, distanceMesuredCb, context);
+    });
+  }
+
+  std::future<void> Hcsr04Engine::StopContinuousMeasure(BusId_t bus, Handle_t handle) {
+    return Execute(bus, [=](Hcsr04Sensor& sensor) {
+      sensor.StopContinuousMeasure(handle);
+    });
+  }
+
+  void Hcsr04Engine::EchoEdge(BusId_t bus, Handle_t handle, 
+      uint8_t level, uint64_t timeUs) {
+
+    if (bus >= m_buses.size())
+      return;
+
+    // sensors are changed only by the worker, it applies the edge before the next runtime call
+    m_buses[bus]->edges.Push(Edge_t{
+      .handle = handle,
+      .level = level,
+      .timeUs = timeUs
+    });
+
+    // result is ready, worker must not sleep until the echo timeout
+    if (0 == level) {
+      m_buses[bus]->edge.store(true, std::memory_order_release);
+      m_buses[bus]->wakeup.notify_one();
+    }
+  }
+
+  size_t Hcsr04Engine::DrainSamples(BusId_t bus, Sample_t* samples, size_t maxSamples) {
+
+    if (bus >= m_buses.size())
+      return 0;
+
+    return m_buses[bus]->sensor.DrainSamples(samples, maxSamples);
+  }
+
+  uint32_t Hcsr04Engine::GetSampleOverflows(BusId_t bus) const {
+
+    if (bus >= m_buses.size())
+      return 0;
+
+    return m_buses[bus]->sensor.GetSampleOverflows();
+  }
+
+  void Hcsr04Engine::Post(Bus_t& bus, Command_t command) {
+
+    {
+      std::unique_lock<std::mutex> lock(bus.mutex);
+
+      if (m_running) {
+        bus.commands.push_back(std::move(command));
+        bus.pending.store(true, std::memory_order_release);
+        lock.unlock();
+        bus.wakeup.notify_one();
+        return;
+      }
+    }
+
+    // no worker is running, the caller owns the bus
+    command(bus.sensor);
+  }
+
+  void Hcsr04Engine::ExecuteCommands(Bus_t& bus) {
+
+    {
+      std::lock_guard<std::mutex> lock(bus.mutex);
+      bus.executing.swap(bus.commands);
+      bus.pending.store(false, std::memory_order_relaxed);
+    }
+
+    for (auto& command : bus.executing)
+      command(bus.sensor);
+
+    bus.executing.clear();
+  }
+
+  void Hcsr04Engine::Worker(std::stop_token stop, Bus_t& bus) {
+
+    while (!stop.stop_requested()) {
+      // bus lock is taken only if commands are pending
+      if (bus.pending.load(std::memory_order_acquire))
+        ExecuteCommands(bus);
+
+      ApplyEdges(bus);
+
+      if (bus.period.count() > 0) {
+        bus.sensor.Runtime();
+        std::this_thread::sleep_for(bus.period);
+      } else {
+        Idle(stop, bus, bus.sensor.RuntimeUntil(RUNTIME_BUDGET_US));
+      }
+    }
+  }
+
+  void Hcsr04Engine::ApplyEdges(Bus_t& bus) {
+
+    Edge_t edge;
+
+    while (0 < bus.edges.Drain(&edge, 1))
+      bus.sensor.EchoEdge(edge.handle, edge.level, edge.timeUs);
+  }
+
+  void Hcsr04Engine::Idle(std::stop_token stop, Bus_t& bus, uint64_t next) {
+
+    // time source can be set by command (SetTimeCb), without it next action is always now
+    GetTimeUs_t getTimeUsCb = bus.sensor.GetTimeCb();
+    uint64_t now = (nullptr != getTimeUsCb && NO_DEADLINE != next) ? 
+      getTimeUsCb() : next;
+
+    if (NO_DEADLINE != next && (int64_t)(next - now) <= 0) {
+      std::this_thread::yield();
+      return;
+    }
+
+    auto woken = [&bus] {
+      return bus.pending.load(std::memory_order_acquire) || 
+        bus.edge.exchange(false, std::memory_order_acquire);
+    };
+
+    std::unique_lock<std::mutex> lock(bus.mutex);
+
+    if (NO_DEADLINE == next)
+      bus.wakeup.wait(lock, stop, woken);
+    else
+      bus.wakeup.wait_for(lock, stop, std::chrono::microseconds(next - now), woken);
+  }
+}
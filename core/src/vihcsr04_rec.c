@@ -0,0 +1,116 @@
+/**
+ * @file vihcsr04_rec.c
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Recorder of measurement streams of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#include "vihcsr04_rec.h"
+#include <stdatomic.h>
+
+_Static_assert(sizeof(VIHCSR04_RecHeader_t) == 16 && sizeof(VIHCSR04_RecRecord_t) == 16, 
+  "recording format requires records of 16 bytes");
+
+bool VIHCSR04_RecInit(VIHCSR04_Recorder_t* recorder, 
+  VIHCSR04_RecRecord_t* buffer, uint32_t capacity, 
+  VIHCSR04_RecWrite_t writeCb, const void* context) {
+
+  if(NULL == recorder || NULL == buffer || NULL == writeCb)
+    return false;
+
+  if(0 == capacity || 0 != (capacity & (capacity - 1)))
+    return false;
+
+  recorder->buffer = buffer;
+  recorder->mask = capacity - 1;
+  atomic_store_explicit(&recorder->head, 0, memory_order_relaxed);
+  atomic_store_explicit(&recorder->tail, 0, memory_order_relaxed);
+  atomic_store_explicit(&recorder->overflows, 0, memory_order_relaxed);
+  recorder->writeCb = writeCb;
+  recorder->context = context;
+  recorder->headerWritten = false;
+
+  return true;
+}
+
+void VIHCSR04_RecPut(VIHCSR04_Recorder_t* recorder, VIHCSR04_RecType_t type, 
+  uint16_t sensor, uint64_t timestampUs, uint32_t value) {
+
+  uint32_t head = atomic_load_explicit(&recorder->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&recorder->tail, memory_order_acquire);
+
+  if(head - tail > recorder->mask) {
+    // only producer changes overflows, load and store is enough
+    atomic_store_explicit(&recorder->overflows, 
+      atomic_load_explicit(&recorder->overflows, memory_order_relaxed) + 1, 
+      memory_order_relaxed);
+    return;
+  }
+
+  VIHCSR04_RecRecord_t* record = &recorder->buffer[head & recorder->mask];
+
+  record->timestampUs = timestampUs;
+  record->value = value;
+  record->sensor = sensor;
+  record->type = (uint8_t)type;
+  record->reserved = 0;
+
+  atomic_store_explicit(&recorder->head, head + 1, memory_order_release);
+}
+
+uint32_t VIHCSR04_RecFlush(VIHCSR04_Recorder_t* recorder) {
+
+  if(!recorder->headerWritten) {
+    VIHCSR04_RecHeader_t header = {
+      .magic = VIHCSR04_REC_MAGIC,
+      .version = VIHCSR04_REC_VERSION,
+      .recordSize = sizeof(VIHCSR04_RecRecord_t),
+      .reserved = {0, 0}
+    };
+    if(sizeof(header) != recorder->writeCb(&header, sizeof(header), recorder->context))
+      return 0;
+    recorder->headerWritten = true;
+  }
+
+  uint32_t tail = atomic_load_explicit(&recorder->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&recorder->head, memory_order_acquire);
+  uint32_t written = 0;
+
+  // stored records are contiguous or wrapped around the end of buffer, two writes at most
+  while(written < head - tail) {
+    uint32_t index = (tail + written) & recorder->mask;
+    uint32_t count = head - tail - written;
+
+    if(count > recorder->mask + 1 - index)
+      count = recorder->mask + 1 - index;
+
+    size_t size = count * sizeof(VIHCSR04_RecRecord_t);
+
+    if(size != recorder->writeCb(&recorder->buffer[index], size, recorder->context))
+      break;
+
+    written += count;
+  }
+
+  atomic_store_explicit(&recorder->tail, tail + written, memory_order_release);
+
+  return written;
+}
+
+uint32_t VIHCSR04_RecGetOverflows(VIHCSR04_Recorder_t* recorder) {
+  return atomic_load_explicit(&recorder->overflows, memory_order_relaxed);
+}
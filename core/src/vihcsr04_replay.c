@@ -0,0 +1,181 @@
+/**
+ * @file vihcsr04_replay.c
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Replay of recorded measurement streams of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#include "vihcsr04_rec.h"
+#include "string.h"
+
+/**
+ * @brief Replayed sensor
+ * 
+ */
+typedef struct {
+  bool recorded;                                 /*!< sensor record is found */
+  uint16_t echoPin;                              /*!< recorded echo pin */
+  bool configured;                               /*!< temperature and range are recorded */
+  float temperature;                             /*!< recorded temperature */
+  uint16_t maxDistanceCm;                        /*!< recorded max distance */
+  uint64_t cursor;                               /*!< index of next record to replay */
+} ReplaySensor_t;
+
+/**
+ * @brief Replay state
+ * 
+ */
+static struct {
+  const VIHCSR04_RecRecord_t* records;           /*!< records of recording */
+  uint64_t number;                               /*!< number of complete records */
+  uint64_t samples;                              /*!< number of samples not replayed yet */
+  uint64_t nowUs;                                /*!< time stamp of the last replayed sample */
+  ReplaySensor_t snsr[VIHCSR04_REPLAY_MAX_SENSORS]; /*!< replayed sensors by recorded slot index */
+} replay;
+
+/**
+ * @brief Apply configuration record to replayed sensor
+ * 
+ * @param sensor Replayed sensor
+ * @param record Record of recording
+ */
+static void Configure(ReplaySensor_t* sensor, const VIHCSR04_RecRecord_t* record) {
+  if(VIHCSR04_REC_TEMPERATURE == record->type) {
+    memcpy(&sensor->temperature, &record->value, sizeof(sensor->temperature));
+    sensor->configured = true;
+  } else if(VIHCSR04_REC_RANGE == record->type) {
+    sensor->maxDistanceCm = (uint16_t)record->value;
+  }
+}
+
+/**
+ * @brief Find replayed sensor by echo pin
+ * 
+ * @param echoPin Echo pin number
+ * @return ReplaySensor_t* found sensor, NULL if not found
+ */
+static ReplaySensor_t* FindSensor(uint16_t echoPin) {
+  for(uint32_t i = 0; i < VIHCSR04_REPLAY_MAX_SENSORS; i++) {
+    if(replay.snsr[i].recorded && replay.snsr[i].echoPin == echoPin)
+      return &replay.snsr[i];
+  }
+  return NULL;
+}
+
+bool VIHCSR04_ReplayOpen(const void* data, size_t size) {
+  memset(&replay, 0, sizeof(replay));
+
+  if(NULL == data || size < sizeof(VIHCSR04_RecHeader_t))
+    return false;
+
+  const VIHCSR04_RecHeader_t* header = (const VIHCSR04_RecHeader_t*)data;
+
+  if(VIHCSR04_REC_MAGIC != header->magic || VIHCSR04_REC_VERSION != header->version || 
+     sizeof(VIHCSR04_RecRecord_t) != header->recordSize)
+    return false;
+
+  replay.records = (const VIHCSR04_RecRecord_t*)(header + 1);
+  // a truncated last record is ignored
+  replay.number = (size - sizeof(*header)) / sizeof(VIHCSR04_RecRecord_t);
+
+  // sensors and their first configuration
+  for(uint64_t i = 0; i < replay.number; i++) {
+    const VIHCSR04_RecRecord_t* record = &replay.records[i];
+
+    if(VIHCSR04_REC_SAMPLE == record->type)
+      replay.samples++;
+
+    if(record->sensor >= VIHCSR04_REPLAY_MAX_SENSORS)
+      continue;
+
+    ReplaySensor_t* sensor = &replay.snsr[record->sensor];
+
+    if(VIHCSR04_REC_SENSOR == record->type && !sensor->recorded) {
+      sensor->recorded = true;
+      sensor->echoPin = (uint16_t)record->value;
+    } else if((VIHCSR04_REC_TEMPERATURE == record->type && !sensor->configured) || 
+      (VIHCSR04_REC_RANGE == record->type && 0 == sensor->maxDistanceCm)) {
+      Configure(sensor, record);
+    }
+  }
+
+  return true;
+}
+
+bool VIHCSR04_ReplayGetConfig(uint16_t echoPin, float* temperature, uint16_t* maxDistanceCm) {
+  const ReplaySensor_t* sensor = FindSensor(echoPin);
+
+  if(NULL == sensor || !sensor->configured || NULL == temperature || NULL == maxDistanceCm)
+    return false;
+
+  *temperature = sensor->temperature;
+  *maxDistanceCm = sensor->maxDistanceCm;
+
+  return true;
+}
+
+bool VIHCSR04_ReplayDone(void) {
+  return 0 == replay.samples;
+}
+
+uint64_t VIHCSR04_ReplayGetTimeUs(void) {
+  return replay.nowUs;
+}
+
+uint64_t VIHCSR04_ReplayPulseIn(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t maxDurationTreshold, const void* context) {
+
+  (void)gpio;
+  (void)maxDurationTreshold;
+  (void)context;
+
+  ReplaySensor_t* sensor = FindSensor(port);
+
+  if(NULL == sensor || 1 != state)
+    return 0;
+
+  uint16_t index = (uint16_t)(sensor - replay.snsr);
+
+  // every sensor has its own cursor, records of other sensors are skipped
+  while(sensor->cursor < replay.number) {
+    const VIHCSR04_RecRecord_t* record = &replay.records[sensor->cursor++];
+
+    if(record->sensor != index)
+      continue;
+
+    if(VIHCSR04_REC_SAMPLE != record->type) {
+      Configure(sensor, record);
+      continue;
+    }
+
+    replay.samples--;
+    if(record->timestampUs > replay.nowUs)
+      replay.nowUs = record->timestampUs;
+    return record->value;
+  }
+
+  return 0;
+}
+
+void VIHCSR04_ReplayTrigger(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t pulseDuration, const void* context) {
+  (void)gpio;
+  (void)port;
+  (void)state;
+  (void)pulseDuration;
+  (void)context;
+}
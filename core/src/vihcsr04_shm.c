@@ -0,0 +1,91 @@
+/**
+ * @file vihcsr04_shm.c
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief POSIX shared memory mapping of latest readings of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "vihcsr04_shm.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+VIHCSR04_ShmSegment_t* VIHCSR04_ShmCreate(const char* name, uint32_t sensors) {
+
+  if(NULL == name || 0 == sensors)
+    return NULL;
+
+  size_t size = VIHCSR04_ShmSize(sensors);
+  int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+
+  if(0 > fd)
+    return NULL;
+
+  // the mapping keeps the object alive, descriptor is not needed
+  void* memory = (0 == ftruncate(fd, (off_t)size)) ? 
+    mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+
+  if(MAP_FAILED == memory)
+    return NULL;
+
+  return VIHCSR04_ShmInit(memory, size, sensors);
+}
+
+const VIHCSR04_ShmSegment_t* VIHCSR04_ShmOpen(const char* name) {
+
+  struct stat st;
+
+  if(NULL == name)
+    return NULL;
+
+  int fd = shm_open(name, O_RDONLY, 0);
+
+  if(0 > fd)
+    return NULL;
+
+  void* memory = (0 == fstat(fd, &st) && sizeof(VIHCSR04_ShmHeader_t) <= (size_t)st.st_size) ? 
+    mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+
+  if(MAP_FAILED == memory)
+    return NULL;
+
+  if(!VIHCSR04_ShmValid((const VIHCSR04_ShmSegment_t*)memory, (size_t)st.st_size)) {
+    munmap(memory, (size_t)st.st_size);
+    return NULL;
+  }
+
+  return (const VIHCSR04_ShmSegment_t*)memory;
+}
+
+void VIHCSR04_ShmClose(const VIHCSR04_ShmSegment_t* segment) {
+
+  if(NULL == segment)
+    return;
+
+  munmap((void*)segment, VIHCSR04_ShmSize(((const VIHCSR04_ShmHeader_t*)segment)->sensors));
+}
+
+bool VIHCSR04_ShmUnlink(const char* name) {
+  return NULL != name && 0 == shm_unlink(name);
+}
@@ -0,0 +1,305 @@
+/**
+ * @file vihcsr04_sim.c
+ * @author Ilia Voronin (www.linkedin.com/in/ilia-voronin-7a169122a)
+ * @brief Virtual time echo simulator of HC-SR04 ultrasonic distance sensor control driver
+ *
+ * @copyright Copyright (c) 2024 Ilia Voronin
+ * 
+ * This software is licensed under GNU GENERAL PUBLIC LICENSE 
+ * The terms can be found in the LICENSE file in
+ * the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS,
+ * Without warranty of any kind, express or implied, 
+ * including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose and noninfringement. 
+ * In no event shall the authors or copyright holders be liable for any claim, 
+ * damages or other liability, whether in an action of contract, tort or otherwise, 
+ * arising from, out of or in connection with the software 
+ * or the use or other dealings in the software.
+ * 
+ */
+
+#include "vihcsr04_sim.h"
+#include "string.h"
+
+/**
+ * @brief Simulated sensor
+ * 
+ */
+typedef struct {
+  const void* triggerPort;                       /*!< pointer to GPIO structur of trigger pin */
+  uint16_t triggerPin;                           /*!< trigger pin number */
+  const void* echoPort;                          /*!< pointer to GPIO structur of echo pin */
+  uint16_t echoPin;                              /*!< echo pin number */
+  uint32_t distanceMm;                           /*!< distance to the target */
+  uint32_t noiseMm;                              /*!< amplitude of noise */
+  uint16_t dropoutPermille;                      /*!< probability of lost echo */
+  uint32_t crosstalkMm[VIHCSR04_SIM_MAX_SENSORS];/*!< sound path from this sensor to other sensors, 0 - no crosstalk */
+  uint32_t triggerCount;                         /*!< number of triggers */
+  bool active;                                   /*!< measurement is in progress */
+  bool riseReported;                             /*!< rising edge is reported to edge call-back */
+  uint64_t triggerUs;                            /*!< time of the last trigger */
+  uint64_t riseUs;                               /*!< time of rising edge of echo */
+  uint64_t fallUs;                               /*!< time of falling edge of echo */
+} SimSensor_t;
+
+/**
+ * @brief Simulator state
+ * 
+ */
+static struct {
+  SimSensor_t snsr[VIHCSR04_SIM_MAX_SENSORS];    /*!< simulated sensors */
+  uint32_t number;                               /*!< number of added sensors */
+  uint64_t nowUs;                                /*!< virtual clock */
+  uint32_t random;                               /*!< state of pseudo random generator */
+  float temperature;                             /*!< environment temperature */
+  VIHCSR04_SimEdge_t edgeCb;                     /*!< edge call-back */
+} sim;
+
+/**
+ * @brief Pseudo random generator (xorshift32)
+ * 
+ * @return uint32_t next random number
+ */
+static uint32_t Random(void) {
+  sim.random ^= sim.random << 13;
+  sim.random ^= sim.random >> 17;
+  sim.random ^= sim.random << 5;
+  return sim.random;
+}
+
+/**
+ * @brief Round trip time of sound for target distance
+ * 
+ * @param distanceMm Distance to the target
+ * @return uint64_t round trip time in microseconds
+ */
+static uint64_t RoundTripUs(uint32_t distanceMm) {
+  // Cair ≈ (331.3 + 0.606 ⋅ ϑ) m/s = (0.3313 + 0.000606 ⋅ ϑ) mm/us
+  return (uint64_t)(2.0f * distanceMm / (0.3313f + 0.000606f * sim.temperature) + 0.5f);
+}
+
+/**
+ * @brief Find simulated sensor by pin
+ * 
+ * @param echo Search by echo pin if true, by trigger pin otherwise
+ * @param port Pointer to a GPIO structur
+ * @param pin Pin number
+ * @return SimSensor_t* found sensor, NULL if not found
+ */
+static SimSensor_t* FindSensor(bool echo, const void* port, uint16_t pin) {
+  for(uint32_t i = 0; i < sim.number; i++) {
+    SimSensor_t* sensor = &sim.snsr[i];
+    if(echo ? (sensor->echoPort == port && sensor->echoPin == pin) : 
+              (sensor->triggerPort == port && sensor->triggerPin == pin))
+      return sensor;
+  }
+  return NULL;
+}
+
+/**
+ * @brief End measurement of receiving sensor earlier if burst of sending sensor arrives before own echo
+ * 
+ * @param from Sending sensor
+ * @param to Receiving sensor
+ */
+static void Crosstalk(const SimSensor_t* from, SimSensor_t* to) {
+  uint32_t pathMm = from->crosstalkMm[to - sim.snsr];
+
+  if(from == to || !from->active || !to->active || 0 == pathMm)
+    return;
+
+  uint64_t arrivalUs = from->triggerUs + VIHCSR04_SIM_BURST_US + RoundTripUs(pathMm);
+
+  if(arrivalUs > to->riseUs && arrivalUs < to->fallUs)
+    to->fallUs = arrivalUs;
+}
+
+void VIHCSR04_SimInit(uint32_t seed) {
+  memset(&sim, 0, sizeof(sim));
+  // xorshift must not be seeded with 0
+  sim.random = (0 != seed) ? seed : 0x12345678;
+  sim.temperature = 20.0f;
+}
+
+int32_t VIHCSR04_SimAddSensor(const void* triggerPort, uint16_t triggerPin, 
+  const void* echoPort, uint16_t echoPin) {
+
+  if(sim.number >= VIHCSR04_SIM_MAX_SENSORS)
+    return -1;
+
+  SimSensor_t* sensor = &sim.snsr[sim.number];
+
+  memset(sensor, 0, sizeof(*sensor));
+  sensor->triggerPort = triggerPort;
+  sensor->triggerPin = triggerPin;
+  sensor->echoPort = echoPort;
+  sensor->echoPin = echoPin;
+  sensor->distanceMm = UINT32_MAX;
+
+  return (int32_t)sim.number++;
+}
+
+bool VIHCSR04_SimSetDistance(int32_t sensor, uint32_t distanceMm) {
+  if(0 > sensor || (uint32_t)sensor >= sim.number)
+    return false;
+  sim.snsr[sensor].distanceMm = distanceMm;
+  return true;
+}
+
+bool VIHCSR04_SimSetNoise(int32_t sensor, uint32_t noiseMm) {
+  if(0 > sensor || (uint32_t)sensor >= sim.number)
+    return false;
+  sim.snsr[sensor].noiseMm = noiseMm;
+  return true;
+}
+
+bool VIHCSR04_SimSetDropout(int32_t sensor, uint16_t permille) {
+  if(0 > sensor || (uint32_t)sensor >= sim.number)
+    return false;
+  sim.snsr[sensor].dropoutPermille = permille;
+  return true;
+}
+
+bool VIHCSR04_SimSetCrosstalk(int32_t from, int32_t to, uint32_t pathMm) {
+  if(0 > from || (uint32_t)from >= sim.number || 
+     0 > to || (uint32_t)to >= sim.number)
+    return false;
+  sim.snsr[from].crosstalkMm[to] = pathMm;
+  return true;
+}
+
+void VIHCSR04_SimSetTemperature(float temperature) {
+  sim.temperature = temperature;
+}
+
+void VIHCSR04_SimSetEdgeCb(VIHCSR04_SimEdge_t edgeCb) {
+  sim.edgeCb = edgeCb;
+}
+
+uint32_t VIHCSR04_SimGetTriggerCount(int32_t sensor) {
+  if(0 > sensor || (uint32_t)sensor >= sim.number)
+    return 0;
+  return sim.snsr[sensor].triggerCount;
+}
+
+uint64_t VIHCSR04_SimGetTimeUs(void) {
+  return sim.nowUs;
+}
+
+void VIHCSR04_SimAdvance(uint64_t us) {
+
+  uint64_t endUs = sim.nowUs + us;
+
+  // report edges one by one in time order
+  while(NULL != sim.edgeCb) {
+    SimSensor_t* next = NULL;
+    uint64_t nextUs = endUs;
+
+    for(uint32_t i = 0; i < sim.number; i++) {
+      SimSensor_t* sensor = &sim.snsr[i];
+      if(!sensor->active)
+        continue;
+      uint64_t edgeUs = sensor->riseReported ? sensor->fallUs : sensor->riseUs;
+      if(edgeUs <= nextUs) {
+        next = sensor;
+        nextUs = edgeUs;
+      }
+    }
+
+    if(NULL == next)
+      break;
+
+    if(nextUs > sim.nowUs)
+      sim.nowUs = nextUs;
+
+    if(!next->riseReported) {
+      next->riseReported = true;
+      sim.edgeCb(next->echoPort, next->echoPin, 1, nextUs);
+    } else {
+      next->active = false;
+      sim.edgeCb(next->echoPort, next->echoPin, 0, nextUs);
+    }
+  }
+
+  if(endUs > sim.nowUs)
+    sim.nowUs = endUs;
+}
+
+uint64_t VIHCSR04_SimPulseIn(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t maxDurationTreshold, const void* context) {
+
+  (void)context;
+
+  SimSensor_t* sensor = FindSensor(true, gpio, port);
+
+  if(NULL == sensor || !sensor->active || 1 != state)
+    return 0;
+
+  sensor->active = false;
+
+  uint64_t timeoutUs = maxDurationTreshold / 1000;
+  uint64_t durationUs = sensor->fallUs - sensor->riseUs;
+
+  if(sensor->riseUs > sim.nowUs)
+    sim.nowUs = sensor->riseUs;
+
+  if(durationUs > timeoutUs) {
+    sim.nowUs += timeoutUs;
+    return 0;
+  }
+
+  sim.nowUs = sensor->fallUs;
+
+  return durationUs;
+}
+
+void VIHCSR04_SimTrigger(const void* gpio, uint16_t port, 
+  uint8_t state, uint64_t pulseDuration, const void* context) {
+
+  (void)pulseDuration;
+  (void)context;
+
+  SimSensor_t* sensor = FindSensor(false, gpio, port);
+
+  // a triggered sensor ignores new triggers until its echo is finished
+  if(NULL == sensor || 0 == state || sensor->active)
+    return;
+
+  sensor->triggerCount++;
+  sensor->active = true;
+  sensor->riseReported = false;
+  sensor->triggerUs = sim.nowUs;
+  sensor->riseUs = sim.nowUs + VIHCSR04_SIM_BURST_US;
+
+  uint32_t distanceMm = sensor->distanceMm;
+
+  if(0 != sensor->noiseMm && UINT32_MAX != distanceMm) {
+    int64_t noisyMm = (int64_t)distanceMm + 
+      (int64_t)(Random() % (2 * sensor->noiseMm + 1)) - sensor->noiseMm;
+    distanceMm = (noisyMm > 0) ? (uint32_t)noisyMm : 0;
+  }
+
+  bool dropout = 0 != sensor->dropoutPermille && 
+    (Random() % 1000) < sensor->dropoutPermille;
+
+  if(dropout || distanceMm > VIHCSR04_SIM_MAX_RANGE_MM)
+    sensor->fallUs = sensor->riseUs + VIHCSR04_SIM_NO_ECHO_US;
+  else
+    sensor->fallUs = sensor->riseUs + RoundTripUs(distanceMm);
+
+  // bursts of sensors measuring at the same time
+  for(uint32_t i = 0; i < sim.number; i++) {
+    Crosstalk(sensor, &sim.snsr[i]);
+    Crosstalk(&sim.snsr[i], sensor);
+  }
+}
+
+void VIHCSR04_SimTriggerMask(const void* gpio, uint32_t pinMask, 
+  uint8_t state, uint64_t pulseDuration) {
+
+  for(uint16_t pin = 0; pin < 32; pin++) {
+    if(0 != (pinMask & ((uint32_t)1 << pin)))
+      VIHCSR04_SimTrigger(gpio, pin, state, pulseDuration, NULL);
+  }
+}
@@ -4,6 +4,10 @@
 static void runAllTests(void)
 {
   RUN_TEST_GROUP(TST_VIHCSR04);
+  RUN_TEST_GROUP(TST_VIHCSR04CPP);
+  RUN_TEST_GROUP(TST_VIHCSR04ENGINE);
+  RUN_TEST_GROUP(TST_VIHCSR04CORO);
+  RUN_TEST_GROUP(TST_VIHCSR04ARRAY);
 }
 
 int main(int argc, const char* argv[])
@@ -0,0 +1,11 @@
+#include "unity_fixture.h"
+
+static void runAllTests(void)
+{
+  RUN_TEST_GROUP(TST_VIHCSR04TSAN);
+}
+
+int main(int argc, const char* argv[])
+{
+  return UnityMain(argc, argv, runAllTests);
+}
@@ -1,22 +1,1071 @@
 #include "unity.h"
 #include "unity_fixture.h"
 #include "vihcsr04.h"
+#include "vihcsr04_ctx.h"
+#include "vihcsr04_sim.h"
+#include "vihcsr04_batch.h"
+#include "vihcsr04_rec.h"
+#include "vihcsr04_shm.h"
 #include "stdio.h"
+#include "string.h"
+
+#define TST_TRIGGER_A 1
+#define TST_ECHO_A 11
+#define TST_TRIGGER_B 2
+#define TST_ECHO_B 12
+
+static uint32_t distanceMm[2];
+static uint32_t measured[2];
+
+static void DistanceMm(uint32_t mm, const void* context) {
+  uint32_t index = (uint32_t)(uintptr_t)context;
+  distanceMm[index] = mm;
+  measured[index]++;
+}
+
+static void Created(VIHCSR04_Handle_t handle, const void* context) {
+  *(VIHCSR04_Handle_t*)context = handle;
+}
+
+static uint8_t recording[1024];
+static size_t recordingSize;
+
+static size_t WriteRecording(const void* data, size_t size, const void* context) {
+  (void)context;
+  if(recordingSize + size > sizeof(recording))
+    return 0;
+  memcpy(&recording[recordingSize], data, size);
+  recordingSize += size;
+  return size;
+}
+
+static uint32_t triggerWrites;
+static uint32_t triggerMask;
+
+static void TriggerMask(const void* gpio, uint32_t pinMask, uint8_t state, uint64_t pulseDuration) {
+  triggerWrites++;
+  triggerMask = pinMask;
+  VIHCSR04_SimTriggerMask(gpio, pinMask, state, pulseDuration);
+}
+
+// sync measurement in edge driven mode waits on time source, every read moves simulation
+static uint64_t Tick(void) {
+  VIHCSR04_SimAdvance(10);
+  return VIHCSR04_SimGetTimeUs();
+}
+
+static void CtxEchoEdge(const void* echoPort, uint16_t echoPin, uint8_t level, uint64_t timeUs);
+
+static void RunEdgeDriven(uint32_t index, uint32_t count) {
+  for(uint32_t i = 0; i < 100000 && measured[index] < count; i++) {
+    VIHCSR04_Runtime();
+    VIHCSR04_SimAdvance(10);
+  }
+}
 
 TEST_GROUP(TST_VIHCSR04);
 
 TEST_GROUP_RUNNER(TST_VIHCSR04) {
   RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Init);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Conversion);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Filter);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_MeasureBlocking);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Handles);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Samples);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_MeasureDropout);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Adaptive);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_MeasureEdgeDriven);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Crosstalk);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_TriggerMask);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_SimDeterministic);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Stats);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Log);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Period);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Events);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_RuntimeUntil);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Batch);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Ctx);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_SyncMeasure);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Command);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_RecordReplay);
+  RUN_TEST_CASE(TST_VIHCSR04, VIHCSR04_Publisher);
 }
 
 TEST_SETUP(TST_VIHCSR04) {
+  VIHCSR04_SimInit(1);
+  VIHCSR04_SimAddSensor(NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_SimAddSensor(NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+  distanceMm[0] = distanceMm[1] = 0;
+  measured[0] = measured[1] = 0;
+  triggerWrites = triggerMask = 0;
 }
 
 TEST_TEAR_DOWN(TST_VIHCSR04) {
+  VIHCSR04_SimSetEdgeCb(NULL);
+  VIHCSR04_SetSampleBuffer(NULL, 0);
+  VIHCSR04_SetLogBuffer(NULL, 0);
+  VIHCSR04_SetCommandBuffer(NULL, 0);
+  VIHCSR04_SetRecorder(NULL);
+  VIHCSR04_SetPublisher(NULL);
+  VIHCSR04_SetTriggerMaskCb(NULL);
+  VIHCSR04_SetGuardInterval(0);
+  VIHCSR04_SetDebugLvl(VIHCSR04_DEBUG_DISABLED);
 }
 
 TEST(TST_VIHCSR04, VIHCSR04_Init)
 {
-  printf("Test: VIHCSR04_Init");
-  TEST_ASSERT_EQUAL(0, VIHCSR04_Init());
-}
\ No newline at end of file
+  printf("Test: VIHCSR04_Init\r\n");
+  TEST_ASSERT_FALSE(VIHCSR04_Init(NULL, VIHCSR04_SimTrigger));
+  TEST_ASSERT_FALSE(VIHCSR04_InitEdgeDriven(VIHCSR04_SimTrigger, NULL));
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Conversion)
+{
+  printf("Test: VIHCSR04_Conversion\r\n");
+  static const float temperatures[] = {-40.0f, -10.0f, 0.0f, 20.0f, 35.5f, 60.0f};
+  VIHCSR04_Conversion_t conv;
+
+  for(uint32_t t = 0; t < sizeof(temperatures) / sizeof(temperatures[0]); t++) {
+    // range of echo durations up to 65 ms
+    VIHCSR04_ConversionInit(&conv, temperatures[t], 1100);
+
+    for(uint32_t durationUs = 1; durationUs <= 65000; durationUs += 3) {
+      uint32_t mm = VIHCSR04_ToMm(&conv, durationUs);
+      float cm = VIHCSR04_ToCm(&conv, durationUs);
+
+      if(VIHCSR04_INVALID_DISTANCE_MM != mm && 0 < cm)
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, cm * 10.0f, (float)mm);
+      // only one of them reports out of range within 1 mm of range borders
+      else if(VIHCSR04_INVALID_DISTANCE_MM != mm)
+        TEST_ASSERT_UINT32_WITHIN(1, 11000, mm);
+      else if(0 < cm && 1.0f < cm * 10.0f)
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, 11000.0f, cm * 10.0f);
+    }
+
+    TEST_ASSERT_EQUAL(VIHCSR04_INVALID_DISTANCE_MM, VIHCSR04_ToMm(&conv, 0));
+    TEST_ASSERT_EQUAL(VIHCSR04_INVALID_DISTANCE_MM, VIHCSR04_ToMm(&conv, conv.maxEchoUs + 1));
+  }
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Filter)
+{
+  printf("Test: VIHCSR04_Filter\r\n");
+  static const uint32_t INV = VIHCSR04_INVALID_DISTANCE_MM;
+  static const struct {
+    VIHCSR04_FilterCfg_t cfg;
+    uint32_t in[8];
+    uint32_t out[8];
+  } table[] = {
+    // odd window removes outliers, out of range samples don't enter the window
+    { { .stages = VIHCSR04_FILTER_MEDIAN, .medianWindow = 3 },
+      { 100, 300, 200, 900, 210, 205, INV, 220 },
+      { 100, 200, 200, 300, 210, 210, INV, 210 } },
+    // even window averages both middle samples
+    { { .stages = VIHCSR04_FILTER_MEDIAN, .medianWindow = 4 },
+      { 100, 200, 300, 400, 500, INV, 100, 600 },
+      { 100, 150, 200, 250, 350, INV, 350, 450 } },
+    // ema with alpha 1/4 in Q8, the first sample initializes
+    { { .stages = VIHCSR04_FILTER_EMA, .emaShift = 2 },
+      { 1000, 2000, 2000, 2000, INV, 1000, 1000, 1000 },
+      { 1000, 1250, 1438, 1578, INV, 1434, 1325, 1244 } },
+    // ema with shift 0 follows every sample
+    { { .stages = VIHCSR04_FILTER_EMA, .emaShift = 0 },
+      { 1000, 2000, INV, 10, 4000, 3999, 1, 65535 },
+      { 1000, 2000, INV, 10, 4000, 3999, 1, 65535 } },
+  };
+
+  for(uint32_t t = 0; t < sizeof(table) / sizeof(table[0]); t++) {
+    VIHCSR04_Filter_t filter;
+    TEST_ASSERT_TRUE(VIHCSR04_FilterCfgValid(&table[t].cfg));
+    VIHCSR04_FilterInit(&filter, &table[t].cfg);
+
+    for(uint32_t i = 0; i < 8; i++) {
+      TEST_ASSERT_EQUAL_UINT32(table[t].out[i], VIHCSR04_FilterApply(&filter, table[t].in[i]));
+    }
+  }
+
+  static const VIHCSR04_FilterCfg_t invalid[] = {
+    { .stages = 1 << 3 },
+    { .stages = VIHCSR04_FILTER_MEDIAN, .medianWindow = 0 },
+    { .stages = VIHCSR04_FILTER_MEDIAN, .medianWindow = VIHCSR04_MEDIAN_MAX_WINDOW + 1 },
+    { .stages = VIHCSR04_FILTER_EMA, .emaShift = 16 },
+    { .stages = VIHCSR04_FILTER_KALMAN, .kalmanProcessNoise = -1, .kalmanMeasurementNoise = 1 },
+    { .stages = VIHCSR04_FILTER_KALMAN, .kalmanProcessNoise = 1, .kalmanMeasurementNoise = 0 },
+  };
+
+  for(uint32_t t = 0; t < sizeof(invalid) / sizeof(invalid[0]); t++) {
+    TEST_ASSERT_FALSE(VIHCSR04_FilterCfgValid(&invalid[t]));
+  }
+
+  // kalman: first sample initializes, a ramp is followed without lag, noise is reduced
+  static const int32_t noise[] = { 12, -9, 4, -15, 8, -3, 11, -7, 14, -12, 6, -5 };
+  VIHCSR04_FilterCfg_t kalman = { .stages = VIHCSR04_FILTER_KALMAN, 
+    .kalmanProcessNoise = 0.01f, .kalmanMeasurementNoise = 100 };
+  VIHCSR04_Filter_t filter;
+  VIHCSR04_FilterInit(&filter, &kalman);
+
+  TEST_ASSERT_EQUAL_UINT32(1000, VIHCSR04_FilterApply(&filter, 1000));
+  uint32_t out = 0;
+  for(uint32_t i = 1; i <= 60; i++) {
+    out = VIHCSR04_FilterApply(&filter, 1000 + 10 * i);
+  }
+  TEST_ASSERT_UINT32_WITHIN(2, 1600, out);
+
+  VIHCSR04_FilterInit(&filter, &kalman);
+  for(uint32_t i = 0; i < 60; i++) {
+    out = VIHCSR04_FilterApply(&filter, 
+      (uint32_t)(1000 + noise[i % (sizeof(noise) / sizeof(noise[0]))]));
+    if(12 <= i)
+      TEST_ASSERT_UINT32_WITHIN(5, 1000, out);
+  }
+
+  // out of range sample passes all stages and doesn't change their state
+  VIHCSR04_FilterCfg_t all = { .stages = VIHCSR04_FILTER_MEDIAN | VIHCSR04_FILTER_EMA | 
+    VIHCSR04_FILTER_KALMAN, .medianWindow = 5, .emaShift = 1, 
+    .kalmanProcessNoise = 1, .kalmanMeasurementNoise = 25 };
+  VIHCSR04_FilterInit(&filter, &all);
+  for(uint32_t i = 0; i < 7; i++) {
+    VIHCSR04_FilterApply(&filter, 500 + 3 * i);
+  }
+  VIHCSR04_Filter_t before = filter;
+  TEST_ASSERT_EQUAL_UINT32(INV, VIHCSR04_FilterApply(&filter, INV));
+  TEST_ASSERT_EQUAL(0, memcmp(&before, &filter, sizeof(filter)));
+
+  // lost echo is reported as out of range and doesn't enter the window of sensor
+  VIHCSR04_FilterCfg_t median = { .stages = VIHCSR04_FILTER_MEDIAN, .medianWindow = 2 };
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  VIHCSR04_Handle_t handle = VIHCSR04_CreateFiltered("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A, &median);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+  VIHCSR04_Runtime();
+  VIHCSR04_SimSetDropout(0, 1000);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL_UINT32(INV, distanceMm[0]);
+  VIHCSR04_SimSetDropout(0, 0);
+  VIHCSR04_SimSetDistance(0, 1100);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_UINT32_WITHIN(1, 1050, distanceMm[0]);
+  TEST_ASSERT_EQUAL(3, measured[0]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_MeasureBlocking)
+{
+  printf("Test: VIHCSR04_MeasureBlocking\r\n");
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  TEST_ASSERT_NOT_EQUAL(VIHCSR04_INVALID_HANDLE, handle);
+  TEST_ASSERT_TRUE(VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0));
+
+  VIHCSR04_Runtime();
+
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm[0]);
+  // burst and round trip of 2 m at 343.4 m/s
+  TEST_ASSERT_UINT32_WITHIN(1, 450 + 5824, VIHCSR04_SimGetTimeUs());
+
+  // one shot measurement is done
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(1, measured[0]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Handles)
+{
+  printf("Test: VIHCSR04_Handles\r\n");
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+
+  VIHCSR04_Handle_t a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  TEST_ASSERT_NOT_EQUAL(VIHCSR04_INVALID_HANDLE, a);
+  TEST_ASSERT_EQUAL(a, VIHCSR04_GetHandle("A"));
+
+  // handle 0 doesn't address the sensor of slot 0
+  TEST_ASSERT_EQUAL(0, a & 0xFFFF);
+  TEST_ASSERT_FALSE(VIHCSR04_MeasureDistanceMmAsyncByHandle(VIHCSR04_INVALID_HANDLE,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0));
+  TEST_ASSERT_FALSE(VIHCSR04_DeleteByHandle(VIHCSR04_INVALID_HANDLE));
+
+  // handle becomes stale by delete
+  TEST_ASSERT_TRUE(VIHCSR04_DeleteByHandle(a));
+  TEST_ASSERT_FALSE(VIHCSR04_DeleteByHandle(a));
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_HANDLE, VIHCSR04_GetHandle("A"));
+
+  // reused slot gets a new generation, stale handle doesn't address the new sensor
+  VIHCSR04_Handle_t b = VIHCSR04_Create("B", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+  TEST_ASSERT_EQUAL(a & 0xFFFF, b & 0xFFFF);
+  TEST_ASSERT_NOT_EQUAL(a, b);
+  TEST_ASSERT_FALSE(VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0));
+  TEST_ASSERT_TRUE(VIHCSR04_MeasureDistanceMmAsyncByHandle(b,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)1));
+
+  // generation wraps around after 0xFFFF reuses, generation 0 is skipped
+  VIHCSR04_Handle_t handle = b;
+  for(uint32_t i = 0; i < 0xFFFF; i++) {
+    TEST_ASSERT_TRUE(VIHCSR04_DeleteByHandle(handle));
+    handle = VIHCSR04_Create("B", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+    TEST_ASSERT_NOT_EQUAL(VIHCSR04_INVALID_HANDLE, handle);
+    TEST_ASSERT_NOT_EQUAL(0, handle >> 16);
+  }
+  TEST_ASSERT_EQUAL(b, handle);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Samples)
+{
+  printf("Test: VIHCSR04_Samples\r\n");
+  VIHCSR04_Sample_t buffer[4];
+  VIHCSR04_Sample_t samples[8];
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_SimGetTimeUs));
+  TEST_ASSERT_FALSE(VIHCSR04_SetSampleBuffer(buffer, 3));
+  TEST_ASSERT_TRUE(VIHCSR04_SetSampleBuffer(buffer, 4));
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+  // consumer drains in parts
+  for(uint32_t i = 0; i < 3; i++) {
+    VIHCSR04_Runtime();
+  }
+  TEST_ASSERT_EQUAL(0, VIHCSR04_DrainSamples(NULL, 8));
+  TEST_ASSERT_EQUAL(2, VIHCSR04_DrainSamples(samples, 2));
+  TEST_ASSERT_EQUAL(1, VIHCSR04_DrainSamples(&samples[2], 8));
+  TEST_ASSERT_EQUAL(0, VIHCSR04_DrainSamples(samples, 8));
+
+  for(uint32_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(handle, samples[i].handle);
+    TEST_ASSERT_UINT32_WITHIN(1, 1000, samples[i].distanceMm);
+    TEST_ASSERT_UINT32_WITHIN(1, 5824, samples[i].durationUs);
+    if(0 < i)
+      TEST_ASSERT_GREATER_THAN(samples[i - 1].timestampUs, samples[i].timestampUs);
+  }
+  TEST_ASSERT_EQUAL(0, VIHCSR04_GetSampleOverflows());
+
+  // consumer falls behind: full buffer keeps the oldest samples and counts dropped ones
+  uint64_t startUs = VIHCSR04_SimGetTimeUs();
+  for(uint32_t i = 0; i < 6; i++) {
+    VIHCSR04_Runtime();
+  }
+  TEST_ASSERT_EQUAL(2, VIHCSR04_GetSampleOverflows());
+  TEST_ASSERT_EQUAL(6, measured[0] - 3);
+  TEST_ASSERT_EQUAL(4, VIHCSR04_DrainSamples(samples, 8));
+  TEST_ASSERT_GREATER_THAN(startUs, samples[0].timestampUs);
+  TEST_ASSERT_LESS_THAN(VIHCSR04_SimGetTimeUs(), samples[3].timestampUs);
+
+  // buffer is usable again after drain
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(1, VIHCSR04_DrainSamples(samples, 8));
+  TEST_ASSERT_EQUAL(VIHCSR04_SimGetTimeUs(), samples[0].timestampUs);
+  TEST_ASSERT_EQUAL(2, VIHCSR04_GetSampleOverflows());
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_MeasureDropout)
+{
+  printf("Test: VIHCSR04_MeasureDropout\r\n");
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetDropout(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+  VIHCSR04_Runtime();
+
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  TEST_ASSERT_EQUAL_UINT32(VIHCSR04_INVALID_DISTANCE_MM, distanceMm[0]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Adaptive)
+{
+  printf("Test: VIHCSR04_Adaptive\r\n");
+  // turns skipped before each ping, doubled by every stable result up to the cap
+  static const uint32_t gaps[] = {0, 1, 2, 4, 8, VIHCSR04_ADAPTIVE_MAX_SKIP};
+  VIHCSR04_Conversion_t conv;
+  VIHCSR04_ConversionInit(&conv, 20, 400);
+
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  TEST_ASSERT_TRUE(VIHCSR04_SetAdaptiveByHandle(handle, true));
+  TEST_ASSERT_TRUE(VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0));
+
+  // first ping has no history and uses full range
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm[0]);
+
+  for(uint32_t i = 0; i < sizeof(gaps) / sizeof(gaps[0]); i++) {
+    for(uint32_t j = 0; j < gaps[i]; j++) {
+      VIHCSR04_Runtime();
+      TEST_ASSERT_EQUAL(i + 1, VIHCSR04_SimGetTriggerCount(0));
+    }
+    VIHCSR04_Runtime();
+    TEST_ASSERT_EQUAL(i + 2, VIHCSR04_SimGetTriggerCount(0));
+    TEST_ASSERT_EQUAL(i + 2, measured[0]);
+  }
+
+  // skip count stays at the cap
+  for(uint32_t j = 0; j < VIHCSR04_ADAPTIVE_MAX_SKIP; j++)
+    VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(sizeof(gaps) / sizeof(gaps[0]) + 1, VIHCSR04_SimGetTriggerCount(0));
+
+  // echo of 2.5 m is beyond timeout narrowed to last distance * 1.5 plus slack
+  uint32_t lastMm = distanceMm[0];
+  uint32_t timeoutUs = (((lastMm + lastMm / 2) * conv.usPerMmQ8) >> 8) + VIHCSR04_ADAPTIVE_SLACK_US;
+  TEST_ASSERT_LESS_THAN(conv.maxEchoUs, timeoutUs);
+
+  VIHCSR04_SimSetDistance(0, 2500);
+  uint64_t startUs = VIHCSR04_SimGetTimeUs();
+  uint32_t count = measured[0];
+
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(sizeof(gaps) / sizeof(gaps[0]) + 2, VIHCSR04_SimGetTriggerCount(0));
+  TEST_ASSERT_UINT32_WITHIN(1, 450 + timeoutUs, (uint32_t)(VIHCSR04_SimGetTimeUs() - startUs));
+  // miss is not reported
+  TEST_ASSERT_EQUAL(count, measured[0]);
+
+  // retry in the next turn uses full range
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(count + 1, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(2, 2500, distanceMm[0]);
+
+  // changed result resets skip count
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(count + 2, measured[0]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_MeasureEdgeDriven)
+{
+  printf("Test: VIHCSR04_MeasureEdgeDriven\r\n");
+  VIHCSR04_SimSetDistance(0, 1500);
+  VIHCSR04_SimSetEdgeCb(VIHCSR04_EchoEdge);
+  TEST_ASSERT_TRUE(VIHCSR04_InitEdgeDriven(VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs));
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+  RunEdgeDriven(0, 3);
+
+  TEST_ASSERT_EQUAL(3, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(2, 1500, distanceMm[0]);
+  TEST_ASSERT_EQUAL(3, VIHCSR04_SimGetTriggerCount(0));
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Crosstalk)
+{
+  printf("Test: VIHCSR04_Crosstalk\r\n");
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetDistance(1, 3000);
+  VIHCSR04_SimSetCrosstalk(0, 1, 1200);
+  VIHCSR04_SimSetEdgeCb(VIHCSR04_EchoEdge);
+  TEST_ASSERT_TRUE(VIHCSR04_InitEdgeDriven(VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs));
+
+  VIHCSR04_Handle_t a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_Handle_t b = VIHCSR04_Create("B", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(b,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)1);
+
+  // sensors of different groups don't hear each other
+  RunEdgeDriven(1, 1);
+  TEST_ASSERT_UINT32_WITHIN(2, 3000, distanceMm[1]);
+
+  // sensors of one group are triggered together, burst of A ends measurement of B
+  VIHCSR04_SetFiringGroupByHandle(b, 0);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(b,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)1);
+
+  RunEdgeDriven(1, 2);
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, distanceMm[0]);
+  TEST_ASSERT_UINT32_WITHIN(2, 1200, distanceMm[1]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_TriggerMask)
+{
+  printf("Test: VIHCSR04_TriggerMask\r\n");
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetDistance(1, 2000);
+  VIHCSR04_SimSetEdgeCb(VIHCSR04_EchoEdge);
+  TEST_ASSERT_TRUE(VIHCSR04_InitEdgeDriven(VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs));
+  VIHCSR04_SetTriggerMaskCb(TriggerMask);
+
+  VIHCSR04_Handle_t a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_Handle_t b = VIHCSR04_Create("B", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+  VIHCSR04_SetFiringGroupByHandle(b, 0);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(b,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)1);
+
+  // both sensors of group on one port are triggered by one write per cycle
+  RunEdgeDriven(1, 3);
+  TEST_ASSERT_EQUAL(3, triggerWrites);
+  TEST_ASSERT_EQUAL((1u << TST_TRIGGER_A) | (1u << TST_TRIGGER_B), triggerMask);
+  TEST_ASSERT_EQUAL(3, VIHCSR04_SimGetTriggerCount(0));
+  TEST_ASSERT_EQUAL(3, VIHCSR04_SimGetTriggerCount(1));
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, distanceMm[0]);
+  TEST_ASSERT_UINT32_WITHIN(2, 2000, distanceMm[1]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_SimDeterministic)
+{
+  printf("Test: VIHCSR04_SimDeterministic\r\n");
+  uint32_t first[8];
+
+  for(uint32_t run = 0; run < 2; run++) {
+    VIHCSR04_SimInit(42);
+    VIHCSR04_SimAddSensor(NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+    VIHCSR04_SimSetDistance(0, 2000);
+    VIHCSR04_SimSetNoise(0, 50);
+    TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+
+    VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+    VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+      VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+    for(uint32_t i = 0; i < 8; i++) {
+      VIHCSR04_Runtime();
+      TEST_ASSERT_UINT32_WITHIN(51, 2000, distanceMm[0]);
+      if(0 == run)
+        first[i] = distanceMm[0];
+      else
+        TEST_ASSERT_EQUAL_UINT32(first[i], distanceMm[0]);
+    }
+  }
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Stats)
+{
+  printf("Test: VIHCSR04_Stats\r\n");
+  VIHCSR04_Stats_t stats;
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_SimGetTimeUs));
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+  for(uint32_t i = 0; i < 4; i++)
+    VIHCSR04_Runtime();
+
+  VIHCSR04_SimSetDropout(0, 1000);
+  VIHCSR04_Runtime();
+  VIHCSR04_SimAdvance(100);
+
+  TEST_ASSERT_TRUE(VIHCSR04_GetStatsByHandle(handle, &stats));
+  TEST_ASSERT_EQUAL(5, stats.pings);
+  TEST_ASSERT_EQUAL(5, stats.results);
+  TEST_ASSERT_EQUAL(1, stats.timeouts);
+  TEST_ASSERT_EQUAL(0, stats.outOfRange);
+  TEST_ASSERT_EQUAL(4, stats.echoUs.count);
+  TEST_ASSERT_EQUAL(5, stats.latencyUs.count);
+  // results come 6274 us after trigger (bucket [4096, 8192)), 
+  // timeout after echo timeout of 400 cm (bucket [16384, 32768))
+  TEST_ASSERT_EQUAL(4, stats.latencyUs.bucket[13]);
+  TEST_ASSERT_EQUAL(1, stats.latencyUs.bucket[15]);
+  // intervals are equal except the one of timeout
+  TEST_ASSERT_EQUAL(3, stats.jitterUs.count);
+  TEST_ASSERT_EQUAL(2, stats.jitterUs.bucket[0]);
+  TEST_ASSERT_EQUAL_UINT64(100, stats.ageUs);
+
+  TEST_ASSERT_TRUE(VIHCSR04_ResetStatsByHandle(handle));
+  TEST_ASSERT_TRUE(VIHCSR04_GetStatsByHandle(handle, &stats));
+  TEST_ASSERT_EQUAL(0, stats.pings);
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, stats.ageUs);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Log)
+{
+  printf("Test: VIHCSR04_Log\r\n");
+  VIHCSR04_LogRecord_t buffer[8];
+  VIHCSR04_LogRecord_t records[8];
+  char line[VIHCSR04_LOG_LINE_LEN];
+  VIHCSR04_SimSetDistance(0, 1500);
+  VIHCSR04_SimSetEdgeCb(VIHCSR04_EchoEdge);
+  TEST_ASSERT_TRUE(VIHCSR04_InitEdgeDriven(VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs));
+  TEST_ASSERT_FALSE(VIHCSR04_SetLogBuffer(buffer, 6));
+  TEST_ASSERT_TRUE(VIHCSR04_SetLogBuffer(buffer, 8));
+  VIHCSR04_SetDebugLvl(VIHCSR04_DEBUG_TRACE);
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+  RunEdgeDriven(0, 1);
+
+  TEST_ASSERT_EQUAL(4, VIHCSR04_DrainLog(records, 8));
+  TEST_ASSERT_EQUAL(VIHCSR04_LOG_CREATED, records[0].event);
+  TEST_ASSERT_EQUAL(TST_ECHO_A, records[0].value1);
+  TEST_ASSERT_EQUAL(VIHCSR04_LOG_TRIGGER, records[1].event);
+  TEST_ASSERT_EQUAL(VIHCSR04_LOG_ECHO, records[2].event);
+  // burst before echo and round trip of 3 m, rounded to 10 us steps of simulation
+  TEST_ASSERT_UINT32_WITHIN(10, 450, records[2].value0);
+  TEST_ASSERT_UINT32_WITHIN(10, 8736, records[2].value1);
+  TEST_ASSERT_EQUAL(VIHCSR04_LOG_RESULT, records[3].event);
+  TEST_ASSERT_EQUAL(handle, records[3].handle);
+  TEST_ASSERT_EQUAL_UINT32(distanceMm[0], records[3].value1);
+  TEST_ASSERT_EQUAL_UINT64(records[2].timestampUs, records[3].timestampUs);
+
+  VIHCSR04_FormatLog(&records[3], "A", line, sizeof(line));
+  TEST_ASSERT_NOT_NULL(strstr(line, "Sensor \"A\": measured distance"));
+
+  // records are dropped if buffer is full: 3 records per measurement
+  for(uint32_t i = 0; i < 4; i++) {
+    VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+      VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0);
+    RunEdgeDriven(0, i + 2);
+  }
+  TEST_ASSERT_EQUAL(4, VIHCSR04_GetLogOverflows());
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Period)
+{
+  printf("Test: VIHCSR04_Period\r\n");
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetDistance(1, 3000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_SimGetTimeUs));
+
+  VIHCSR04_Handle_t a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_Handle_t b = VIHCSR04_Create("B", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+  TEST_ASSERT_TRUE(VIHCSR04_SetPeriodByHandle(a, 50000));
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(b,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)1);
+
+  // A is measured once per period, B as often as possible in the rest of time
+  while(VIHCSR04_SimGetTimeUs() < 500000)
+    VIHCSR04_Runtime();
+
+  TEST_ASSERT_EQUAL(10, measured[0]);
+  TEST_ASSERT_EQUAL(0, VIHCSR04_GetDeadlineMissesByHandle(a));
+  // pings of B take 17922 us
+  TEST_ASSERT_UINT32_WITHIN(1, (500000 - 10 * 6274) / 17922, measured[1]);
+
+  // stopped sensor doesn't take turns, 
+  // period shorter than half of ping misses every deadline after the first one
+  VIHCSR04_StopContinuousMeasureByHandle(b);
+  TEST_ASSERT_TRUE(VIHCSR04_SetPeriodByHandle(a, 3000));
+  measured[0] = measured[1] = 0;
+
+  for(uint32_t i = 0; i < 10; i++)
+    VIHCSR04_Runtime();
+
+  TEST_ASSERT_EQUAL(10, measured[0]);
+  TEST_ASSERT_EQUAL(0, measured[1]);
+  TEST_ASSERT_EQUAL(9, VIHCSR04_GetDeadlineMissesByHandle(a));
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Events)
+{
+  printf("Test: VIHCSR04_Events\r\n");
+  VIHCSR04_EventCfg_t cfg = { .thresholdMm = {1500, 500}, .thresholds = 2, .hysteresisMm = 50 };
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_SimGetTimeUs));
+
+  VIHCSR04_Handle_t a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  TEST_ASSERT_FALSE(VIHCSR04_SetEventsByHandle(a, &cfg));
+  cfg.thresholdMm[0] = 500;
+  cfg.thresholdMm[1] = 1500;
+  TEST_ASSERT_TRUE(VIHCSR04_SetEventsByHandle(a, &cfg));
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+
+  // first result is reported, the same zone is not
+  for(uint32_t i = 0; i < 5; i++)
+    VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm[0]);
+
+  // zone is changed only beyond hysteresis
+  VIHCSR04_SimSetDistance(0, 1520);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  VIHCSR04_SimSetDistance(0, 1600);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(2, measured[0]);
+  VIHCSR04_SimSetDistance(0, 1480);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(2, measured[0]);
+  VIHCSR04_SimSetDistance(0, 1400);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(3, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1400, distanceMm[0]);
+
+  // change to the last reported result and heartbeat
+  cfg = (VIHCSR04_EventCfg_t){ .deltaMm = 100, .heartbeatUs = 100000 };
+  TEST_ASSERT_TRUE(VIHCSR04_SetEventsByHandle(a, &cfg));
+  measured[0] = 0;
+  VIHCSR04_Runtime();
+  VIHCSR04_SimSetDistance(0, 1450);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  VIHCSR04_SimSetDistance(0, 1550);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(2, measured[0]);
+
+  uint64_t start = VIHCSR04_SimGetTimeUs();
+  while(VIHCSR04_SimGetTimeUs() < start + 500000)
+    VIHCSR04_Runtime();
+  TEST_ASSERT_UINT32_WITHIN(1, 2 + 5, measured[0]);
+
+  // without events every result is reported
+  TEST_ASSERT_TRUE(VIHCSR04_SetEventsByHandle(a, NULL));
+  measured[0] = 0;
+  for(uint32_t i = 0; i < 5; i++)
+    VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(5, measured[0]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_RuntimeUntil)
+{
+  printf("Test: VIHCSR04_RuntimeUntil\r\n");
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_SimGetTimeUs));
+
+  VIHCSR04_Handle_t a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  TEST_ASSERT_EQUAL_UINT64(VIHCSR04_NO_DEADLINE, VIHCSR04_RuntimeUntil(100000));
+
+  // sensor with period is measured once, then the host can sleep until the next period
+  uint64_t start = VIHCSR04_SimGetTimeUs();
+  TEST_ASSERT_TRUE(VIHCSR04_SetPeriodByHandle(a, 50000));
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+  TEST_ASSERT_EQUAL_UINT64(start, VIHCSR04_RuntimeUntil(0));
+  TEST_ASSERT_EQUAL(0, measured[0]);
+
+  for(uint32_t i = 1; i <= 5; i++) {
+    uint64_t next = VIHCSR04_RuntimeUntil(100000);
+    TEST_ASSERT_EQUAL(i, measured[0]);
+    TEST_ASSERT_EQUAL_UINT64(start + i * 50000, next);
+    VIHCSR04_SimAdvance(next - VIHCSR04_SimGetTimeUs());
+  }
+  TEST_ASSERT_EQUAL(0, VIHCSR04_GetDeadlineMissesByHandle(a));
+
+  // edge driven: sleep until echo timeout and end of guard interval
+  VIHCSR04_SimSetEdgeCb(VIHCSR04_EchoEdge);
+  TEST_ASSERT_TRUE(VIHCSR04_InitEdgeDriven(VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs));
+  VIHCSR04_SetGuardInterval(10000);
+  a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+  measured[0] = 0;
+
+  for(uint32_t i = 0; i < 20; i++) {
+    uint64_t next = VIHCSR04_RuntimeUntil(1000);
+    TEST_ASSERT_GREATER_THAN(VIHCSR04_SimGetTimeUs(), next);
+    VIHCSR04_SimAdvance(next - VIHCSR04_SimGetTimeUs());
+  }
+  TEST_ASSERT_EQUAL(10, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm[0]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Batch)
+{
+  printf("Test: VIHCSR04_Batch (%s)\r\n", VIHCSR04_BatchKernel());
+  // odd count covers vector tails
+  enum { COUNT = 1003 };
+  static uint32_t durations[COUNT], distances[COUNT];
+  static uint16_t convIndex[COUNT];
+  VIHCSR04_Conversion_t convs[3];
+  uint32_t seed = 1;
+
+  VIHCSR04_ConversionInit(&convs[0], 20, 400);
+  VIHCSR04_ConversionInit(&convs[1], -10, 200);
+  VIHCSR04_ConversionInit(&convs[2], 35, 65535);
+
+  for(uint32_t i = 0; i < COUNT; i++) {
+    seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+    // edge values of range check and full 32 bit range
+    const uint32_t edges[] = {0, 1, convs[0].maxEchoUs, convs[0].maxEchoUs + 1, 
+      convs[1].maxEchoUs, UINT32_MAX, 0x80000000u, 0xFFFF, 0x10000};
+    durations[i] = (i < 9) ? edges[i] : (i & 1) ? seed % 30000 : seed;
+    convIndex[i] = seed % 3;
+  }
+
+  VIHCSR04_ToMmBatch(&convs[0], durations, distances, COUNT);
+  for(uint32_t i = 0; i < COUNT; i++)
+    TEST_ASSERT_EQUAL_UINT32(VIHCSR04_ToMm(&convs[0], durations[i]), distances[i]);
+
+  VIHCSR04_ToMmBatchIndexed(convs, convIndex, durations, distances, COUNT);
+  for(uint32_t i = 0; i < COUNT; i++)
+    TEST_ASSERT_EQUAL_UINT32(VIHCSR04_ToMm(&convs[convIndex[i]], durations[i]), distances[i]);
+
+  // in place conversion
+  memcpy(distances, durations, sizeof(distances));
+  VIHCSR04_ToMmBatch(&convs[1], distances, distances, COUNT);
+  for(uint32_t i = 0; i < COUNT; i++)
+    TEST_ASSERT_EQUAL_UINT32(VIHCSR04_ToMm(&convs[1], durations[i]), distances[i]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Ctx)
+{
+  printf("Test: VIHCSR04_Ctx\r\n");
+  static VIHCSR04_Sensor_t slotsA[1], slotsB[2];
+  static VIHCSR04_Ctx_t ctxA, ctxB;
+
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetDistance(1, 2000);
+  TEST_ASSERT_FALSE(VIHCSR04_CtxInit(&ctxA, slotsA, 0, VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_CtxInit(&ctxA, slotsA, 1, VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_CtxInit(&ctxB, slotsB, 2, VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+
+  // names and handles are per context
+  VIHCSR04_Handle_t handleA = VIHCSR04_CtxCreate(&ctxA, "A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_Handle_t handleB = VIHCSR04_CtxCreate(&ctxB, "A", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+  TEST_ASSERT_NOT_EQUAL(VIHCSR04_INVALID_HANDLE, handleA);
+  TEST_ASSERT_EQUAL(handleA, handleB);
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_HANDLE, 
+    VIHCSR04_CtxCreate(&ctxA, "B", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B));
+
+  TEST_ASSERT_TRUE(VIHCSR04_CtxMeasureDistanceMmAsyncByHandle(&ctxA, handleA,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0));
+  TEST_ASSERT_TRUE(VIHCSR04_CtxMeasureDistanceMmAsyncByHandle(&ctxB, handleB,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)1));
+
+  VIHCSR04_CtxRuntime(&ctxA);
+  VIHCSR04_CtxRuntime(&ctxA);
+  VIHCSR04_CtxRuntime(&ctxB);
+
+  TEST_ASSERT_EQUAL(2, measured[0]);
+  TEST_ASSERT_EQUAL(1, measured[1]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 2000, distanceMm[1]);
+
+  TEST_ASSERT_TRUE(VIHCSR04_CtxDelete(&ctxA, "A"));
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_HANDLE, VIHCSR04_CtxGetHandle(&ctxA, "A"));
+  TEST_ASSERT_EQUAL(handleB, VIHCSR04_CtxGetHandle(&ctxB, "A"));
+}
+
+static VIHCSR04_Ctx_t syncCtx;
+
+static void CtxEchoEdge(const void* echoPort, uint16_t echoPin, uint8_t level, uint64_t timeUs) {
+  VIHCSR04_CtxEchoEdge(&syncCtx, echoPort, echoPin, level, timeUs);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_SyncMeasure)
+{
+  printf("Test: VIHCSR04_SyncMeasure\r\n");
+  static VIHCSR04_Sensor_t slots[1];
+  static VIHCSR04_Sample_t samples[4];
+  VIHCSR04_Conversion_t conv;
+
+  VIHCSR04_SimSetDistance(0, 2500);
+  TEST_ASSERT_TRUE(VIHCSR04_CtxInitEdgeDriven(&syncCtx, slots, 1, VIHCSR04_SimTrigger, Tick));
+  TEST_ASSERT_TRUE(VIHCSR04_CtxSetSampleBuffer(&syncCtx, samples, 4));
+  VIHCSR04_SimSetEdgeCb(CtxEchoEdge);
+  VIHCSR04_Handle_t handle = VIHCSR04_CtxCreate(&syncCtx, "A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  TEST_ASSERT_TRUE(VIHCSR04_CtxMeasureDistanceMmAsyncByHandle(&syncCtx, handle,
+    VIHCSR04_ONESHOT_MEASURE, 20, 400, DistanceMm, (const void*)0));
+
+  // result is returned only, range of the call applies
+  TEST_ASSERT_UINT32_WITHIN(2, 2500, VIHCSR04_CtxMeasureDistanceMmByHandle(&syncCtx, handle, 20, 400));
+  TEST_ASSERT_EQUAL_UINT32(VIHCSR04_INVALID_DISTANCE_MM, 
+    VIHCSR04_CtxMeasureDistanceMmByHandle(&syncCtx, handle, 20, 200));
+  TEST_ASSERT_EQUAL(0, measured[0]);
+  TEST_ASSERT_EQUAL(0, VIHCSR04_CtxDrainSamples(&syncCtx, samples, 4));
+
+  // echo without falling edge ends the wait at echo timeout
+  VIHCSR04_ConversionInit(&conv, 20, 400);
+  VIHCSR04_SimAdvance(VIHCSR04_SIM_NO_ECHO_US);
+  VIHCSR04_SimSetDropout(0, 1000);
+  uint64_t start = VIHCSR04_SimGetTimeUs();
+  TEST_ASSERT_EQUAL_UINT32(VIHCSR04_INVALID_DISTANCE_MM, 
+    VIHCSR04_CtxMeasureDistanceMmByHandle(&syncCtx, handle, 20, 400));
+  TEST_ASSERT_UINT32_WITHIN(30, VIHCSR04_SIM_BURST_US + conv.maxEchoUs, 
+    (uint32_t)(VIHCSR04_SimGetTimeUs() - start));
+
+  // async measurement keeps its range and callback, starts after the echo has ended
+  VIHCSR04_SimSetDropout(0, 0);
+  VIHCSR04_SimAdvance(VIHCSR04_SIM_NO_ECHO_US);
+  for(uint32_t i = 0; i < 10000 && 0 == measured[0]; i++)
+    VIHCSR04_CtxRuntime(&syncCtx);
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(2, 2500, distanceMm[0]);
+  TEST_ASSERT_EQUAL(1, VIHCSR04_CtxDrainSamples(&syncCtx, samples, 4));
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Command)
+{
+  printf("Test: VIHCSR04_Command\r\n");
+  static VIHCSR04_Command_t commands[4];
+  VIHCSR04_Handle_t handle = VIHCSR04_INVALID_HANDLE;
+
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_FALSE(VIHCSR04_PostStop(1));
+  TEST_ASSERT_FALSE(VIHCSR04_SetCommandBuffer(commands, 3));
+  TEST_ASSERT_TRUE(VIHCSR04_SetCommandBuffer(commands, 4));
+
+  // commands are executed by runtime only
+  TEST_ASSERT_TRUE(VIHCSR04_PostCreate("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A, Created, &handle));
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_HANDLE, handle);
+  VIHCSR04_Runtime();
+  TEST_ASSERT_NOT_EQUAL(VIHCSR04_INVALID_HANDLE, handle);
+  TEST_ASSERT_EQUAL(handle, VIHCSR04_GetHandle("A"));
+
+  // commands are executed before measurement of the same cycle
+  TEST_ASSERT_TRUE(VIHCSR04_PostMeasureMm(handle, VIHCSR04_CONTINUOUS_MEASURE, 
+    20, 400, DistanceMm, (const void*)0));
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(1, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm[0]);
+
+  // range of 50 cm, 1 m is out of range
+  TEST_ASSERT_TRUE(VIHCSR04_PostConfigure(handle, 20, 50));
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(2, measured[0]);
+  TEST_ASSERT_EQUAL_UINT32(VIHCSR04_INVALID_DISTANCE_MM, distanceMm[0]);
+
+  for(uint32_t i = 0; i < 4; i++)
+    TEST_ASSERT_TRUE(VIHCSR04_PostStop(handle));
+  TEST_ASSERT_FALSE(VIHCSR04_PostStop(handle));
+  TEST_ASSERT_EQUAL(1, VIHCSR04_GetCommandOverflows());
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(2, measured[0]);
+
+  TEST_ASSERT_TRUE(VIHCSR04_PostDelete(handle));
+  VIHCSR04_Runtime();
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_HANDLE, VIHCSR04_GetHandle("A"));
+
+  // long name is cut and terminated, names are compared up to the cut
+  TEST_ASSERT_TRUE(VIHCSR04_PostCreate("HC-SR04 front left", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A, 
+    Created, &handle));
+  VIHCSR04_Runtime();
+  TEST_ASSERT_NOT_EQUAL(VIHCSR04_INVALID_HANDLE, handle);
+  TEST_ASSERT_EQUAL(VIHCSR04_NAME_LEN - 1, strlen(commands[0].name));
+  TEST_ASSERT_EQUAL(handle, VIHCSR04_GetHandle("HC-SR04 front left"));
+  TEST_ASSERT_EQUAL(handle, VIHCSR04_GetHandle("HC-SR04 front right"));
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_HANDLE, VIHCSR04_GetHandle("HC-SR04 rear"));
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_RecordReplay)
+{
+  printf("Test: VIHCSR04_RecordReplay\r\n");
+  static VIHCSR04_RecRecord_t records[8];
+  static VIHCSR04_Recorder_t recorder;
+  uint32_t recorded[8];
+  float temperature = 0;
+  uint16_t maxDistanceCm = 0;
+
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetNoise(0, 50);
+  VIHCSR04_SimSetDropout(0, 200);
+  recordingSize = 0;
+  TEST_ASSERT_TRUE(VIHCSR04_RecInit(&recorder, records, 8, WriteRecording, NULL));
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_SimGetTimeUs));
+  VIHCSR04_SetRecorder(&recorder);
+
+  VIHCSR04_Handle_t handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_CONTINUOUS_MEASURE, 21.5f, 300, DistanceMm, (const void*)0);
+
+  for(uint32_t i = 0; i < 8; i++) {
+    VIHCSR04_Runtime();
+    recorded[i] = distanceMm[0];
+    VIHCSR04_RecFlush(&recorder);
+  }
+
+  uint64_t endUs = VIHCSR04_SimGetTimeUs();
+
+  VIHCSR04_SetRecorder(NULL);
+  TEST_ASSERT_EQUAL(0, VIHCSR04_RecGetOverflows(&recorder));
+  // header, sensor, temperature, range and 8 samples
+  TEST_ASSERT_EQUAL(16 * (1 + 3 + 8), recordingSize);
+
+  // replay of truncated recording
+  TEST_ASSERT_FALSE(VIHCSR04_ReplayOpen(recording, 8));
+  TEST_ASSERT_TRUE(VIHCSR04_ReplayOpen(recording, recordingSize - 8));
+  TEST_ASSERT_TRUE(VIHCSR04_ReplayGetConfig(TST_ECHO_A, &temperature, &maxDistanceCm));
+  TEST_ASSERT_TRUE(21.5f == temperature);
+  TEST_ASSERT_EQUAL(300, maxDistanceCm);
+
+  TEST_ASSERT_TRUE(VIHCSR04_ReplayOpen(recording, recordingSize));
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_ReplayPulseIn, VIHCSR04_ReplayTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_ReplayGetTimeUs));
+  handle = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(handle,
+    VIHCSR04_CONTINUOUS_MEASURE, temperature, maxDistanceCm, DistanceMm, (const void*)0);
+
+  for(uint32_t i = 0; i < 8; i++) {
+    TEST_ASSERT_FALSE(VIHCSR04_ReplayDone());
+    VIHCSR04_Runtime();
+    TEST_ASSERT_EQUAL_UINT32(recorded[i], distanceMm[0]);
+  }
+
+  TEST_ASSERT_TRUE(VIHCSR04_ReplayDone());
+  TEST_ASSERT_EQUAL_UINT64(endUs, VIHCSR04_ReplayGetTimeUs());
+  TEST_ASSERT_EQUAL(16, measured[0]);
+}
+
+TEST(TST_VIHCSR04, VIHCSR04_Publisher)
+{
+  printf("Test: VIHCSR04_Publisher\r\n");
+  VIHCSR04_ShmReading_t reading;
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetDistance(1, 5000);
+  TEST_ASSERT_TRUE(VIHCSR04_Init(VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger));
+  TEST_ASSERT_TRUE(VIHCSR04_SetTimeCb(VIHCSR04_SimGetTimeUs));
+
+  // writer and reader map the same object, the second slot is beyond segment
+  VIHCSR04_ShmUnlink("/tst_vihcsr04");
+  VIHCSR04_ShmSegment_t* segment = VIHCSR04_ShmCreate("/tst_vihcsr04", 2);
+  TEST_ASSERT_NOT_NULL(segment);
+  const VIHCSR04_ShmSegment_t* reader = VIHCSR04_ShmOpen("/tst_vihcsr04");
+  TEST_ASSERT_NOT_NULL(reader);
+  TEST_ASSERT_TRUE(VIHCSR04_ShmUnlink("/tst_vihcsr04"));
+  TEST_ASSERT_NULL(VIHCSR04_ShmOpen("/tst_vihcsr04"));
+
+  VIHCSR04_Handle_t a = VIHCSR04_Create("A", NULL, TST_TRIGGER_A, NULL, TST_ECHO_A);
+  VIHCSR04_SetPublisher(segment);
+  VIHCSR04_Handle_t b = VIHCSR04_Create("Rear bumper", NULL, TST_TRIGGER_B, NULL, TST_ECHO_B);
+  TEST_ASSERT_EQUAL(1, VIHCSR04_ShmFind(reader, "Rear bumper"));
+  TEST_ASSERT_TRUE(VIHCSR04_ShmRead(reader, 0, &reading));
+  TEST_ASSERT_EQUAL(a, reading.handle);
+  TEST_ASSERT_EQUAL_STRING("A", reading.name);
+  TEST_ASSERT_EQUAL(VIHCSR04_SHM_NONE, reading.status);
+  TEST_ASSERT_FALSE(VIHCSR04_ShmRead(reader, 2, &reading));
+
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(a,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)0);
+  VIHCSR04_MeasureDistanceMmAsyncByHandle(b,
+    VIHCSR04_CONTINUOUS_MEASURE, 20, 400, DistanceMm, (const void*)1);
+  for(uint32_t i = 0; i < 4; i++)
+    VIHCSR04_Runtime();
+
+  TEST_ASSERT_TRUE(VIHCSR04_ShmRead(reader, 0, &reading));
+  TEST_ASSERT_EQUAL(VIHCSR04_SHM_VALID, reading.status);
+  TEST_ASSERT_EQUAL(2, reading.results);
+  TEST_ASSERT_EQUAL(distanceMm[0], reading.distanceMm);
+  TEST_ASSERT_TRUE(0 < reading.timestampUs && VIHCSR04_SimGetTimeUs() >= reading.timestampUs);
+  TEST_ASSERT_TRUE(VIHCSR04_ShmRead(reader, 1, &reading));
+  TEST_ASSERT_EQUAL(VIHCSR04_SHM_TIMEOUT, reading.status);
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_DISTANCE_MM, reading.distanceMm);
+
+  // deleted sensor frees its slot
+  TEST_ASSERT_TRUE(VIHCSR04_DeleteByHandle(b));
+  TEST_ASSERT_EQUAL(-1, VIHCSR04_ShmFind(reader, "Rear bumper"));
+  TEST_ASSERT_TRUE(VIHCSR04_ShmRead(reader, 1, &reading));
+  TEST_ASSERT_EQUAL(VIHCSR04_INVALID_HANDLE, reading.handle);
+
+  VIHCSR04_ShmClose(reader);
+  VIHCSR04_ShmClose(segment);
+}
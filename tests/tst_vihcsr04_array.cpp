@@ -0,0 +1,182 @@
+#include "unity.h"
+#include "unity_fixture.h"
+#include "vihcsr04_array.hpp"
+#include "vihcsr04_sim.h"
+#include <cstdio>
+
+#define TST_TRIGGER_A 1
+#define TST_ECHO_A 11
+#define TST_TRIGGER_B 2
+#define TST_ECHO_B 12
+
+static uint32_t distanceMm[2];
+static uint32_t measured[2];
+
+/**
+ * @brief Gpio interface of simulated sensors, results are stored per index
+ *
+ */
+struct SimIo {
+  static void Trigger(uintptr_t port, uint16_t pin) {
+    VIHCSR04_SimTrigger((const void*)port, pin, 1, 10, nullptr);
+  }
+  static uint32_t PulseIn(uintptr_t port, uint16_t pin, uint32_t timeoutUs) {
+    return (uint32_t)VIHCSR04_SimPulseIn((const void*)port, pin, 1, (uint64_t)timeoutUs * 1000, nullptr);
+  }
+  static uint64_t NowUs(void) {
+    return VIHCSR04_SimGetTimeUs();
+  }
+  static void Distance(size_t index, uint32_t mm) {
+    distanceMm[index] = mm;
+    measured[index]++;
+  }
+};
+
+typedef vihcsr04::Hcsr04Array<2, SimIo> BlockingArray_t;
+typedef vihcsr04::Hcsr04Array<2, SimIo, true> EdgeArray_t;
+
+static constexpr std::array<vihcsr04::ArrayPins_t, 2> pins{{
+  {0, TST_TRIGGER_A, 0, TST_ECHO_A}, {0, TST_TRIGGER_B, 0, TST_ECHO_B}}};
+
+// arrays are constructed at compile time
+constinit static BlockingArray_t blockingArray{pins};
+constinit static EdgeArray_t edgeArray{pins};
+
+static_assert(2 == BlockingArray_t::Size());
+static_assert(1 == [] { BlockingArray_t array{pins}; return array.FindByEcho(0, TST_ECHO_B); }());
+static_assert(2 == [] { EdgeArray_t array{pins}; return array.FindByEcho(0, TST_TRIGGER_B); }());
+// sync measurement is not available in edge driven mode
+template<typename Array>
+concept SyncMeasure = requires(Array& array) { array.MeasureDistanceMm(0, 20.0f, 400); };
+static_assert(SyncMeasure<BlockingArray_t> && !SyncMeasure<EdgeArray_t>);
+
+static void EchoEdge(const void* echoPort, uint16_t echoPin, uint8_t level, uint64_t timeUs) {
+  edgeArray.EchoEdge(edgeArray.FindByEcho((uintptr_t)echoPort, echoPin), level, timeUs);
+}
+
+static void RunEdgeDriven(uint32_t count) {
+  for (uint32_t i = 0; i < 100000 && measured[0] + measured[1] < count; i++) {
+    edgeArray.Runtime();
+    VIHCSR04_SimAdvance(10);
+  }
+}
+
+TEST_GROUP(TST_VIHCSR04ARRAY);
+
+// runner is called by main.c
+extern "C" void TEST_TST_VIHCSR04ARRAY_GROUP_RUNNER(void);
+
+TEST_GROUP_RUNNER(TST_VIHCSR04ARRAY) {
+  RUN_TEST_CASE(TST_VIHCSR04ARRAY, VIHCSR04_ArrayBlocking);
+  RUN_TEST_CASE(TST_VIHCSR04ARRAY, VIHCSR04_ArrayEdgeDriven);
+}
+
+TEST_SETUP(TST_VIHCSR04ARRAY) {
+  VIHCSR04_SimInit(1);
+  VIHCSR04_SimAddSensor(nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  VIHCSR04_SimAddSensor(nullptr, TST_TRIGGER_B, nullptr, TST_ECHO_B);
+  distanceMm[0] = distanceMm[1] = 0;
+  measured[0] = measured[1] = 0;
+}
+
+TEST_TEAR_DOWN(TST_VIHCSR04ARRAY) {
+  VIHCSR04_SimSetEdgeCb(nullptr);
+  for (size_t i = 0; i < 2; i++) {
+    blockingArray.StopContinuousMeasure(i);
+    edgeArray.StopContinuousMeasure(i);
+  }
+}
+
+TEST(TST_VIHCSR04ARRAY, VIHCSR04_ArrayBlocking)
+{
+  printf("Test: VIHCSR04_ArrayBlocking\r\n");
+  VIHCSR04_FilterCfg_t cfg = {};
+  VIHCSR04_SimSetDistance(0, 1000);
+  VIHCSR04_SimSetDistance(1, 500);
+
+  TEST_ASSERT_FALSE(blockingArray.MeasureDistanceMmAsync(2, BlockingArray_t::CONTINUOUS_MEASURE, 20, 400));
+  TEST_ASSERT_FALSE(blockingArray.SetFilter(2, cfg));
+  TEST_ASSERT_TRUE(blockingArray.MeasureDistanceMmAsync(0, BlockingArray_t::CONTINUOUS_MEASURE, 20, 400));
+  TEST_ASSERT_TRUE(blockingArray.MeasureDistanceMmAsync(1, BlockingArray_t::ONESHOT_MEASURE, 20, 400));
+
+  // one sensor per runtime, one shot sensor takes one turn
+  blockingArray.Runtime();
+  blockingArray.Runtime();
+  blockingArray.Runtime();
+  blockingArray.Runtime();
+
+  TEST_ASSERT_EQUAL(3, measured[0]);
+  TEST_ASSERT_EQUAL(1, measured[1]);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 500, distanceMm[1]);
+  TEST_ASSERT_EQUAL(3, VIHCSR04_SimGetTriggerCount(0));
+  TEST_ASSERT_EQUAL(1, VIHCSR04_SimGetTriggerCount(1));
+
+  // sync measurement does not start async one and does not deliver result
+  TEST_ASSERT_UINT32_WITHIN(1, 500, blockingArray.MeasureDistanceMm(1, 20, 400));
+  TEST_ASSERT_EQUAL_UINT32(BlockingArray_t::INVALID_DISTANCE_MM, blockingArray.MeasureDistanceMm(2, 20, 400));
+  TEST_ASSERT_EQUAL(1, measured[1]);
+  blockingArray.Runtime();
+  TEST_ASSERT_EQUAL(4, measured[0]);
+  TEST_ASSERT_EQUAL(1, measured[1]);
+
+  // echo beyond maximal distance
+  VIHCSR04_SimSetDistance(0, 5000);
+  blockingArray.Runtime();
+  TEST_ASSERT_EQUAL(5, measured[0]);
+  TEST_ASSERT_EQUAL_UINT32(BlockingArray_t::INVALID_DISTANCE_MM, distanceMm[0]);
+
+  // median of 3 suppresses a single spike
+  cfg.stages = VIHCSR04_FILTER_MEDIAN;
+  cfg.medianWindow = 3;
+  TEST_ASSERT_TRUE(blockingArray.SetFilter(0, cfg));
+  TEST_ASSERT_TRUE(blockingArray.MeasureDistanceMmAsync(0, BlockingArray_t::CONTINUOUS_MEASURE, 20, 400));
+  VIHCSR04_SimSetDistance(0, 800);
+  blockingArray.Runtime();
+  blockingArray.Runtime();
+  VIHCSR04_SimSetDistance(0, 1200);
+  blockingArray.Runtime();
+  TEST_ASSERT_EQUAL(8, measured[0]);
+  TEST_ASSERT_UINT32_WITHIN(1, 800, distanceMm[0]);
+
+  blockingArray.StopContinuousMeasure(0);
+  blockingArray.Runtime();
+  TEST_ASSERT_EQUAL(8, measured[0]);
+}
+
+TEST(TST_VIHCSR04ARRAY, VIHCSR04_ArrayEdgeDriven)
+{
+  printf("Test: VIHCSR04_ArrayEdgeDriven\r\n");
+  VIHCSR04_SimSetDistance(0, 1500);
+  VIHCSR04_SimSetDistance(1, 700);
+  VIHCSR04_SimSetEdgeCb(EchoEdge);
+
+  TEST_ASSERT_TRUE(edgeArray.MeasureDistanceMmAsync(0, EdgeArray_t::CONTINUOUS_MEASURE, 20, 400));
+  TEST_ASSERT_TRUE(edgeArray.MeasureDistanceMmAsync(1, EdgeArray_t::CONTINUOUS_MEASURE, 20, 400));
+
+  RunEdgeDriven(4);
+
+  // sensors are measured one after another
+  TEST_ASSERT_EQUAL(2, measured[0]);
+  TEST_ASSERT_EQUAL(2, measured[1]);
+  TEST_ASSERT_UINT32_WITHIN(2, 1500, distanceMm[0]);
+  TEST_ASSERT_UINT32_WITHIN(2, 700, distanceMm[1]);
+
+  // missing echo is reported after timeout of maximal distance
+  VIHCSR04_SimSetDropout(1, 1000);
+  RunEdgeDriven(6);
+  TEST_ASSERT_EQUAL(3, measured[0]);
+  TEST_ASSERT_EQUAL(3, measured[1]);
+  TEST_ASSERT_EQUAL_UINT32(EdgeArray_t::INVALID_DISTANCE_MM, distanceMm[1]);
+
+  // edges of unknown sensor are ignored
+  edgeArray.EchoEdge(2, 1, VIHCSR04_SimGetTimeUs());
+
+  // stopped sensors finish the running ping and are not triggered again
+  edgeArray.StopContinuousMeasure(0);
+  edgeArray.StopContinuousMeasure(1);
+  uint32_t triggers = VIHCSR04_SimGetTriggerCount(0) + VIHCSR04_SimGetTriggerCount(1);
+  RunEdgeDriven(UINT32_MAX);
+  TEST_ASSERT_EQUAL(triggers, VIHCSR04_SimGetTriggerCount(0) + VIHCSR04_SimGetTriggerCount(1));
+  TEST_ASSERT_LESS_OR_EQUAL(7, measured[0] + measured[1]);
+}
@@ -0,0 +1,212 @@
+#include "unity.h"
+#include "unity_fixture.h"
+#include "vihcsr04_coro.hpp"
+#include "vihcsr04_sim.h"
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#define TST_TRIGGER_A 1
+#define TST_ECHO_A 11
+
+static vihcsr04::Hcsr04Sensor* edgeDriver;
+
+static void EchoEdge(const void* echoPort, uint16_t echoPin, uint8_t level, uint64_t timeUs) {
+  edgeDriver->EchoEdge(echoPort, echoPin, level, timeUs);
+}
+
+static vihcsr04::Task MeasureOnce(vihcsr04::Hcsr04Coro& coro, vihcsr04::Handle_t handle,
+  uint32_t& distanceMm) {
+  distanceMm = co_await coro.Measure(handle, 20, 400);
+}
+
+static vihcsr04::Task Collect(vihcsr04::Hcsr04Coro::Stream& stream,
+  std::vector<uint32_t>& values, size_t count) {
+  while (values.size() < count)
+    values.push_back(co_await stream.Next());
+}
+
+TEST_GROUP(TST_VIHCSR04CORO);
+
+// runner is called by main.c
+extern "C" void TEST_TST_VIHCSR04CORO_GROUP_RUNNER(void);
+
+TEST_GROUP_RUNNER(TST_VIHCSR04CORO) {
+  RUN_TEST_CASE(TST_VIHCSR04CORO, VIHCSR04_SharedMeasure);
+  RUN_TEST_CASE(TST_VIHCSR04CORO, VIHCSR04_StreamOverflow);
+  RUN_TEST_CASE(TST_VIHCSR04CORO, VIHCSR04_StreamDestroyedMidPing);
+  RUN_TEST_CASE(TST_VIHCSR04CORO, VIHCSR04_MeasureWithStream);
+}
+
+TEST_SETUP(TST_VIHCSR04CORO) {
+  VIHCSR04_SimInit(1);
+  VIHCSR04_SimAddSensor(nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+}
+
+TEST_TEAR_DOWN(TST_VIHCSR04CORO) {
+  VIHCSR04_SimSetEdgeCb(nullptr);
+  edgeDriver = nullptr;
+}
+
+TEST(TST_VIHCSR04CORO, VIHCSR04_SharedMeasure)
+{
+  printf("Test: VIHCSR04_SharedMeasure\r\n");
+  uint32_t first = 0;
+  uint32_t second = 0;
+  VIHCSR04_SimSetDistance(0, 1000);
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+  vihcsr04::Hcsr04Coro coro{sensors};
+  auto handle = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+
+  // both coroutines wait for one measurement
+  auto a = MeasureOnce(coro, handle, first);
+  auto b = MeasureOnce(coro, handle, second);
+  TEST_ASSERT_EQUAL(1, coro.Pending());
+  TEST_ASSERT_FALSE(a.Done());
+  TEST_ASSERT_FALSE(b.Done());
+
+  TEST_ASSERT_EQUAL(2, coro.Poll());
+  TEST_ASSERT_TRUE(a.Done());
+  TEST_ASSERT_TRUE(b.Done());
+  TEST_ASSERT_EQUAL(0, coro.Pending());
+  TEST_ASSERT_EQUAL(1, VIHCSR04_SimGetTriggerCount(0));
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, first);
+  TEST_ASSERT_EQUAL_UINT32(first, second);
+
+  // one shot measurement is done
+  TEST_ASSERT_EQUAL(0, coro.Poll());
+  TEST_ASSERT_EQUAL(1, VIHCSR04_SimGetTriggerCount(0));
+
+  // unknown sensor is reported immediately
+  uint32_t invalid = 0;
+  auto c = MeasureOnce(coro, vihcsr04::INVALID_HANDLE, invalid);
+  TEST_ASSERT_TRUE(c.Done());
+  TEST_ASSERT_EQUAL_UINT32(vihcsr04::INVALID_DISTANCE_MM, invalid);
+}
+
+TEST(TST_VIHCSR04CORO, VIHCSR04_StreamOverflow)
+{
+  printf("Test: VIHCSR04_StreamOverflow\r\n");
+  constexpr size_t extra = 3;
+  std::vector<uint32_t> values;
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+  vihcsr04::Hcsr04Coro coro{sensors};
+  auto handle = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+
+  vihcsr04::Hcsr04Coro::Stream stream{coro, handle, 20, 400};
+  TEST_ASSERT_TRUE(stream.IsValid());
+
+  // every blocking poll is one ping with own distance
+  for (size_t i = 0; i < vihcsr04::Hcsr04Coro::Stream::MAX_QUEUED + extra; i++) {
+    VIHCSR04_SimSetDistance(0, 500 + 10 * i);
+    TEST_ASSERT_EQUAL(0, coro.Poll());
+  }
+
+  // queued results are taken without suspension, the oldest ones are dropped
+  auto task = Collect(stream, values, vihcsr04::Hcsr04Coro::Stream::MAX_QUEUED + 1);
+  TEST_ASSERT_FALSE(task.Done());
+  TEST_ASSERT_EQUAL(vihcsr04::Hcsr04Coro::Stream::MAX_QUEUED, values.size());
+  for (size_t i = 0; i < values.size(); i++)
+    TEST_ASSERT_UINT32_WITHIN(1, 500 + 10 * (i + extra), values[i]);
+
+  VIHCSR04_SimSetDistance(0, 2000);
+  TEST_ASSERT_EQUAL(1, coro.Poll());
+  TEST_ASSERT_TRUE(task.Done());
+  TEST_ASSERT_UINT32_WITHIN(1, 2000, values.back());
+}
+
+TEST(TST_VIHCSR04CORO, VIHCSR04_StreamDestroyedMidPing)
+{
+  printf("Test: VIHCSR04_StreamDestroyedMidPing\r\n");
+  vihcsr04::Sample_t samples[4];
+  VIHCSR04_SimSetDistance(0, 1500);
+  VIHCSR04_SimSetEdgeCb(EchoEdge);
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs};
+  edgeDriver = &sensors;
+  TEST_ASSERT_TRUE(sensors.SetSampleBuffer(4));
+  vihcsr04::Hcsr04Coro coro{sensors};
+  auto handle = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+
+  // storage of stream is poisoned after destruction, late result would crash
+  alignas(vihcsr04::Hcsr04Coro::Stream) unsigned char storage[sizeof(vihcsr04::Hcsr04Coro::Stream)];
+  auto* stream = new (storage) vihcsr04::Hcsr04Coro::Stream{coro, handle, 20, 400};
+  TEST_ASSERT_TRUE(stream->IsValid());
+
+  coro.Poll();
+  TEST_ASSERT_EQUAL(1, VIHCSR04_SimGetTriggerCount(0));
+  TEST_ASSERT_EQUAL(0, sensors.DrainSamples(samples, 4));
+
+  // ping is running while stream is destroyed
+  stream->~Stream();
+  memset(storage, 0xA5, sizeof(storage));
+
+  size_t count = 0;
+  for (uint32_t i = 0; i < 10000 && 0 == count; i++) {
+    coro.Poll();
+    VIHCSR04_SimAdvance(10);
+    count = sensors.DrainSamples(samples, 4);
+  }
+
+  // running ping is completed, the stopped sensor is not triggered again
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_UINT32_WITHIN(2, 1500, samples[0].distanceMm);
+  for (uint32_t i = 0; i < 1000; i++) {
+    coro.Poll();
+    VIHCSR04_SimAdvance(10);
+  }
+  TEST_ASSERT_EQUAL(1, VIHCSR04_SimGetTriggerCount(0));
+
+  // sensor can be streamed again
+  vihcsr04::Hcsr04Coro::Stream again{coro, handle, 20, 400};
+  TEST_ASSERT_TRUE(again.IsValid());
+}
+
+TEST(TST_VIHCSR04CORO, VIHCSR04_MeasureWithStream)
+{
+  printf("Test: VIHCSR04_MeasureWithStream\r\n");
+  std::vector<uint32_t> values;
+  uint32_t distanceMm = 0;
+  VIHCSR04_SimSetDistance(0, 1000);
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+  vihcsr04::Hcsr04Coro coro{sensors};
+  auto handle = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+
+  {
+    vihcsr04::Hcsr04Coro::Stream stream{coro, handle, 20, 400};
+    TEST_ASSERT_TRUE(stream.IsValid());
+    // second stream of the same sensor is rejected
+    vihcsr04::Hcsr04Coro::Stream second{coro, handle, 20, 400};
+    TEST_ASSERT_FALSE(second.IsValid());
+
+    // single measurement does not take over the callback of stream
+    auto task = MeasureOnce(coro, handle, distanceMm);
+    TEST_ASSERT_TRUE(task.Done());
+    TEST_ASSERT_EQUAL_UINT32(vihcsr04::INVALID_DISTANCE_MM, distanceMm);
+    TEST_ASSERT_EQUAL(0, coro.Pending());
+
+    auto collect = Collect(stream, values, 2);
+    coro.Poll();
+    coro.Poll();
+    coro.Poll();
+    TEST_ASSERT_TRUE(collect.Done());
+    TEST_ASSERT_UINT32_WITHIN(1, 1000, values[1]);
+  }
+
+  // pending single measurement rejects stream
+  auto task = MeasureOnce(coro, handle, distanceMm);
+  TEST_ASSERT_FALSE(task.Done());
+  {
+    vihcsr04::Hcsr04Coro::Stream stream{coro, handle, 20, 400};
+    TEST_ASSERT_FALSE(stream.IsValid());
+  }
+
+  coro.Poll();
+  coro.Poll();
+  TEST_ASSERT_TRUE(task.Done());
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm);
+}
@@ -0,0 +1,340 @@
+#include "unity.h"
+#include "unity_fixture.h"
+#include "vihcsr04.hpp"
+#include "vihcsr04_sim.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#define TST_TRIGGER_A 1
+#define TST_ECHO_A 11
+
+// engine workers allocate concurrently
+static std::atomic<size_t> allocations;
+static uint32_t distanceMm;
+static uint32_t measured;
+
+// every heap allocation of the test binary is counted
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+// bus of the driver points into the driver itself
+static_assert(!std::is_copy_constructible_v<vihcsr04::Hcsr04Sensor> && 
+  !std::is_move_constructible_v<vihcsr04::Hcsr04Sensor> && 
+  !std::is_copy_assignable_v<vihcsr04::Hcsr04Sensor> && 
+  !std::is_move_assignable_v<vihcsr04::Hcsr04Sensor>);
+
+static vihcsr04::Hcsr04Sensor* edgeDriver;
+
+static void DistanceMm(uint32_t mm, const void*) {
+  distanceMm = mm;
+  measured++;
+}
+
+static void EchoEdge(const void* echoPort, uint16_t echoPin, uint8_t level, uint64_t timeUs) {
+  edgeDriver->EchoEdge(echoPort, echoPin, level, timeUs);
+}
+
+// sync measurement in edge driven mode waits on time source, every read moves simulation
+static uint64_t Tick(void) {
+  VIHCSR04_SimAdvance(10);
+  return VIHCSR04_SimGetTimeUs();
+}
+
+TEST_GROUP(TST_VIHCSR04CPP);
+
+// runner is called by main.c
+extern "C" void TEST_TST_VIHCSR04CPP_GROUP_RUNNER(void);
+
+TEST_GROUP_RUNNER(TST_VIHCSR04CPP) {
+  RUN_TEST_CASE(TST_VIHCSR04CPP, VIHCSR04_NoAllocations);
+  RUN_TEST_CASE(TST_VIHCSR04CPP, VIHCSR04_EdgeStorage);
+  RUN_TEST_CASE(TST_VIHCSR04CPP, VIHCSR04_EdgeGroups);
+  RUN_TEST_CASE(TST_VIHCSR04CPP, VIHCSR04_Handles);
+  RUN_TEST_CASE(TST_VIHCSR04CPP, VIHCSR04_Samples);
+  RUN_TEST_CASE(TST_VIHCSR04CPP, VIHCSR04_SyncMeasure);
+}
+
+TEST_SETUP(TST_VIHCSR04CPP) {
+  VIHCSR04_SimInit(1);
+  VIHCSR04_SimAddSensor(nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  distanceMm = 0;
+  measured = 0;
+}
+
+TEST_TEAR_DOWN(TST_VIHCSR04CPP) {
+  VIHCSR04_SimSetEdgeCb(nullptr);
+  edgeDriver = nullptr;
+}
+
+TEST(TST_VIHCSR04CPP, VIHCSR04_NoAllocations)
+{
+  printf("Test: VIHCSR04_NoAllocations\r\n");
+  vihcsr04::Sample_t samples[4];
+  vihcsr04::LogRecord_t records[16];
+  vihcsr04::Stats_t stats;
+  VIHCSR04_SimSetDistance(0, 1000);
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+  TEST_ASSERT_TRUE(sensors.SetTimeCb(VIHCSR04_SimGetTimeUs));
+  TEST_ASSERT_TRUE(sensors.SetSampleBuffer(4));
+  TEST_ASSERT_TRUE(sensors.SetLogBuffer(16));
+  sensors.SetDebugLvl(vihcsr04::DEBUG_TRACE);
+  // name longer than small string buffer
+  vihcsr04::Handle_t handle = sensors.AddSensor("HC-SR04 front left",
+    nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, handle);
+  TEST_ASSERT_TRUE(sensors.MeasureDistanceMmAsync(handle,
+    vihcsr04::CONTINUOUS_MEASURE, 20, 400, DistanceMm, nullptr));
+
+  // steady state: lookup by literal, sync and async measurements, draining
+  allocations = 0;
+
+  for (uint32_t i = 0; i < 10; i++) {
+    sensors.Runtime();
+    sensors.DrainSamples(samples, 4);
+    sensors.DrainLog(records, 16);
+  }
+  TEST_ASSERT_EQUAL(handle, sensors.GetHandle("HC-SR04 front left"));
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, sensors.MeasureDistanceMm(handle, 20, 200));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, sensors.MeasureDistance("HC-SR04 front left", 20, 200));
+  TEST_ASSERT_TRUE(sensors.SetPeriod("HC-SR04 front left", 50000));
+  sensors.RuntimeUntil(0);
+  TEST_ASSERT_TRUE(sensors.GetStats("HC-SR04 front left", stats));
+  sensors.StopContinuousMeasure("HC-SR04 front left");
+
+  TEST_ASSERT_EQUAL(0, allocations);
+
+  // sync measurements don't report to callback of async measurement
+  TEST_ASSERT_EQUAL(10, measured);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, distanceMm);
+  TEST_ASSERT_EQUAL(10, stats.pings);
+}
+
+TEST(TST_VIHCSR04CPP, VIHCSR04_EdgeStorage)
+{
+  printf("Test: VIHCSR04_EdgeStorage\r\n");
+  VIHCSR04_SimSetDistance(0, 1000);
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs, 3};
+  edgeDriver = &sensors;
+  VIHCSR04_SimSetEdgeCb(EchoEdge);
+
+  vihcsr04::Handle_t handle = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  TEST_ASSERT_TRUE(sensors.MeasureDistanceMmAsync(handle,
+    vihcsr04::ONESHOT_MEASURE, 20, 400, DistanceMm, nullptr));
+  sensors.Runtime();
+
+  // sensors added during a measurement don't move the measured one
+  char name[] = "X";
+  for (uint32_t i = 1; i < 3; i++) {
+    name[0] = (char)('B' + i);
+    TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, 
+      sensors.AddSensor(name, nullptr, (uint16_t)(20 + i), nullptr, (uint16_t)(30 + i)));
+  }
+  TEST_ASSERT_EQUAL(vihcsr04::INVALID_HANDLE, 
+    sensors.AddSensor("full", nullptr, 40, nullptr, 41));
+
+  for (uint32_t i = 0; i < 1000 && 0 == measured; i++) {
+    VIHCSR04_SimAdvance(10);
+    sensors.Runtime();
+  }
+
+  TEST_ASSERT_EQUAL(1, measured);
+  TEST_ASSERT_UINT32_WITHIN(2, 1000, distanceMm);
+}
+
+TEST(TST_VIHCSR04CPP, VIHCSR04_EdgeGroups)
+{
+  printf("Test: VIHCSR04_EdgeGroups\r\n");
+  static uint32_t results[6];
+  vihcsr04::Handle_t handles[6];
+
+  // default capacity doesn't depend on VIHCSR04_MAX_SENSORS of the c realisation
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimTrigger, VIHCSR04_SimGetTimeUs};
+  edgeDriver = &sensors;
+  VIHCSR04_SimSetEdgeCb(EchoEdge);
+  TEST_ASSERT_GREATER_THAN(VIHCSR04_MAX_SENSORS, 6);
+
+  char name[] = "X";
+  for (uint32_t i = 0; i < 6; i++) {
+    if (0 < i)
+      VIHCSR04_SimAddSensor(nullptr, (uint16_t)(20 + i), nullptr, (uint16_t)(30 + i));
+    VIHCSR04_SimSetDistance(i, 500 + 100 * i);
+    results[i] = 0;
+
+    name[0] = (char)('A' + i);
+    handles[i] = (0 == i) ? 
+      sensors.AddSensor(name, nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A) :
+      sensors.AddSensor(name, nullptr, (uint16_t)(20 + i), nullptr, (uint16_t)(30 + i));
+    TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, handles[i]);
+    // two groups of three sensors measured simultaneously
+    TEST_ASSERT_TRUE(sensors.SetFiringGroup(handles[i], i % 2));
+    TEST_ASSERT_TRUE(sensors.MeasureDistanceMmAsync(handles[i], vihcsr04::ONESHOT_MEASURE, 20, 400, 
+      [](uint32_t mm, const void* context) { *(uint32_t*)const_cast<void*>(context) = mm; }, 
+      &results[i]));
+  }
+
+  for (uint32_t i = 0; i < 10000; i++) {
+    VIHCSR04_SimAdvance(10);
+    sensors.Runtime();
+  }
+
+  for (uint32_t i = 0; i < 6; i++) {
+    TEST_ASSERT_UINT32_WITHIN(2, 500 + 100 * i, results[i]);
+    TEST_ASSERT_EQUAL(1, VIHCSR04_SimGetTriggerCount(i));
+  }
+}
+
+TEST(TST_VIHCSR04CPP, VIHCSR04_Handles)
+{
+  printf("Test: VIHCSR04_Handles (c++)\r\n");
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+
+  vihcsr04::Handle_t a = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, a);
+  TEST_ASSERT_EQUAL(a, sensors.GetHandle("A"));
+
+  // handle 0 doesn't address the sensor of slot 0
+  TEST_ASSERT_EQUAL(0, a & 0xFFFF);
+  TEST_ASSERT_FALSE(sensors.MeasureDistanceMmAsync(vihcsr04::INVALID_HANDLE,
+    vihcsr04::ONESHOT_MEASURE, 20, 400, DistanceMm, nullptr));
+  TEST_ASSERT_FALSE(sensors.DeleteSensor(vihcsr04::INVALID_HANDLE));
+
+  // handle becomes stale by delete
+  TEST_ASSERT_TRUE(sensors.DeleteSensor(a));
+  TEST_ASSERT_FALSE(sensors.DeleteSensor(a));
+  TEST_ASSERT_EQUAL(vihcsr04::INVALID_HANDLE, sensors.GetHandle("A"));
+
+  // reused slot gets a new generation, stale handle doesn't address the new sensor
+  vihcsr04::Handle_t b = sensors.AddSensor("B", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  TEST_ASSERT_EQUAL(a & 0xFFFF, b & 0xFFFF);
+  TEST_ASSERT_NOT_EQUAL(a, b);
+  TEST_ASSERT_FALSE(sensors.MeasureDistanceMmAsync(a,
+    vihcsr04::ONESHOT_MEASURE, 20, 400, DistanceMm, nullptr));
+  TEST_ASSERT_TRUE(sensors.MeasureDistanceMmAsync(b,
+    vihcsr04::ONESHOT_MEASURE, 20, 400, DistanceMm, nullptr));
+
+  // generation wraps around after 0xFFFF reuses, generation 0 is skipped
+  vihcsr04::Handle_t handle = b;
+  for (uint32_t i = 0; i < 0xFFFF; i++) {
+    TEST_ASSERT_TRUE(sensors.DeleteSensor(handle));
+    handle = sensors.AddSensor("B", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+    TEST_ASSERT_NOT_EQUAL(0, handle >> 16);
+  }
+  TEST_ASSERT_EQUAL(b, handle);
+
+  // lowest free slot is reused first, as in c realisation
+  vihcsr04::Handle_t c = sensors.AddSensor("C", nullptr, 2, nullptr, 12);
+  vihcsr04::Handle_t d = sensors.AddSensor("D", nullptr, 3, nullptr, 13);
+  TEST_ASSERT_TRUE(sensors.DeleteSensor(c));
+  TEST_ASSERT_TRUE(sensors.DeleteSensor(handle));
+  TEST_ASSERT_EQUAL(0, sensors.AddSensor("E", nullptr, 4, nullptr, 14) & 0xFFFF);
+  TEST_ASSERT_EQUAL(1, sensors.AddSensor("F", nullptr, 5, nullptr, 15) & 0xFFFF);
+  TEST_ASSERT_EQUAL(2, d & 0xFFFF);
+}
+
+TEST(TST_VIHCSR04CPP, VIHCSR04_Samples)
+{
+  printf("Test: VIHCSR04_Samples (c++)\r\n");
+  vihcsr04::Sample_t samples[8];
+  VIHCSR04_SimSetDistance(0, 1000);
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+  TEST_ASSERT_TRUE(sensors.SetTimeCb(VIHCSR04_SimGetTimeUs));
+  TEST_ASSERT_FALSE(sensors.SetSampleBuffer(3));
+  TEST_ASSERT_TRUE(sensors.SetSampleBuffer(4));
+
+  vihcsr04::Handle_t handle = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  sensors.MeasureDistanceMmAsync(handle, vihcsr04::CONTINUOUS_MEASURE, 20, 400, DistanceMm, nullptr);
+
+  for (uint32_t i = 0; i < 3; i++)
+    sensors.Runtime();
+  TEST_ASSERT_EQUAL(2, sensors.DrainSamples(samples, 2));
+  TEST_ASSERT_EQUAL(1, sensors.DrainSamples(samples, 8));
+  TEST_ASSERT_EQUAL(handle, samples[0].handle);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, samples[0].distanceMm);
+
+  // consumer falls behind: full buffer keeps the oldest samples and counts dropped ones
+  for (uint32_t i = 0; i < 6; i++)
+    sensors.Runtime();
+  TEST_ASSERT_EQUAL(2, sensors.GetSampleOverflows());
+  TEST_ASSERT_EQUAL(4, sensors.DrainSamples(samples, 8));
+  TEST_ASSERT_LESS_THAN(VIHCSR04_SimGetTimeUs(), samples[3].timestampUs);
+  TEST_ASSERT_EQUAL(0, sensors.DrainSamples(samples, 8));
+}
+
+TEST(TST_VIHCSR04CPP, VIHCSR04_SyncMeasure)
+{
+  printf("Test: VIHCSR04_SyncMeasure (c++)\r\n");
+  vihcsr04::Sample_t samples[4];
+  vihcsr04::Stats_t stats;
+  VIHCSR04_Conversion_t conv;
+  VIHCSR04_SimSetDistance(0, 2500);
+
+  vihcsr04::Hcsr04Sensor sensors{VIHCSR04_SimPulseIn, VIHCSR04_SimTrigger};
+  TEST_ASSERT_TRUE(sensors.SetTimeCb(VIHCSR04_SimGetTimeUs));
+  TEST_ASSERT_TRUE(sensors.SetSampleBuffer(4));
+  vihcsr04::Handle_t handle = sensors.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  TEST_ASSERT_TRUE(sensors.MeasureDistanceMmAsync(handle,
+    vihcsr04::CONTINUOUS_MEASURE, 20, 400, DistanceMm, nullptr));
+
+  // result is returned only, range of the call applies
+  TEST_ASSERT_EQUAL_UINT32(vihcsr04::INVALID_DISTANCE_MM, sensors.MeasureDistanceMm(handle, 20, 200));
+  VIHCSR04_SimSetDistance(0, 1000);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, sensors.MeasureDistanceMm(handle, 20, 200));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, sensors.MeasureDistance("A", 20, 200));
+  TEST_ASSERT_EQUAL(0, measured);
+  TEST_ASSERT_EQUAL(0, sensors.DrainSamples(samples, 4));
+  TEST_ASSERT_TRUE(sensors.GetStats(handle, stats));
+  TEST_ASSERT_EQUAL(0, stats.pings);
+  TEST_ASSERT_EQUAL_UINT32(vihcsr04::INVALID_DISTANCE_MM, 
+    sensors.MeasureDistanceMm(vihcsr04::INVALID_HANDLE, 20, 200));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -1.0f, sensors.MeasureDistance("B", 20, 200));
+
+  // async measurement keeps its range and callback
+  VIHCSR04_SimSetDistance(0, 2500);
+  sensors.Runtime();
+  TEST_ASSERT_EQUAL(1, measured);
+  TEST_ASSERT_UINT32_WITHIN(1, 2500, distanceMm);
+  TEST_ASSERT_EQUAL(1, sensors.DrainSamples(samples, 4));
+
+  // edge driven mode
+  vihcsr04::Hcsr04Sensor edge{VIHCSR04_SimTrigger, Tick};
+  edgeDriver = &edge;
+  VIHCSR04_SimSetEdgeCb(EchoEdge);
+  handle = edge.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  TEST_ASSERT_UINT32_WITHIN(2, 2500, edge.MeasureDistanceMm(handle, 20, 400));
+
+  // echo without falling edge ends the wait at echo timeout
+  VIHCSR04_ConversionInit(&conv, 20, 400);
+  VIHCSR04_SimSetDropout(0, 1000);
+  uint64_t start = VIHCSR04_SimGetTimeUs();
+  TEST_ASSERT_EQUAL_UINT32(vihcsr04::INVALID_DISTANCE_MM, edge.MeasureDistanceMm(handle, 20, 400));
+  TEST_ASSERT_UINT32_WITHIN(30, VIHCSR04_SIM_BURST_US + conv.maxEchoUs, 
+    (uint32_t)(VIHCSR04_SimGetTimeUs() - start));
+
+  // sensor is idle, async measurement starts after the echo has ended
+  VIHCSR04_SimSetDropout(0, 0);
+  VIHCSR04_SimAdvance(VIHCSR04_SIM_NO_ECHO_US);
+  TEST_ASSERT_TRUE(edge.MeasureDistanceMmAsync(handle,
+    vihcsr04::ONESHOT_MEASURE, 20, 400, DistanceMm, nullptr));
+  for (uint32_t i = 0; i < 10000 && 1 == measured; i++)
+    edge.Runtime();
+  TEST_ASSERT_EQUAL(2, measured);
+  TEST_ASSERT_UINT32_WITHIN(2, 2500, distanceMm);
+}
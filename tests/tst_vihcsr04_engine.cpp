@@ -0,0 +1,291 @@
+#include "unity.h"
+#include "unity_fixture.h"
+#include "vihcsr04_engine.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#define TST_TRIGGER_A 1
+#define TST_ECHO_A 11
+#define TST_TRIGGER_B 2
+#define TST_ECHO_B 12
+
+// round trip of 1 m and 0.5 m at 20 degrees
+#define TST_ECHO_A_US 5824
+#define TST_ECHO_B_US 2912
+
+using namespace std::chrono_literals;
+
+// buses run on worker threads, so every bus has own mock pins
+static std::atomic<uint32_t> pingsA;
+static std::atomic<uint32_t> pingsB;
+static std::atomic<uint32_t> foreignPins;
+static std::atomic<uint32_t> timeReads;
+
+static uint64_t PulseInA(const void*, uint16_t port, uint8_t, uint64_t, const void*) {
+  if (TST_ECHO_A != port)
+    foreignPins++;
+  pingsA++;
+  std::this_thread::sleep_for(100us);
+  return TST_ECHO_A_US;
+}
+
+static void TriggerA(const void*, uint16_t port, uint8_t, uint64_t, const void*) {
+  if (TST_TRIGGER_A != port)
+    foreignPins++;
+}
+
+static uint64_t PulseInB(const void*, uint16_t port, uint8_t, uint64_t, const void*) {
+  if (TST_ECHO_B != port)
+    foreignPins++;
+  pingsB++;
+  std::this_thread::sleep_for(100us);
+  return TST_ECHO_B_US;
+}
+
+static void TriggerB(const void*, uint16_t port, uint8_t, uint64_t, const void*) {
+  if (TST_TRIGGER_B != port)
+    foreignPins++;
+}
+
+static uint64_t TimeUs(void) {
+  timeReads++;
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template<typename F>
+static bool WaitFor(F&& condition) {
+  for (uint32_t i = 0; i < 2000 && !condition(); i++)
+    std::this_thread::sleep_for(1ms);
+  return condition();
+}
+
+TEST_GROUP(TST_VIHCSR04ENGINE);
+
+// runner is called by main.c
+extern "C" void TEST_TST_VIHCSR04ENGINE_GROUP_RUNNER(void);
+
+TEST_GROUP_RUNNER(TST_VIHCSR04ENGINE) {
+  RUN_TEST_CASE(TST_VIHCSR04ENGINE, VIHCSR04_StartStop);
+  RUN_TEST_CASE(TST_VIHCSR04ENGINE, VIHCSR04_Commands);
+  RUN_TEST_CASE(TST_VIHCSR04ENGINE, VIHCSR04_LeftoverCommands);
+  RUN_TEST_CASE(TST_VIHCSR04ENGINE, VIHCSR04_BusIsolation);
+  RUN_TEST_CASE(TST_VIHCSR04ENGINE, VIHCSR04_Idle);
+  RUN_TEST_CASE(TST_VIHCSR04ENGINE, VIHCSR04_IdlePeriodic);
+}
+
+TEST_SETUP(TST_VIHCSR04ENGINE) {
+  pingsA = pingsB = 0;
+  foreignPins = 0;
+  timeReads = 0;
+}
+
+TEST_TEAR_DOWN(TST_VIHCSR04ENGINE) {
+}
+
+TEST(TST_VIHCSR04ENGINE, VIHCSR04_StartStop)
+{
+  printf("Test: VIHCSR04_StartStop\r\n");
+  vihcsr04::Hcsr04Engine engine;
+
+  TEST_ASSERT_FALSE(engine.Start());
+  TEST_ASSERT_EQUAL(vihcsr04::Hcsr04Engine::INVALID_BUS, engine.AddBus(PulseInA, TriggerA, 3));
+
+  auto bus = engine.AddBus(PulseInA, TriggerA, 4);
+  TEST_ASSERT_EQUAL(0, bus);
+
+  TEST_ASSERT_TRUE(engine.Start());
+  TEST_ASSERT_TRUE(engine.IsRunning());
+  TEST_ASSERT_FALSE(engine.Start());
+  // buses are added only while stopped
+  TEST_ASSERT_EQUAL(vihcsr04::Hcsr04Engine::INVALID_BUS, engine.AddBus(PulseInB, TriggerB, 4));
+
+  engine.Stop();
+  TEST_ASSERT_FALSE(engine.IsRunning());
+  engine.Stop();
+
+  // stopped engine executes commands on the calling thread
+  auto handle = engine.AddSensor(bus, "A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+  TEST_ASSERT_TRUE(std::future_status::ready == handle.wait_for(0s));
+  TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, handle.get());
+  TEST_ASSERT_FALSE(engine.Execute(bus + 1, [](vihcsr04::Hcsr04Sensor&) {}).valid());
+
+  // engine can be restarted
+  TEST_ASSERT_TRUE(engine.Start());
+  engine.Stop();
+}
+
+TEST(TST_VIHCSR04ENGINE, VIHCSR04_Commands)
+{
+  printf("Test: VIHCSR04_Commands\r\n");
+  vihcsr04::Sample_t samples[16];
+  vihcsr04::Hcsr04Engine engine;
+  auto bus = engine.AddBus(PulseInA, TriggerA, 16);
+
+  TEST_ASSERT_TRUE(engine.Start());
+
+  auto handle = engine.AddSensor(bus, "A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A).get();
+  TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, handle);
+
+  // command is executed by the worker thread
+  auto worker = engine.Execute(bus, [](vihcsr04::Hcsr04Sensor&) {
+    return std::this_thread::get_id(); });
+  TEST_ASSERT_TRUE(std::this_thread::get_id() != worker.get());
+
+  TEST_ASSERT_TRUE(engine.MeasureDistanceMmAsync(bus, handle,
+    vihcsr04::CONTINUOUS_MEASURE, 20, 400).get());
+
+  size_t count = 0;
+  TEST_ASSERT_TRUE(WaitFor([&] {
+    count += engine.DrainSamples(bus, &samples[count], 16 - count);
+    return count >= 3;
+  }));
+  TEST_ASSERT_EQUAL_UINT32(handle, samples[0].handle);
+  TEST_ASSERT_UINT32_WITHIN(1, 1000, samples[0].distanceMm);
+
+  engine.StopContinuousMeasure(bus, handle).get();
+  uint32_t pings = pingsA;
+  std::this_thread::sleep_for(5ms);
+  TEST_ASSERT_EQUAL(pings, pingsA);
+
+  TEST_ASSERT_TRUE(engine.DeleteSensor(bus, handle).get());
+  TEST_ASSERT_FALSE(engine.DeleteSensor(bus, handle).get());
+
+  engine.Stop();
+}
+
+TEST(TST_VIHCSR04ENGINE, VIHCSR04_LeftoverCommands)
+{
+  printf("Test: VIHCSR04_LeftoverCommands\r\n");
+  vihcsr04::Hcsr04Engine engine;
+  // worker sleeps after every cycle, a command posted by a command waits for the next one
+  auto bus = engine.AddBus(PulseInA, TriggerA, 0, 200ms);
+  std::future<std::thread::id> leftover;
+
+  TEST_ASSERT_TRUE(engine.Start());
+
+  engine.Execute(bus, [&](vihcsr04::Hcsr04Sensor&) {
+    leftover = engine.Execute(bus, [](vihcsr04::Hcsr04Sensor&) {
+      return std::this_thread::get_id(); });
+  }).get();
+
+  TEST_ASSERT_TRUE(leftover.valid());
+  TEST_ASSERT_TRUE(std::future_status::timeout == leftover.wait_for(0s));
+
+  // left command is executed by Stop after worker is joined
+  engine.Stop();
+  TEST_ASSERT_TRUE(std::future_status::ready == leftover.wait_for(0s));
+  TEST_ASSERT_TRUE(std::this_thread::get_id() == leftover.get());
+}
+
+TEST(TST_VIHCSR04ENGINE, VIHCSR04_BusIsolation)
+{
+  printf("Test: VIHCSR04_BusIsolation\r\n");
+  vihcsr04::Sample_t samples[32];
+  vihcsr04::Hcsr04Engine engine;
+  auto busA = engine.AddBus(PulseInA, TriggerA, 32);
+  auto busB = engine.AddBus(PulseInB, TriggerB, 32);
+  std::atomic<bool> entered{false};
+  std::atomic<bool> release{false};
+
+  TEST_ASSERT_TRUE(engine.Start());
+
+  auto a = engine.AddSensor(busA, "A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A).get();
+  auto b = engine.AddSensor(busB, "B", nullptr, TST_TRIGGER_B, nullptr, TST_ECHO_B).get();
+  engine.MeasureDistanceMmAsync(busA, a, vihcsr04::CONTINUOUS_MEASURE, 20, 400).get();
+  engine.MeasureDistanceMmAsync(busB, b, vihcsr04::CONTINUOUS_MEASURE, 20, 400).get();
+
+  // blocked worker of bus A does not stop bus B
+  auto blocked = engine.Execute(busA, [&](vihcsr04::Hcsr04Sensor&) {
+    entered = true;
+    while (!release)
+      std::this_thread::sleep_for(1ms);
+  });
+  TEST_ASSERT_TRUE(WaitFor([&] { return entered.load(); }));
+  uint32_t pings = pingsA;
+  uint32_t pingsOfB = pingsB;
+  TEST_ASSERT_TRUE(WaitFor([&] { return pingsB >= pingsOfB + 5; }));
+  TEST_ASSERT_EQUAL(pings, pingsA);
+
+  release = true;
+  blocked.get();
+  TEST_ASSERT_TRUE(WaitFor([&] { return pingsA >= pings + 5; }));
+
+  engine.Stop();
+
+  // every bus has own samples
+  size_t count = engine.DrainSamples(busA, samples, 32);
+  TEST_ASSERT_GREATER_THAN(0, count);
+  for (size_t i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT32(a, samples[i].handle);
+    TEST_ASSERT_UINT32_WITHIN(1, 1000, samples[i].distanceMm);
+  }
+
+  count = engine.DrainSamples(busB, samples, 32);
+  TEST_ASSERT_GREATER_THAN(0, count);
+  for (size_t i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT32(b, samples[i].handle);
+    TEST_ASSERT_UINT32_WITHIN(1, 500, samples[i].distanceMm);
+  }
+
+  TEST_ASSERT_EQUAL(0, foreignPins);
+  TEST_ASSERT_EQUAL(0, engine.DrainSamples(busB + 1, samples, 32));
+}
+
+TEST(TST_VIHCSR04ENGINE, VIHCSR04_Idle)
+{
+  printf("Test: VIHCSR04_Idle\r\n");
+  vihcsr04::Hcsr04Engine engine;
+  auto bus = engine.AddBus(TriggerA, TimeUs, 0);
+
+  TEST_ASSERT_TRUE(engine.Start());
+
+  // worker without measured sensors blocks instead of spinning
+  std::this_thread::sleep_for(50ms);
+  TEST_ASSERT_LESS_THAN(20, timeReads.load());
+
+  // and is woken up by commands
+  auto handle = engine.AddSensor(bus, "A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A).get();
+  TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, handle);
+
+  // sensor without echo is reported at the echo timeout, worker sleeps until then
+  std::atomic<uint32_t> reported{0};
+  static std::atomic<uint32_t>* counter;
+  counter = &reported;
+  engine.MeasureDistanceMmAsync(bus, handle, vihcsr04::ONESHOT_MEASURE, 20, 400,
+    [](uint32_t, const void*) { (*counter)++; }).get();
+  TEST_ASSERT_TRUE(WaitFor([&] { return 1 == reported; }));
+  TEST_ASSERT_LESS_THAN(200, timeReads.load());
+
+  engine.Stop();
+}
+
+TEST(TST_VIHCSR04ENGINE, VIHCSR04_IdlePeriodic)
+{
+  printf("Test: VIHCSR04_IdlePeriodic\r\n");
+  vihcsr04::Hcsr04Engine engine;
+  auto bus = engine.AddBus(PulseInA, TriggerA, 0);
+
+  TEST_ASSERT_TRUE(engine.Start());
+
+  // time source of blocking bus is set by command
+  auto handle = engine.Execute(bus, [](vihcsr04::Hcsr04Sensor& sensor) {
+    sensor.SetTimeCb(TimeUs);
+    auto handle = sensor.AddSensor("A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A);
+    sensor.SetPeriod(handle, 20000);
+    sensor.MeasureDistanceMmAsync(handle, vihcsr04::CONTINUOUS_MEASURE, 20, 400, nullptr, nullptr);
+    return handle;
+  }).get();
+  TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, handle);
+
+  // worker sleeps between periods instead of spinning until the next release
+  timeReads = 0;
+  uint32_t pings = pingsA;
+  std::this_thread::sleep_for(100ms);
+  TEST_ASSERT_UINT32_WITHIN(2, 5, pingsA - pings);
+  TEST_ASSERT_LESS_THAN(200, timeReads.load());
+
+  engine.Stop();
+}
@@ -0,0 +1,101 @@
+#include "unity.h"
+#include "unity_fixture.h"
+#include "vihcsr04_engine.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// built with -fsanitize=thread, a data race fails the test binary
+
+#define TST_TRIGGER_A 1
+#define TST_ECHO_A 11
+
+// round trip of 1 m at 20 degrees
+#define TST_ECHO_A_US 5824
+
+using namespace std::chrono_literals;
+
+static std::atomic<uint32_t> triggers;
+
+static void TriggerA(const void*, uint16_t, uint8_t, uint64_t, const void*) {
+  triggers++;
+}
+
+static uint64_t TimeUs(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TEST_GROUP(TST_VIHCSR04TSAN);
+
+// runner is called by main_tsan.c
+extern "C" void TEST_TST_VIHCSR04TSAN_GROUP_RUNNER(void);
+
+TEST_GROUP_RUNNER(TST_VIHCSR04TSAN) {
+  RUN_TEST_CASE(TST_VIHCSR04TSAN, VIHCSR04_EdgeThread);
+}
+
+TEST_SETUP(TST_VIHCSR04TSAN) {
+  triggers = 0;
+}
+
+TEST_TEAR_DOWN(TST_VIHCSR04TSAN) {
+}
+
+TEST(TST_VIHCSR04TSAN, VIHCSR04_EdgeThread)
+{
+  printf("Test: VIHCSR04_EdgeThread\r\n");
+  vihcsr04::Sample_t samples[64];
+  vihcsr04::Hcsr04Engine engine;
+  auto bus = engine.AddBus(TriggerA, TimeUs, 64);
+  std::atomic<vihcsr04::Handle_t> handle{vihcsr04::INVALID_HANDLE};
+  std::atomic<bool> done{false};
+
+  TEST_ASSERT_TRUE(engine.Start());
+
+  // gpio thread answers every trigger with an echo while the worker measures
+  std::thread gpio([&] {
+    uint32_t answered = 0;
+    while (!done) {
+      if (triggers == answered || vihcsr04::INVALID_HANDLE == handle) {
+        std::this_thread::sleep_for(100us);
+        continue;
+      }
+      answered = triggers;
+      uint64_t rise = TimeUs();
+      engine.EchoEdge(bus, handle, 1, rise);
+      std::this_thread::sleep_for(std::chrono::microseconds(TST_ECHO_A_US));
+      engine.EchoEdge(bus, handle, 0, rise + TST_ECHO_A_US);
+    }
+  });
+
+  handle = engine.AddSensor(bus, "A", nullptr, TST_TRIGGER_A, nullptr, TST_ECHO_A).get();
+  TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, handle.load());
+  TEST_ASSERT_TRUE(engine.MeasureDistanceMmAsync(bus, handle, 
+    vihcsr04::CONTINUOUS_MEASURE, 20, 400).get());
+
+  // sensors are added by commands while edges are reported
+  char name[] = "X";
+  for (uint32_t i = 0; i < 8; i++) {
+    name[0] = (char)('B' + i);
+    TEST_ASSERT_NOT_EQUAL(vihcsr04::INVALID_HANDLE, engine.AddSensor(bus, name, 
+      nullptr, (uint16_t)(20 + i), nullptr, (uint16_t)(30 + i)).get());
+  }
+
+  size_t count = 0;
+  for (uint32_t i = 0; i < 2000 && count < 5; i++) {
+    count += engine.DrainSamples(bus, &samples[count], 64 - count);
+    std::this_thread::sleep_for(1ms);
+  }
+
+  done = true;
+  gpio.join();
+  engine.Stop();
+
+  TEST_ASSERT_GREATER_OR_EQUAL(5, count);
+  for (size_t i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT32(handle.load(), samples[i].handle);
+    TEST_ASSERT_UINT32_WITHIN(1, 1000, samples[i].distanceMm);
+  }
+}